@@ -24,10 +24,12 @@
 
 // qt/kde/system includes
 #include <QtCore/QtAlgorithms>
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QMap>
+#include <QtCore/QRegExp>
 #include <QtCore/QTextStream>
 #include <QtCore/QTimer>
 #include <QtGui/QApplication>
@@ -53,6 +55,7 @@
 #include <ktemporaryfile.h>
 #include <ktoolinvocation.h>
 #include <kzip.h>
+#include <threadweaver/ThreadWeaver.h>
 
 // local includes
 #include "action.h"
@@ -78,8 +81,10 @@
 #include "sourcereference.h"
 #include "sourcereference_p.h"
 #include "texteditors_p.h"
+#include "textsearchjob_p.h"
 #include "tile.h"
 #include "tilesmanager_p.h"
+#include "utils.h"
 #include "utils_p.h"
 #include "view.h"
 #include "view_p.h"
@@ -91,16 +96,6 @@
 
 using namespace Okular;
 
-struct AllocatedPixmap
-{
-    // owner of the page
-    DocumentObserver *observer;
-    int page;
-    qulonglong memory;
-    // public constructor: initialize data
-    AllocatedPixmap( DocumentObserver *o, int p, qulonglong m ) : observer( o ), page( p ), memory( m ) {}
-};
-
 struct ArchiveData
 {
     ArchiveData()
@@ -126,6 +121,26 @@ struct RunningSearch
     bool cachedNoDialogs : 1;
     bool isCurrentlySearching : 1;
     QColor cachedColor;
+    // matches found so far by a search in the whole document
+    int matchCount;
+};
+
+// state of a search in the whole document done by TextSearchJobs
+struct AllDocumentSearch
+{
+    int searchID;
+    QString text;
+    Qt::CaseSensitivity caseSensitivity;
+    TextPage::TextComparison comparison;
+    // searched instead of text if not empty
+    QRegExp regExp;
+    QColor color;
+    // pages whose old highlights were removed
+    QSet< int > *pagesToNotify;
+    QList< QVector< Page * > > pendingChunks;
+    QList< TextSearchJob * > runningJobs;
+    int maxRunningJobs;
+    bool foundAMatch;
 };
 
 #define foreachObserver( cmd ) {\
@@ -138,6 +153,10 @@ struct RunningSearch
 
 #define OKULAR_HISTORY_MAXSTEPS 100
 #define OKULAR_HISTORY_SAVEDSTEPS 10
+// low resolution pixmaps are rendered at 1/4 of the requested size (1/16
+// of the pixels), and only for pages big enough to be slow to render
+#define OKULAR_PREVIEW_SCALE 4
+#define OKULAR_PREVIEW_MINPIXELS 500000L
 
 /***** Document ******/
 
@@ -280,6 +299,120 @@ QString DocumentPrivate::localizedSize(const QSizeF &size) const
     }
 }
 
+#if defined(Q_OS_LINUX)
+/**
+ * Returns the directory of the memory control group okular runs in, in the
+ * cgroup v1 memory hierarchy or in the unified cgroup v2 one, and whether
+ * it is a v2 one in @p unified.
+ */
+static QString memoryCgroupDir( bool *unified )
+{
+    static QString cachedDir;
+    static bool cachedUnified = false;
+    static bool cached = false;
+    if ( !cached )
+    {
+        cached = true;
+
+        QFile cgroupFile( "/proc/self/cgroup" );
+        if ( cgroupFile.open( QIODevice::ReadOnly ) )
+        {
+            // lines are "hierarchy-ID:controller-list:cgroup-path", the cgroup
+            // v2 one has no controllers
+            QString v1Path, v2Path;
+            bool hasV1 = false, hasV2 = false;
+            QTextStream readStream( &cgroupFile );
+            while ( true )
+            {
+                const QString entry = readStream.readLine();
+                if ( entry.isNull() ) break;
+                const QString controllers = entry.section( ':', 1, 1 );
+                const QString path = entry.section( ':', 2 );
+                if ( controllers.isEmpty() )
+                {
+                    hasV2 = true;
+                    v2Path = path;
+                }
+                else if ( controllers.split( ',' ).contains( "memory" ) )
+                {
+                    hasV1 = true;
+                    v1Path = path;
+                }
+            }
+
+            // without a cgroup namespace the path of the group may not be
+            // visible inside a container, where the group is mounted as root
+            if ( hasV1 )
+            {
+                const QString root = "/sys/fs/cgroup/memory";
+                cachedDir = QFile::exists( root + v1Path ) ? root + v1Path : root;
+            }
+            else if ( hasV2 )
+            {
+                const QString root = "/sys/fs/cgroup";
+                cachedDir = QFile::exists( root + v2Path ) ? root + v2Path : root;
+                cachedUnified = true;
+            }
+        }
+    }
+
+    *unified = cachedUnified;
+    return cachedDir;
+}
+
+/**
+ * Reads a memory value from a cgroup file; returns 0 if there is no value
+ * or it is "max" (no limit).
+ */
+static qulonglong readCgroupValue( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return 0;
+
+    bool ok = false;
+    const qulonglong value = file.readLine().trimmed().toULongLong( &ok );
+    return ok ? value : 0;
+}
+
+/**
+ * Returns the memory limit of the control group of okular, or 0 if there is
+ * none.
+ */
+static qulonglong cgroupMemoryLimit()
+{
+    static qulonglong cachedValue = 0;
+    static bool cached = false;
+    if ( cached )
+        return cachedValue;
+    cached = true;
+
+    bool unified = false;
+    const QString dir = memoryCgroupDir( &unified );
+    if ( dir.isEmpty() )
+        return 0;
+
+    cachedValue = readCgroupValue( dir + ( unified ? "/memory.max" : "/memory.limit_in_bytes" ) );
+    // cgroup v1 reports "no limit" as a huge number
+    if ( cachedValue >= Q_UINT64_C(0x7FFFFFFFFFFFF000) )
+        cachedValue = 0;
+    return cachedValue;
+}
+
+/**
+ * Returns the memory used by the control group of okular.
+ */
+static qulonglong cgroupMemoryUsage()
+{
+    bool unified = false;
+    const QString dir = memoryCgroupDir( &unified );
+    if ( dir.isEmpty() )
+        return 0;
+
+    return readCgroupValue( dir + ( unified ? "/memory.current" : "/memory.usage_in_bytes" ) );
+}
+#endif
+
 qulonglong DocumentPrivate::calculateMemoryToFree()
 {
     // [MEM] choose memory parameters based on configuration profile
@@ -320,9 +453,35 @@ qulonglong DocumentPrivate::calculateMemoryToFree()
     if ( clipValue > memoryToFree )
         memoryToFree = clipValue;
 
+    // [MEM] over the budget (high watermark), free down to the low watermark;
+    // the text pages and the caches of the generator count in the budget,
+    // but their own limits keep them small
+    const qulonglong budget = pixmapMemoryBudget();
+    qulonglong usedMemory = m_allocatedPixmapsTotalMemory + m_textPageCache.totalMemory();
+    if ( m_generator )
+        usedMemory += m_generator->metaData( "CacheMemoryUsage", QVariant() ).toULongLong();
+    if ( budget && usedMemory > budget )
+    {
+        const qulonglong lowWatermark = budget / 100 * SettingsCore::memoryBudgetLowWatermark();
+        memoryToFree = qMax( memoryToFree, usedMemory - lowWatermark );
+    }
+
     return memoryToFree;
 }
 
+qulonglong DocumentPrivate::pixmapMemoryBudget()
+{
+    if ( SettingsCore::memoryBudget() > 0 )
+        return Q_UINT64_C(1024) * 1024 * SettingsCore::memoryBudget();
+
+#if defined(Q_OS_LINUX)
+    // leave room for the rest of okular and the generator caches
+    return cgroupMemoryLimit() / 2;
+#else
+    return 0;
+#endif
+}
+
 void DocumentPrivate::cleanupPixmapMemory()
 {
     cleanupPixmapMemory( calculateMemoryToFree() );
@@ -368,7 +527,7 @@ void DocumentPrivate::cleanupPixmapMemory( qulonglong memoryToFree )
         // If we're still on low memory, try to free individual tiles
 
         // Store pages that weren't completely removed
-        QLinkedList< AllocatedPixmap * > pixmapsToKeep;
+        QList< AllocatedPixmap * > pixmapsToKeep;
         while ( memoryToFree > 0 )
         {
             AllocatedPixmap * p = searchLowestPriorityPixmap( false, true, m_tiledObserver );
@@ -378,16 +537,22 @@ void DocumentPrivate::cleanupPixmapMemory( qulonglong memoryToFree )
             TilesManager *tilesManager = m_pagesVector.at( p->page )->d->tilesManager();
             if ( tilesManager && tilesManager->totalMemory() > 0 )
             {
-                qulonglong memoryDiff = p->memory;
+                // start from what the tiles use now, rather than from what
+                // they used when they were last accounted
+                const qulonglong memoryBefore = tilesManager->totalMemory();
+                m_allocatedPixmapsTotalMemory += memoryBefore;
+                m_allocatedPixmapsTotalMemory -= p->memory;
+
                 NormalizedRect visibleRect;
                 if ( visibleRects.contains( p->page ) )
                     visibleRect = visibleRects[ p->page ]->rect;
 
                 // Free non visible tiles
-                tilesManager->cleanupPixmapMemory( memoryToFree, visibleRect, currentViewportPage );
+                tilesManager->cleanupPixmapMemory( memoryToFree, visibleRect, currentViewportPage, SettingsCore::compressTiles() );
 
+                // the cleanup only compresses or deletes tiles, so it can't grow
                 p->memory = tilesManager->totalMemory();
-                memoryDiff -= p->memory;
+                const qulonglong memoryDiff = memoryBefore - p->memory;
                 memoryToFree = (memoryDiff < memoryToFree) ? (memoryToFree - memoryDiff) : 0;
                 m_allocatedPixmapsTotalMemory -= memoryDiff;
 
@@ -400,7 +565,8 @@ void DocumentPrivate::cleanupPixmapMemory( qulonglong memoryToFree )
                 pixmapsToKeep.append( p );
         }
 
-        m_allocatedPixmaps += pixmapsToKeep;
+        foreach ( AllocatedPixmap *p, pixmapsToKeep )
+            m_allocatedPixmaps.insert( p );
         //p--rintf("freeMemory A:[%d -%d = %d] \n", m_allocatedPixmaps.count() + pagesFreed, pagesFreed, m_allocatedPixmaps.count() );
     }
 }
@@ -412,36 +578,17 @@ void DocumentPrivate::cleanupPixmapMemory( qulonglong memoryToFree )
  */
 AllocatedPixmap * DocumentPrivate::searchLowestPriorityPixmap( bool unloadableOnly, bool thenRemoveIt, DocumentObserver *observer )
 {
-    QLinkedList< AllocatedPixmap * >::iterator pIt = m_allocatedPixmaps.begin();
-    QLinkedList< AllocatedPixmap * >::iterator pEnd = m_allocatedPixmaps.end();
-    QLinkedList< AllocatedPixmap * >::iterator farthestPixmap = pEnd;
     const int currentViewportPage = (*m_viewportIterator).pageNumber;
 
     /* Find the pixmap that is farthest from the current viewport */
-    int maxDistance = -1;
-    while ( pIt != pEnd )
-    {
-        const AllocatedPixmap * p = *pIt;
-        // Filter by observer
-        if ( observer == 0 || p->observer == observer )
-        {
-            const int distance = qAbs( p->page - currentViewportPage );
-            if ( maxDistance < distance && ( !unloadableOnly || p->observer->canUnloadPixmap( p->page ) ) )
-            {
-                maxDistance = distance;
-                farthestPixmap = pIt;
-            }
-        }
-        ++pIt;
-    }
+    AllocatedPixmap * selectedPixmap = m_allocatedPixmaps.farthestFrom( currentViewportPage, unloadableOnly, observer );
 
     /* No pixmap to remove */
-    if ( farthestPixmap == pEnd )
+    if ( !selectedPixmap )
         return 0;
 
-    AllocatedPixmap * selectedPixmap = *farthestPixmap;
     if ( thenRemoveIt )
-        m_allocatedPixmaps.erase( farthestPixmap );
+        m_allocatedPixmaps.take( selectedPixmap->observer, selectedPixmap->page );
     return selectedPixmap;
 }
 
@@ -463,7 +610,14 @@ qulonglong DocumentPrivate::getTotalMemory()
         QString entry = readStream.readLine();
         if ( entry.isNull() ) break;
         if ( entry.startsWith( "MemTotal:" ) )
-            return (cachedValue = (Q_UINT64_C(1024) * entry.section( ' ', -2, -2 ).toULongLong()));
+        {
+            cachedValue = Q_UINT64_C(1024) * entry.section( ' ', -2, -2 ).toULongLong();
+            // inside a container the limit of its control group is what matters
+            const qulonglong cgroupLimit = cgroupMemoryLimit();
+            if ( cgroupLimit && cgroupLimit < cachedValue )
+                cachedValue = cgroupLimit;
+            return cachedValue;
+        }
     }
 #elif defined(Q_OS_FREEBSD)
     qulonglong physmem;
@@ -548,9 +702,19 @@ qulonglong DocumentPrivate::getFreeMemory( qulonglong *freeSwap )
 
     lastUpdate = QTime::currentTime();
 
+    cachedValue = Q_UINT64_C(1024) * memoryFree;
+    // the host may have plenty of free memory while our control group
+    // is close to its limit
+    const qulonglong cgroupLimit = cgroupMemoryLimit();
+    if ( cgroupLimit )
+    {
+        const qulonglong cgroupUsage = cgroupMemoryUsage();
+        cachedValue = qMin( cachedValue, cgroupUsage < cgroupLimit ? cgroupLimit - cgroupUsage : Q_UINT64_C(0) );
+    }
+
     if (freeSwap)
         *freeSwap = ( cachedFreeSwap = (Q_UINT64_C(1024) * values[3]) );
-    return ( cachedValue = (Q_UINT64_C(1024) * memoryFree) );
+    return cachedValue;
 #elif defined(Q_OS_FREEBSD)
     qulonglong cache, inact, free, psize;
     size_t cachelen, inactlen, freelen, psizelen;
@@ -1274,12 +1438,29 @@ void DocumentPrivate::saveDocumentInfo() const
 
 void DocumentPrivate::slotTimedMemoryCheck()
 {
-    // [MEM] clean memory (for 'free mem dependant' profiles only)
-    if ( SettingsCore::memoryLevel() != SettingsCore::EnumMemoryLevel::Low &&
+    // [MEM] clean memory (for 'free mem dependant' profiles, and whenever
+    // there is a budget to respect)
+    if ( ( SettingsCore::memoryLevel() != SettingsCore::EnumMemoryLevel::Low || pixmapMemoryBudget() ) &&
          m_allocatedPixmapsTotalMemory > 1024*1024 )
         cleanupPixmapMemory();
 }
 
+// Whether the request is for a page big enough to be worth rendering in
+// tiles, and mostly out of the viewport: rendering the visible tiles first
+// is much faster than rendering all of it
+static bool isPartiallyVisibleRequest( const PixmapRequest *r )
+{
+    const uint partialRenderPixels = SettingsCore::partialRenderPixels();
+    if ( partialRenderPixels == 0 || r->preload() || r->isTile() || (long)r->width() * (long)r->height() <= (long)partialRenderPixels )
+        return false;
+
+    const NormalizedRect &visibleRect = r->normalizedRect();
+    if ( visibleRect.isNull() )
+        return false;
+
+    return ( visibleRect.right - visibleRect.left ) * ( visibleRect.bottom - visibleRect.top ) < 0.5;
+}
+
 void DocumentPrivate::sendGeneratorPixmapRequest()
 {
     /* If the pixmap cache will have to be cleaned in order to make room for the
@@ -1299,39 +1480,60 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
     // find a request
     PixmapRequest * request = 0;
     m_pixmapRequestsMutex.lock();
-    while ( !m_pixmapRequestsStack.isEmpty() && !request )
+
+    // preloads being rendered that would be evicted right away are not
+    // worth finishing
+    if ( maxDistance != INT_MAX )
     {
-        PixmapRequest * r = m_pixmapRequestsStack.last();
-        if (!r)
+        foreach ( PixmapRequest *r, m_executingPixmapRequests )
         {
-            m_pixmapRequestsStack.pop_back();
-            continue;
+            if ( r->asynchronous() && r->preload() && qAbs( r->pageNumber() - currentViewportPage ) >= maxDistance )
+                r->d->abortRender();
         }
+    }
+
+    while ( !m_pixmapRequestsQueue.isEmpty() && !request )
+    {
+        PixmapRequest * r = m_pixmapRequestsQueue.top();
 
         QRect requestRect = r->isTile() ? r->normalizedRect().geometry( r->width(), r->height() ) : QRect( 0, 0, r->width(), r->height() );
         TilesManager *tilesManager = ( r->observer() == m_tiledObserver ) ? r->page()->d->tilesManager() : 0;
 
+        // a page tiled because partially visible is tiled for its size once zoomed enough
+        if ( tilesManager && tilesManager->isPartialRendering() && (long)r->width() * (long)r->height() > (long)SettingsCore::tilesStartPixels() )
+            tilesManager->setPartialRendering( false );
+
         // request only if page isn't already present and request has valid id
         if ( ( !r->d->mForce && r->page()->hasPixmap( r->observer(), r->width(), r->height(), r->normalizedRect() ) ) || !m_observers.contains(r->observer()) )
         {
-            m_pixmapRequestsStack.pop_back();
+            m_pixmapRequestsQueue.remove( r );
+            delete r;
+        }
+        // the page got a real pixmap in the meantime
+        else if ( r->d->isObsoletePreview() )
+        {
+            m_pixmapRequestsQueue.remove( r );
             delete r;
         }
         else if ( !r->d->mForce && r->preload() && qAbs( r->pageNumber() - currentViewportPage ) >= maxDistance )
         {
-            m_pixmapRequestsStack.pop_back();
+            m_pixmapRequestsQueue.remove( r );
             //kDebug() << "Ignoring request that doesn't fit in cache";
             delete r;
         }
         // Ignore requests for pixmaps that are already being generated
         else if ( tilesManager && tilesManager->isRequesting( r->normalizedRect(), r->width(), r->height() ) )
         {
-            m_pixmapRequestsStack.pop_back();
+            m_pixmapRequestsQueue.remove( r );
             delete r;
         }
-        // If the requested area is above 8000000 pixels, switch on the tile manager
-        else if ( !tilesManager && r->observer() == m_tiledObserver && m_generator->hasFeature( Generator::TiledRendering ) && (long)r->width() * (long)r->height() > 8000000L )
+        // If the requested area is above TilesStartPixels pixels, or if only a
+        // small part of a big page is visible, switch on the tile manager
+        else if ( !tilesManager && r->observer() == m_tiledObserver && m_generator->hasFeature( Generator::TiledRendering ) &&
+                  ( (long)r->width() * (long)r->height() > (long)SettingsCore::tilesStartPixels() || isPartiallyVisibleRequest( r ) ) )
         {
+            const bool partial = (long)r->width() * (long)r->height() <= (long)SettingsCore::tilesStartPixels();
+
             // if the image is too big. start using tiles
             kDebug(OkularDebug).nospace() << "Start using tiles on page " << r->pageNumber()
                 << " (" << r->width() << "x" << r->height() << " px);";
@@ -1349,7 +1551,7 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
                 // create new tiles manager
                 tilesManager = new TilesManager( r->pageNumber(), r->width(), r->height(), r->page()->rotation() );
             }
-            tilesManager->setRequest( r->normalizedRect(), r->width(), r->height() );
+            tilesManager->setPartialRendering( partial );
             r->page()->deletePixmap( r->observer() );
             r->page()->d->setTilesManager( tilesManager );
             r->setTile( true );
@@ -1381,12 +1583,16 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
                 // preload requests issued by PageView if the requested page is
                 // not visible and the user has just switched from a non-tiled
                 // zoom level to a tiled one
-                m_pixmapRequestsStack.pop_back();
+                m_pixmapRequestsQueue.remove( r );
                 delete r;
             }
         }
-        // If the requested area is below 6000000 pixels, switch off the tile manager
-        else if ( tilesManager && (long)r->width() * (long)r->height() < 6000000L )
+        // If the requested area is below TilesStopPixels pixels, switch off the tile manager;
+        // the pages tiled because partially visible keep the tiles until they get smaller
+        // than PartialRenderPixels, not to switch back and forth while scrolling
+        else if ( tilesManager && (long)r->width() * (long)r->height() < (long)SettingsCore::tilesStopPixels() &&
+                  ( !tilesManager->isPartialRendering() || SettingsCore::partialRenderPixels() == 0 ||
+                    (long)r->width() * (long)r->height() <= (long)SettingsCore::partialRenderPixels() ) )
         {
             kDebug(OkularDebug).nospace() << "Stop using tiles on page " << r->pageNumber()
                 << " (" << r->width() << "x" << r->height() << " px);";
@@ -1399,7 +1605,7 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
         }
         else if ( (long)requestRect.width() * (long)requestRect.height() > 20000000L )
         {
-            m_pixmapRequestsStack.pop_back();
+            m_pixmapRequestsQueue.remove( r );
             if ( !m_warnedOutOfMemory )
             {
                 kWarning(OkularDebug).nospace() << "Running out of memory on page " << r->pageNumber()
@@ -1438,10 +1644,19 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
     {
         QRect requestRect = !request->isTile() ? QRect(0, 0, request->width(), request->height() ) : request->normalizedRect().geometry( request->width(), request->height() );
         kDebug(OkularDebug).nospace() << "sending request observer=" << request->observer() << " " <<requestRect.width() << "x" << requestRect.height() << "@" << request->pageNumber() << " async == " << request->asynchronous() << " isTile == " << request->isTile();
-        m_pixmapRequestsStack.removeAll ( request );
+        m_pixmapRequestsQueue.remove( request );
 
         if ( tm )
-            tm->setRequest( request->normalizedRect(), request->width(), request->height() );
+        {
+            tm->addRequest( request->normalizedRect(), request->width(), request->height() );
+
+            // size the tiles after the visible part of the page
+            foreach ( VisiblePageRect *rect, m_pageRects )
+            {
+                if ( rect->pageNumber == request->pageNumber() )
+                    tm->adaptTileSize( rect->rect );
+            }
+        }
 
         if ( (int)m_rotation % 2 )
             request->d->swap();
@@ -1455,7 +1670,30 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
         // we can not really know if the generator can do async requests
         m_executingPixmapRequests.push_back( request );
         m_pixmapRequestsMutex.unlock();
-        m_generator->generatePixmap( request );
+        const bool asynchronous = request->asynchronous();
+        request->d->mTimes.dispatched = RenderStatistics::timestamp();
+        // a pixmap rendered for another observer, or in a previous session,
+        // saves the generator the work; the rendering threads read the
+        // pages of the previous sessions themselves, off the GUI thread
+        const bool renderedInThread = asynchronous && m_generator->hasFeature( Generator::Threaded );
+        if ( loadSharedPixmap( request ) || ( !renderedInThread && loadCachedPixmap( request ) ) )
+        {
+            request->d->mTimes.rendered = RenderStatistics::timestamp();
+            requestDone( request );
+        }
+        else
+            m_generator->generatePixmap( request );
+
+        // a generator rendering in parallel may still have idle threads:
+        // feed them with the next pending requests
+        if ( asynchronous && m_generator->canGeneratePixmap() )
+        {
+            m_pixmapRequestsMutex.lock();
+            const bool hasPixmaps = !m_pixmapRequestsQueue.isEmpty();
+            m_pixmapRequestsMutex.unlock();
+            if ( hasPixmaps )
+                QMetaObject::invokeMethod( m_parent, "sendGeneratorPixmapRequest", Qt::QueuedConnection );
+        }
     }
     else
     {
@@ -1513,6 +1751,11 @@ void DocumentPrivate::slotGeneratorConfigChanged( const QString& )
                 configchanged = true;
         }
     }
+    // the cached pixmaps were rendered with the old settings
+    if ( configchanged )
+        d->m_pageDiskCache.clear();
+    d->m_pageDiskCacheSettings = d->pixmapCacheSettings();
+
     if ( configchanged )
     {
         // invalidate pixmaps
@@ -1522,7 +1765,6 @@ void DocumentPrivate::slotGeneratorConfigChanged( const QString& )
         }
 
         // [MEM] remove allocation descriptors
-        qDeleteAll( m_allocatedPixmaps );
         m_allocatedPixmaps.clear();
         m_allocatedPixmapsTotalMemory = 0;
 
@@ -1542,6 +1784,9 @@ void DocumentPrivate::refreshPixmaps( int pageNumber )
     if ( !page )
         return;
 
+    // the page looks different now, e.g. an annotation changed
+    m_pageDiskCache.removePage( pageNumber );
+
     QLinkedList< Okular::PixmapRequest * > requestedPixmaps;
     QMap< DocumentObserver*, PagePrivate::PixmapObject >::ConstIterator it = page->d->m_pixmaps.constBegin(), itEnd = page->d->m_pixmaps.constEnd();
     for ( ; it != itEnd; ++it )
@@ -1597,12 +1842,9 @@ void DocumentPrivate::refreshPixmaps( int pageNumber )
 void DocumentPrivate::_o_configChanged()
 {
     // free text pages if needed
-    calculateMaxTextPages();
-    while (m_allocatedTextPagesFifo.count() > m_maxAllocatedTextPages)
-    {
-        int pageToKick = m_allocatedTextPagesFifo.takeFirst();
+    calculateMaxTextPageMemory();
+    foreach ( int pageToKick, m_textPageCache.evict() )
         m_pagesVector.at(pageToKick)->setTextPage( 0 ); // deletes the textpage
-    }
 }
 
 void DocumentPrivate::doContinueDirectionMatchSearch(void *doContinueDirectionMatchSearchStruct)
@@ -1646,12 +1888,19 @@ void DocumentPrivate::doContinueDirectionMatchSearch(void *doContinueDirectionMa
     {
         // get page
         Page * page = m_pagesVector[ searchStruct->currentPage ];
-        // request search page if needed
-        if ( !page->hasTextPage() )
+        // the pages the index excludes do not need their text
+        if ( !m_textIndex.mayContain( page->number(), searchStruct->text ) )
+        {
+            searchStruct->match = 0;
+        }
+        else
+        {
+            // request search page if needed (or mark it as used)
             m_parent->requestTextPage( page->number() );
 
-        // if found a match on the current page, end the loop
-        searchStruct->match = page->findText( searchStruct->searchID, searchStruct->text, searchStruct->forward ? FromTop : FromBottom, searchStruct->caseSensitivity );
+            // if found a match on the current page, end the loop
+            searchStruct->match = page->findText( searchStruct->searchID, searchStruct->text, searchStruct->forward ? FromTop : FromBottom, searchStruct->caseSensitivity );
+        }
 
         if ( !searchStruct->match )
         {
@@ -1724,24 +1973,38 @@ void DocumentPrivate::doProcessSearchMatch( RegularAreaRect *match, RunningSearc
     delete pagesToNotify;
 }
 
-void DocumentPrivate::doContinueAllDocumentSearch(void *pagesToNotifySet, void *pageMatchesMap, int currentPage, int searchID, const QString & text, int theCaseSensitivity, const QColor & color)
+void DocumentPrivate::reportSearchMatches( int searchID, RunningSearch *search, int pageNumber, int matches, const RegularAreaRect &firstMatch )
+{
+    const bool firstHit = search->matchCount == 0;
+    search->matchCount += matches;
+
+    // show the first match at once, without waiting for the rest of the document
+    if ( firstHit && search->cachedViewportMove )
+    {
+        DocumentViewport searchViewport( pageNumber );
+        searchViewport.rePos.enabled = true;
+        searchViewport.rePos.normalizedX = (firstMatch.first().left + firstMatch.first().right) / 2.0;
+        searchViewport.rePos.normalizedY = (firstMatch.first().top + firstMatch.first().bottom) / 2.0;
+        m_parent->setViewport( searchViewport, 0, true );
+    }
+
+    emit m_parent->searchMatchesFound( searchID, pageNumber, matches, search->matchCount );
+}
+
+void DocumentPrivate::doContinueAllDocumentSearch(void *pagesToNotifySet, int currentPage, int searchID, const QString & text, int theCaseSensitivity, int theComparison, const QRegExp & regExp, const QColor & color)
 {
-    QMap< Page *, QVector<RegularAreaRect *> > *pageMatches = static_cast< QMap< Page *, QVector<RegularAreaRect *> > * >(pageMatchesMap);
     Qt::CaseSensitivity caseSensitivity = static_cast<Qt::CaseSensitivity>(theCaseSensitivity);
+    TextPage::TextComparison comparison = static_cast<TextPage::TextComparison>(theComparison);
     QSet< int > *pagesToNotify = static_cast< QSet< int > * >( pagesToNotifySet );
     RunningSearch *search = m_searches.value(searchID);
 
     if (m_searchCancelled || !search)
     {
-        typedef QVector<RegularAreaRect *> MatchesVector;
-
         QApplication::restoreOverrideCursor();
 
         if (search) search->isCurrentlySearching = false;
 
         emit m_parent->searchFinished( searchID, Document::SearchCancelled );
-        foreach(const MatchesVector &mv, *pageMatches) qDeleteAll(mv);
-        delete pageMatches;
         delete pagesToNotify;
         return;
     }
@@ -1752,28 +2015,45 @@ void DocumentPrivate::doContinueAllDocumentSearch(void *pagesToNotifySet, void *
         Page *page = m_pagesVector.at(currentPage);
         int pageNumber = page->number(); // redundant? is it == currentPage ?
 
-        // request search page if needed
-        if ( !page->hasTextPage() )
-            m_parent->requestTextPage( pageNumber );
+        // request search page if needed (or mark it as used)
+        m_parent->requestTextPage( pageNumber );
 
         // loop on a page adding highlights for all found items
+        QVector<RegularAreaRect *> matches;
         RegularAreaRect * lastMatch = 0;
         while ( 1 )
         {
-            if ( lastMatch )
-                lastMatch = page->findText( searchID, text, NextResult, caseSensitivity, lastMatch );
+            const SearchDirection direction = lastMatch ? NextResult : FromTop;
+            if ( !regExp.isEmpty() )
+                lastMatch = page->findText( searchID, regExp, direction, lastMatch );
             else
-                lastMatch = page->findText( searchID, text, FromTop, caseSensitivity );
+                lastMatch = page->findText( searchID, text, direction, caseSensitivity, comparison, lastMatch );
 
             if ( !lastMatch )
                 break;
 
-            // add highligh rect to the matches map
-            (*pageMatches)[page].append(lastMatch);
+            matches.append(lastMatch);
         }
         delete lastMatch;
+        textPageMemoryChanged( page );
 
-        QMetaObject::invokeMethod(m_parent, "doContinueAllDocumentSearch", Qt::QueuedConnection, Q_ARG(void *, pagesToNotifySet), Q_ARG(void *, pageMatches), Q_ARG(int, currentPage + 1), Q_ARG(int, searchID), Q_ARG(QString, text), Q_ARG(int, caseSensitivity), Q_ARG(QColor, color));
+        // show the matches of the page at once, instead of at the end of the search
+        if ( !matches.isEmpty() )
+        {
+            const RegularAreaRect firstMatch = *matches.first();
+            foreach(RegularAreaRect *match, matches)
+            {
+                page->d->setHighlight( searchID, match, color );
+                delete match;
+            }
+            search->highlightedPages.insert( pageNumber );
+            pagesToNotify->remove( pageNumber );
+            foreach(DocumentObserver *observer, m_observers)
+                observer->notifyPageChanged( pageNumber, DocumentObserver::Highlights );
+            reportSearchMatches( searchID, search, pageNumber, matches.count(), firstMatch );
+        }
+
+        QMetaObject::invokeMethod(m_parent, "doContinueAllDocumentSearch", Qt::QueuedConnection, Q_ARG(void *, pagesToNotifySet), Q_ARG(int, currentPage + 1), Q_ARG(int, searchID), Q_ARG(QString, text), Q_ARG(int, caseSensitivity), Q_ARG(int, comparison), Q_ARG(QRegExp, regExp), Q_ARG(QColor, color));
     }
     else
     {
@@ -1781,25 +2061,12 @@ void DocumentPrivate::doContinueAllDocumentSearch(void *pagesToNotifySet, void *
         QApplication::restoreOverrideCursor();
 
         search->isCurrentlySearching = false;
-        bool foundAMatch = pageMatches->count() != 0;
-        QMap< Page *, QVector<RegularAreaRect *> >::const_iterator it, itEnd;
-        it = pageMatches->constBegin();
-        itEnd = pageMatches->constEnd();
-        for ( ; it != itEnd; ++it)
-        {
-            foreach(RegularAreaRect *match, it.value())
-            {
-                it.key()->d->setHighlight( searchID, match, color );
-                delete match;
-            }
-            search->highlightedPages.insert( it.key()->number() );
-            pagesToNotify->insert( it.key()->number() );
-        }
+        bool foundAMatch = search->matchCount != 0;
 
         foreach(DocumentObserver *observer, m_observers)
             observer->notifySetup( m_pagesVector, 0 );
 
-        // notify observers about highlights changes
+        // notify observers about the highlights removed
         foreach(int pageNumber, *pagesToNotify)
             foreach(DocumentObserver *observer, m_observers)
                 observer->notifyPageChanged( pageNumber, DocumentObserver::Highlights );
@@ -1807,34 +2074,321 @@ void DocumentPrivate::doContinueAllDocumentSearch(void *pagesToNotifySet, void *
         if (foundAMatch) emit m_parent->searchFinished(searchID, Document::MatchFound );
         else emit m_parent->searchFinished( searchID, Document::NoMatchFound );
 
-        delete pageMatches;
         delete pagesToNotify;
     }
 }
 
-void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, void *pageMatchesMap, int currentPage, int searchID, const QStringList & words, int theCaseSensitivity, const QColor & color, bool matchAll)
+void DocumentPrivate::startAllDocumentSearch( int searchID, QSet< int > *pagesToNotify, const QString & text, Qt::CaseSensitivity caseSensitivity, TextPage::TextComparison comparison, const QRegExp & regExp, const QColor & color )
+{
+    // only one search at a time in the worker threads
+    if ( m_allDocumentSearch )
+        finishAllDocumentSearch( Document::SearchCancelled );
+
+    AllDocumentSearch *search = new AllDocumentSearch;
+    search->searchID = searchID;
+    search->text = text;
+    search->caseSensitivity = caseSensitivity;
+    search->comparison = comparison;
+    search->regExp = regExp;
+    search->color = color;
+    search->pagesToNotify = pagesToNotify;
+    search->foundAMatch = false;
+
+    // the text of the pages can be extracted in parallel only if the
+    // generator can work in several threads at once, but even a single job
+    // keeps the GUI responsive
+    search->maxRunningJobs = m_generator->hasFeature( Generator::ThreadSafe ) ? qMax( 1, QThread::idealThreadCount() ) : 1;
+
+    // only the pages that may contain the text according to the index,
+    // that knows nothing about regular expressions nor accents
+    const bool useIndex = regExp.isEmpty() && comparison == TextPage::ExactComparison;
+    QVector< Page * > pages;
+    foreach ( Page *page, m_pagesVector )
+    {
+        if ( !useIndex || m_textIndex.mayContain( page->number(), text ) )
+            pages.append( page );
+    }
+
+    // small chunks, so that the matches show up progressively
+    const int pageCount = pages.count();
+    const int chunkSize = qBound( 1, pageCount / ( search->maxRunningJobs * 8 ), 32 );
+    for ( int first = 0; first < pageCount; first += chunkSize )
+        search->pendingChunks.append( pages.mid( first, chunkSize ) );
+
+    m_allDocumentSearch = search;
+    startTextSearchJobs();
+}
+
+void DocumentPrivate::startTextSearchJobs()
+{
+    // the jobs of a cancelled search are still using the generator, the
+    // search goes on when they are done
+    if ( !m_cancelledTextSearchJobs.isEmpty() )
+        return;
+
+    AllDocumentSearch *search = m_allDocumentSearch;
+    while ( search->runningJobs.count() < search->maxRunningJobs && !search->pendingChunks.isEmpty() )
+    {
+        TextSearchJob *job = new TextSearchJob( m_generator, search->pendingChunks.takeFirst(), search->searchID, search->text, search->caseSensitivity, search->comparison, search->regExp );
+        QObject::connect( job, SIGNAL(done(ThreadWeaver::Job*)), m_parent, SLOT(textSearchJobDone(ThreadWeaver::Job*)), Qt::QueuedConnection );
+        search->runningJobs.append( job );
+        ThreadWeaver::Weaver::instance()->enqueue( job );
+    }
+
+    if ( search->runningJobs.isEmpty() )
+        finishAllDocumentSearch( search->foundAMatch ? Document::MatchFound : Document::NoMatchFound );
+}
+
+void DocumentPrivate::textSearchJobDone( ThreadWeaver::Job *j )
+{
+    TextSearchJob *job = static_cast< TextSearchJob * >( j );
+
+    // the job may belong to a search that was cancelled in the meanwhile,
+    // whose jobs the next search waits for
+    if ( m_cancelledTextSearchJobs.removeOne( job ) )
+    {
+        job->deleteLater();
+        if ( m_cancelledTextSearchJobs.isEmpty() && m_allDocumentSearch )
+            startTextSearchJobs();
+        return;
+    }
+
+    // or to a search that was stopped, which already deleted it
+    if ( !m_allDocumentSearch || !m_allDocumentSearch->runningJobs.removeOne( job ) )
+        return;
+
+    job->deleteLater();
+
+    AllDocumentSearch *search = m_allDocumentSearch;
+    RunningSearch *runningSearch = m_searches.value( search->searchID );
+    if ( m_searchCancelled || !runningSearch )
+    {
+        finishAllDocumentSearch( Document::SearchCancelled );
+        return;
+    }
+
+    QMap< Page *, QVector< RegularAreaRect * > > pageMatches;
+    foreach ( const TextSearchJob::Result &result, job->takeResults() )
+    {
+        pageMatches[ result.page ] = result.matches;
+
+        // keep the extracted text, it is likely to be needed again soon
+        if ( !result.page->hasTextPage() )
+        {
+            m_textPageCache.use( result.page->number() ); // counts the miss
+            result.page->d->setPreparedTextPage( result.textPage );
+            textGenerationDone( result.page );
+        }
+        else
+            delete result.textPage;
+    }
+
+    // the pages that had their text already are searched here, as it is
+    // not safe to use their text in the job
+    const QVector< Page * > pages = job->pages();
+    for ( int i = 0; i < pages.count(); ++i )
+    {
+        if ( job->isExtracting( i ) )
+            continue;
+
+        Page *page = pages.at( i );
+        m_parent->requestTextPage( page->number() );
+
+        RegularAreaRect *lastMatch = 0;
+        while ( ( lastMatch = search->regExp.isEmpty()
+                              ? page->findText( search->searchID, search->text, lastMatch ? NextResult : FromTop, search->caseSensitivity, search->comparison, lastMatch )
+                              : page->findText( search->searchID, search->regExp, lastMatch ? NextResult : FromTop, lastMatch ) ) )
+            pageMatches[ page ].append( lastMatch );
+        textPageMemoryChanged( page );
+    }
+
+    // show the matches found so far
+    QMap< Page *, QVector< RegularAreaRect * > >::const_iterator it = pageMatches.constBegin(), itEnd = pageMatches.constEnd();
+    for ( ; it != itEnd; ++it )
+    {
+        if ( it.value().isEmpty() )
+            continue;
+
+        const RegularAreaRect firstMatch = *it.value().first();
+        foreach ( RegularAreaRect *match, it.value() )
+        {
+            it.key()->d->setHighlight( search->searchID, match, search->color );
+            delete match;
+        }
+        const int pageNumber = it.key()->number();
+        runningSearch->highlightedPages.insert( pageNumber );
+        search->pagesToNotify->remove( pageNumber );
+        search->foundAMatch = true;
+        foreachObserverD( notifyPageChanged( pageNumber, DocumentObserver::Highlights ) );
+        reportSearchMatches( search->searchID, runningSearch, pageNumber, it.value().count(), firstMatch );
+    }
+
+    startTextSearchJobs();
+}
+
+void DocumentPrivate::finishAllDocumentSearch( Document::SearchStatus status )
+{
+    AllDocumentSearch *search = m_allDocumentSearch;
+    m_allDocumentSearch = 0;
+
+    // the jobs not started yet can go, the running ones are kept until they
+    // notice they are cancelled
+    foreach ( TextSearchJob *job, search->runningJobs )
+    {
+        if ( ThreadWeaver::Weaver::instance()->dequeue( job ) )
+        {
+            delete job;
+            continue;
+        }
+        job->cancel();
+        m_cancelledTextSearchJobs.append( job );
+    }
+
+    // reset cursor to previous shape
+    QApplication::restoreOverrideCursor();
+
+    RunningSearch *runningSearch = m_searches.value( search->searchID );
+    if ( runningSearch )
+        runningSearch->isCurrentlySearching = false;
+
+    if ( status != Document::SearchCancelled )
+    {
+        foreach(DocumentObserver *observer, m_observers)
+            observer->notifySetup( m_pagesVector, 0 );
+
+        // notify observers about the highlights removed
+        foreach(int pageNumber, *search->pagesToNotify)
+            foreach(DocumentObserver *observer, m_observers)
+                observer->notifyPageChanged( pageNumber, DocumentObserver::Highlights );
+    }
+
+    emit m_parent->searchFinished( search->searchID, status );
+
+    delete search->pagesToNotify;
+    delete search;
+}
+
+/**
+ * Removes the @p jobs from the queue of the weaver, and waits for those
+ * already running; Weaver::finish() would also wait for the jobs of the
+ * other documents.
+ */
+static void waitForJobs( const QList< ThreadWeaver::Job * > &jobs )
+{
+    QEventLoop loop;
+    QList< ThreadWeaver::Job * > runningJobs;
+    foreach ( ThreadWeaver::Job *job, jobs )
+    {
+        if ( ThreadWeaver::Weaver::instance()->dequeue( job ) )
+            continue;
+
+        // connected before checking, not to miss the end of the job
+        QObject::connect( job, SIGNAL(done(ThreadWeaver::Job*)), &loop, SLOT(quit()), Qt::QueuedConnection );
+        runningJobs.append( job );
+    }
+
+    while ( true )
+    {
+        bool running = false;
+        foreach ( ThreadWeaver::Job *job, runningJobs )
+            running = running || !job->isFinished();
+        if ( !running )
+            break;
+        loop.exec( QEventLoop::ExcludeUserInputEvents );
+    }
+}
+
+void DocumentPrivate::stopAllDocumentSearch()
+{
+    QList< TextSearchJob * > searchJobs = m_cancelledTextSearchJobs;
+    m_cancelledTextSearchJobs.clear();
+
+    if ( m_allDocumentSearch )
+    {
+        AllDocumentSearch *search = m_allDocumentSearch;
+        m_allDocumentSearch = 0;
+
+        foreach ( TextSearchJob *job, search->runningJobs )
+        {
+            job->cancel();
+            searchJobs.append( job );
+        }
+
+        QApplication::restoreOverrideCursor();
+        delete search->pagesToNotify;
+        delete search;
+    }
+
+    // the jobs use the pages, wait for them, cancelled searches' ones
+    // included, before these go away; textSearchJobDone() ignores them from
+    // now on
+    QList< ThreadWeaver::Job * > jobs;
+    foreach ( TextSearchJob *job, searchJobs )
+        jobs.append( job );
+    waitForJobs( jobs );
+    foreach ( TextSearchJob *job, searchJobs )
+        job->deleteLater();
+}
+
+void DocumentPrivate::startTextIndex( const QString &docFile )
+{
+    const QString key = PageDiskCache::documentKey( docFile, m_generatorName );
+    if ( key.isEmpty() )
+        return;
+
+    // next to the document info file, "<size>.<name>.xml"
+    QString indexFileName = m_xmlFileName;
+    indexFileName.chop( 4 );
+    indexFileName += ".index";
+    if ( m_textIndex.load( indexFileName, key, m_pagesVector.count() ) )
+        return;
+
+    m_textIndexJob = new TextIndexJob( m_generator, m_pagesVector, indexFileName, key );
+    QObject::connect( m_textIndexJob, SIGNAL(done(ThreadWeaver::Job*)), m_parent, SLOT(textIndexJobDone(ThreadWeaver::Job*)), Qt::QueuedConnection );
+    ThreadWeaver::Weaver::instance()->enqueue( m_textIndexJob );
+}
+
+void DocumentPrivate::textIndexJobDone( ThreadWeaver::Job *j )
+{
+    TextIndexJob *job = static_cast< TextIndexJob * >( j );
+    job->deleteLater();
+
+    // the job may belong to a document closed in the meanwhile
+    if ( job != m_textIndexJob )
+        return;
+
+    m_textIndexJob = 0;
+    if ( job->isComplete() )
+        m_textIndex = job->index();
+}
+
+void DocumentPrivate::stopTextIndex()
+{
+    if ( m_textIndexJob )
+    {
+        // the job uses the pages, wait for it before these go away
+        m_textIndexJob->cancel();
+        waitForJobs( QList< ThreadWeaver::Job * >() << m_textIndexJob );
+        m_textIndexJob->deleteLater();
+        m_textIndexJob = 0;
+    }
+    m_textIndex.clear();
+}
+
+void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, int currentPage, int searchID, const QStringList & words, int theCaseSensitivity, const QColor & color, bool matchAll)
 {
     typedef QPair<RegularAreaRect *, QColor> MatchColor;
-    QMap< Page *, QVector<MatchColor> > *pageMatches = static_cast< QMap< Page *, QVector<MatchColor> > * >(pageMatchesMap);
     Qt::CaseSensitivity caseSensitivity = static_cast<Qt::CaseSensitivity>(theCaseSensitivity);
     QSet< int > *pagesToNotify = static_cast< QSet< int > * >( pagesToNotifySet );
     RunningSearch *search = m_searches.value(searchID);
 
     if (m_searchCancelled || !search)
     {
-        typedef QVector<MatchColor> MatchesVector;
-
         QApplication::restoreOverrideCursor();
 
         if (search) search->isCurrentlySearching = false;
 
         emit m_parent->searchFinished( searchID, Document::SearchCancelled );
-
-        foreach(const MatchesVector &mv, *pageMatches)
-        {
-            foreach(const MatchColor &mc, mv) delete mc.first;
-        }
-        delete pageMatches;
         delete pagesToNotify;
         return;
     }
@@ -1850,11 +2404,11 @@ void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, vo
         Page *page = m_pagesVector.at(currentPage);
         int pageNumber = page->number(); // redundant? is it == currentPage ?
 
-        // request search page if needed
-        if ( !page->hasTextPage() )
-            m_parent->requestTextPage( pageNumber );
+        // request search page if needed (or mark it as used)
+        m_parent->requestTextPage( pageNumber );
 
         // loop on a page adding highlights for all found items
+        QVector<MatchColor> matches;
         bool allMatched = wordCount > 0,
              anyMatched = false;
         for ( int w = 0; w < wordCount; w++ )
@@ -1877,8 +2431,7 @@ void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, vo
                 if ( !lastMatch )
                     break;
 
-                // add highligh rect to the matches map
-                (*pageMatches)[page].append(MatchColor(lastMatch, wordColor));
+                matches.append(MatchColor(lastMatch, wordColor));
                 wordMatched = true;
             }
             allMatched = allMatched && wordMatched;
@@ -1888,12 +2441,27 @@ void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, vo
         // if not all words are present in page, remove partial highlights
         if ( !allMatched && matchAll )
         {
-            QVector<MatchColor> &matches = (*pageMatches)[page];
             foreach(const MatchColor &mc, matches) delete mc.first;
-            pageMatches->remove(page);
+            matches.clear();
+        }
+
+        // show the matches of the page at once, instead of at the end of the search
+        if ( !matches.isEmpty() )
+        {
+            const RegularAreaRect firstMatch = *matches.first().first;
+            foreach(const MatchColor &mc, matches)
+            {
+                page->d->setHighlight( searchID, mc.first, mc.second );
+                delete mc.first;
+            }
+            search->highlightedPages.insert( pageNumber );
+            pagesToNotify->remove( pageNumber );
+            foreach(DocumentObserver *observer, m_observers)
+                observer->notifyPageChanged( pageNumber, DocumentObserver::Highlights );
+            reportSearchMatches( searchID, search, pageNumber, matches.count(), firstMatch );
         }
 
-        QMetaObject::invokeMethod(m_parent, "doContinueGooglesDocumentSearch", Qt::QueuedConnection, Q_ARG(void *, pagesToNotifySet), Q_ARG(void *, pageMatches), Q_ARG(int, currentPage + 1), Q_ARG(int, searchID), Q_ARG(QStringList, words), Q_ARG(int, caseSensitivity), Q_ARG(QColor, color), Q_ARG(bool, matchAll));
+        QMetaObject::invokeMethod(m_parent, "doContinueGooglesDocumentSearch", Qt::QueuedConnection, Q_ARG(void *, pagesToNotifySet), Q_ARG(int, currentPage + 1), Q_ARG(int, searchID), Q_ARG(QStringList, words), Q_ARG(int, caseSensitivity), Q_ARG(QColor, color), Q_ARG(bool, matchAll));
     }
     else
     {
@@ -1901,26 +2469,13 @@ void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, vo
         QApplication::restoreOverrideCursor();
 
         search->isCurrentlySearching = false;
-        bool foundAMatch = pageMatches->count() != 0;
-        QMap< Page *, QVector<MatchColor> >::const_iterator it, itEnd;
-        it = pageMatches->constBegin();
-        itEnd = pageMatches->constEnd();
-        for ( ; it != itEnd; ++it)
-        {
-            foreach(const MatchColor &mc, it.value())
-            {
-                it.key()->d->setHighlight( searchID, mc.first, mc.second );
-                delete mc.first;
-            }
-            search->highlightedPages.insert( it.key()->number() );
-            pagesToNotify->insert( it.key()->number() );
-        }
+        bool foundAMatch = search->matchCount != 0;
 
         // send page lists to update observers (since some filter on bookmarks)
         foreach(DocumentObserver *observer, m_observers)
             observer->notifySetup( m_pagesVector, 0 );
 
-        // notify observers about highlights changes
+        // notify observers about the highlights removed
         foreach(int pageNumber, *pagesToNotify)
             foreach(DocumentObserver *observer, m_observers)
                 observer->notifyPageChanged( pageNumber, DocumentObserver::Highlights );
@@ -1928,7 +2483,6 @@ void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, vo
         if (foundAMatch) emit m_parent->searchFinished( searchID, Document::MatchFound );
         else emit m_parent->searchFinished( searchID, Document::NoMatchFound );
 
-        delete pageMatches;
         delete pagesToNotify;
     }
 }
@@ -1994,6 +2548,12 @@ QVariant DocumentPrivate::documentMetaData( const QString &key, const QVariant &
                 break;
         }
     }
+    else if ( key == QLatin1String( "CacheMemory" ) )
+    {
+        // the memory in bytes a generator can use for its own caches: as
+        // much as the text pages, from the memory level and budget
+        return m_textPageCache.maxMemory();
+    }
     return QVariant();
 };
 
@@ -2251,6 +2811,18 @@ bool Document::openDocument( const QString & docFile, const KUrl& url, const KMi
     AudioPlayer::instance()->d->m_currentDocument = isstdin ? KUrl() : d->m_url;
     d->m_docSize = document_size;
 
+    if ( SettingsCore::diskPixmapCache() && !isstdin )
+    {
+        d->m_pageDiskCacheSettings = d->pixmapCacheSettings();
+        d->m_pageDiskCache.open( docFile, d->m_generatorName, (qint64)SettingsCore::diskPixmapCacheSize() * 1024 * 1024 );
+    }
+
+    if ( SettingsCore::textIndex() && !isstdin && !d->m_xmlFileName.isEmpty()
+         && d->m_generator->hasFeature( Generator::TextExtraction ) && d->m_generator->hasFeature( Generator::Threaded ) )
+    {
+        d->startTextIndex( docFile );
+    }
+
     const QStringList docScripts = d->m_generator->metaData( "DocumentScripts", "JavaScript" ).toStringList();
     if ( !docScripts.isEmpty() )
     {
@@ -2285,13 +2857,14 @@ void Document::closeDocument()
     delete d->m_scripter;
     d->m_scripter = 0;
 
+    // the index job first, not to wait for it to index the whole document
+    // while waiting for the search jobs
+    d->stopTextIndex();
+    d->stopAllDocumentSearch();
+
      // remove requests left in queue
     d->m_pixmapRequestsMutex.lock();
-    QLinkedList< PixmapRequest * >::const_iterator sIt = d->m_pixmapRequestsStack.constBegin();
-    QLinkedList< PixmapRequest * >::const_iterator sEnd = d->m_pixmapRequestsStack.constEnd();
-    for ( ; sIt != sEnd; ++sIt )
-        delete *sIt;
-    d->m_pixmapRequestsStack.clear();
+    qDeleteAll( d->m_pixmapRequestsQueue.takeAll() );
     d->m_pixmapRequestsMutex.unlock();
 
     QEventLoop loop;
@@ -2356,6 +2929,9 @@ void Document::closeDocument()
     delete d->m_archiveData;
     d->m_archiveData = 0;
     d->m_docSize = -1;
+    d->m_pageDiskCache.close();
+    d->m_renderStatistics.writeTrace();
+    d->m_renderStatistics.clear();
     d->m_exportCached = false;
     d->m_exportFormats.clear();
     d->m_exportToText = ExportFormat();
@@ -2374,7 +2950,6 @@ void Document::closeDocument()
     d->m_pagesVector.clear();
 
     // clear 'memory allocation' descriptors
-    qDeleteAll( d->m_allocatedPixmaps );
     d->m_allocatedPixmaps.clear();
 
     // clear 'running searches' descriptors
@@ -2398,7 +2973,9 @@ void Document::closeDocument()
     d->m_viewportHistory.append( DocumentViewport() );
     d->m_viewportIterator = d->m_viewportHistory.begin();
     d->m_allocatedPixmapsTotalMemory = 0;
-    d->m_allocatedTextPagesFifo.clear();
+    kDebug(OkularDebug) << d->m_textPageCache.report();
+    d->m_textPageCache.clear();
+    d->m_textPageCache.clearStatistics();
     d->m_pageSize = PageSize();
     d->m_pageSizes.clear();
 
@@ -2434,18 +3011,10 @@ void Document::removeObserver( DocumentObserver * pObserver )
             (*it)->deletePixmap( pObserver );
 
         // [MEM] free observer's allocation descriptors
-        QLinkedList< AllocatedPixmap * >::iterator aIt = d->m_allocatedPixmaps.begin();
-        QLinkedList< AllocatedPixmap * >::iterator aEnd = d->m_allocatedPixmaps.end();
-        while ( aIt != aEnd )
+        foreach ( AllocatedPixmap *p, d->m_allocatedPixmaps.takeAll( pObserver ) )
         {
-            AllocatedPixmap * p = *aIt;
-            if ( p->observer == pObserver )
-            {
-                aIt = d->m_allocatedPixmaps.erase( aIt );
-                delete p;
-            }
-            else
-                ++aIt;
+            d->m_allocatedPixmapsTotalMemory -= p->memory;
+            delete p;
         }
 
         // delete observer entry from the map
@@ -2472,7 +3041,6 @@ void Document::reparseConfig()
         }
 
         // [MEM] remove allocation descriptors
-        qDeleteAll( d->m_allocatedPixmaps );
         d->m_allocatedPixmaps.clear();
         d->m_allocatedPixmapsTotalMemory = 0;
 
@@ -2624,6 +3192,9 @@ void Document::setVisiblePageRects( const QVector< VisiblePageRect * > & visible
     foreach(DocumentObserver *o, d->m_observers)
         if ( o != excludeObserver )
             o->notifyVisibleRectsChanged();
+
+    d->decompressVisibleTiles();
+    d->prefetchTextPages();
 }
 
 uint Document::currentPage() const
@@ -2727,6 +3298,11 @@ bool Document::historyAtEnd() const
 
 QVariant Document::metaData( const QString & key, const QVariant & option ) const
 {
+    if ( key == QLatin1String( "RenderStatistics" ) )
+        return d->m_renderStatistics.report();
+    if ( key == QLatin1String( "TextPageStatistics" ) )
+        return d->m_textPageCache.report();
+
     return d->m_generator ? d->m_generator->metaData( key, option ) : QVariant();
 }
 
@@ -2765,6 +3341,114 @@ QString Document::pageSizeString(int page) const
     return QString();
 }
 
+bool DocumentPrivate::loadSharedPixmap( PixmapRequest *request )
+{
+    // forced requests replace the pixmaps of all the observers
+    if ( request->isTile() || request->d->mForce )
+        return false;
+
+    Page *page = request->page();
+    if ( request->observer() == m_tiledObserver && page->hasTilesManager() )
+        return false;
+
+    // the request has already been adapted to the unrotated page, while the
+    // pixmaps of the page are rotated
+    int width = request->width(), height = request->height();
+    if ( (int)m_rotation % 2 )
+        qSwap( width, height );
+
+    const QPixmap *source = page->d->sharablePixmap( request->observer(), width, height );
+    if ( !source )
+        return false;
+
+    kDebug(OkularDebug).nospace() << "page " << request->pageNumber() << " shared with another observer, " << source->width() << "x" << source->height() << " -> " << width << "x" << height;
+    page->d->setSharedPixmap( request->observer(), source, width, height );
+    return true;
+}
+
+bool DocumentPrivate::loadCachedPixmap( PixmapRequest *request )
+{
+    const QImage image = loadCachedImage( request );
+    if ( image.isNull() )
+        return false;
+
+    Page *page = request->page();
+    page->setPixmap( request->observer(), new QPixmap( QPixmap::fromImage( image ) ), request->normalizedRect() );
+    if ( !page->isBoundingBoxKnown() )
+        setPageBoundingBox( request->pageNumber(), Utils::imageBoundingBox( &image ) );
+    return true;
+}
+
+QImage DocumentPrivate::loadCachedImage( PixmapRequest *request )
+{
+    // forced requests want the page as it is now
+    if ( !m_pageDiskCache.isOpen() || request->isTile() || request->d->mPreview || request->d->mForce )
+        return QImage();
+
+    const QImage image = m_pageDiskCache.load( request->pageNumber(), request->width(), request->height(), request->page()->rotation(), m_pageDiskCacheSettings );
+    if ( !image.isNull() )
+        kDebug(OkularDebug).nospace() << "page " << request->pageNumber() << " loaded from the disk cache";
+    return image;
+}
+
+void DocumentPrivate::storeCachedPixmap( PixmapRequest *request, const QImage &image )
+{
+    if ( !m_pageDiskCache.isOpen() || request->isTile() || request->d->mPreview )
+        return;
+
+    m_pageDiskCache.store( request->pageNumber(), request->width(), request->height(), request->page()->rotation(), m_pageDiskCacheSettings, image );
+}
+
+QString DocumentPrivate::pixmapCacheSettings() const
+{
+    QStringList settings;
+    settings << documentMetaData( "TextAntialias", QVariant() ).toString();
+    settings << documentMetaData( "GraphicsAntialias", QVariant() ).toString();
+    settings << documentMetaData( "TextHinting", QVariant() ).toString();
+    settings << documentMetaData( "PaperColor", true ).value< QColor >().name();
+
+    // a new version of the generator may render differently, and so may
+    // its own settings
+    QHash< QString, GeneratorInfo >::const_iterator genIt = m_loadedGenerators.constFind( m_generatorName );
+    if ( genIt != m_loadedGenerators.constEnd() && genIt.value().data.aboutData() )
+        settings << genIt.value().data.aboutData()->version();
+    if ( m_generator )
+        settings << m_generator->metaData( "RenderSettings", QVariant() ).toString();
+
+    const QByteArray hash = QCryptographicHash::hash( settings.join( QLatin1String( "\n" ) ).toUtf8(), QCryptographicHash::Sha1 );
+    return QString::fromLatin1( hash.toHex().left( 16 ) );
+}
+
+bool DocumentPrivate::needsPreview( PixmapRequest *request ) const
+{
+    if ( !request->asynchronous() || request->preload() || request->isTile() )
+        return false;
+
+    if ( (long)request->width() * (long)request->height() < OKULAR_PREVIEW_MINPIXELS )
+        return false;
+
+    // the tiles manager already shows the scaled pixmap of the previous zoom
+    const Page *page = request->page();
+    if ( request->observer() == m_tiledObserver && page->hasTilesManager() )
+        return false;
+
+    // there is something to show already, even if not at the right size
+    return !page->hasPixmap( request->observer() );
+}
+
+void DocumentPrivate::abortExecutingPixmapRequests( DocumentObserver *observer, const QSet< int > &pagesToKeep )
+{
+    foreach ( PixmapRequest *r, m_executingPixmapRequests )
+    {
+        // synchronous requests are waited for by someone, let them finish
+        if ( r->observer() == observer && r->asynchronous() && !pagesToKeep.contains( r->pageNumber() ) )
+        {
+            kDebug(OkularDebug).nospace() << "aborting request observer=" << observer << " @" << r->pageNumber();
+            r->d->abortRender();
+        }
+    }
+}
+
 void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests )
 {
     requestPixmaps( requests, RemoveAllPrevious );
@@ -2796,20 +3480,21 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
     }
     const bool removeAllPrevious = reqOptions & RemoveAllPrevious;
     d->m_pixmapRequestsMutex.lock();
-    QLinkedList< PixmapRequest * >::iterator sIt = d->m_pixmapRequestsStack.begin(), sEnd = d->m_pixmapRequestsStack.end();
-    while ( sIt != sEnd )
+    foreach ( PixmapRequest *r, d->m_pixmapRequestsQueue.requests( requesterObserver ) )
     {
-        if ( (*sIt)->observer() == requesterObserver
-             && ( removeAllPrevious || requestedPages.contains( (*sIt)->pageNumber() ) ) )
+        if ( removeAllPrevious || requestedPages.contains( r->pageNumber() ) )
         {
-            // delete request and remove it from stack
-            delete *sIt;
-            sIt = d->m_pixmapRequestsStack.erase( sIt );
+            // delete request and remove it from the queue
+            d->m_pixmapRequestsQueue.remove( r );
+            delete r;
         }
-        else
-            ++sIt;
     }
 
+    // the pixmaps being generated for pages that are not in the new set of
+    // requests will not be used, stop wasting time on them
+    if ( removeAllPrevious )
+        d->abortExecutingPixmapRequests( requesterObserver, requestedPages );
+
     // 2. [ADD TO STACK] add requests to stack
     QLinkedList< PixmapRequest * >::const_iterator rIt = requests.constBegin(), rEnd = requests.constEnd();
     for ( ; rIt != rEnd; ++rIt )
@@ -2853,18 +3538,22 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
         if ( !request->asynchronous() )
             request->d->mPriority = 0;
 
-        // add request to the 'stack' at the right place
-        if ( !request->priority() )
-            // add priority zero requests to the top of the stack
-            d->m_pixmapRequestsStack.append( request );
-        else
+        // add request to the queue, sorted by priority
+        request->d->mTimes.enqueued = RenderStatistics::timestamp();
+        d->m_pixmapRequestsQueue.push( request );
+
+        // the page is going to be shown blank until the pixmap is ready:
+        // queue a quick low resolution render that will be shown meanwhile
+        if ( ( reqOptions & LowResolutionFirst ) && d->needsPreview( request ) )
         {
-            // insert in stack sorted by priority
-            sIt = d->m_pixmapRequestsStack.begin();
-            sEnd = d->m_pixmapRequestsStack.end();
-            while ( sIt != sEnd && (*sIt)->priority() > request->priority() )
-                ++sIt;
-            d->m_pixmapRequestsStack.insert( sIt, request );
+            PixmapRequest * preview = new PixmapRequest( request->observer(), request->pageNumber(),
+                                                         qMax( 1, request->width() / OKULAR_PREVIEW_SCALE ),
+                                                         qMax( 1, request->height() / OKULAR_PREVIEW_SCALE ),
+                                                         -1, PixmapRequest::Asynchronous );
+            preview->d->mPage = request->page();
+            preview->d->mPreview = true;
+            preview->d->mTimes.enqueued = request->d->mTimes.enqueued;
+            d->m_pixmapRequestsQueue.push( preview );
         }
     }
     d->m_pixmapRequestsMutex.unlock();
@@ -2883,8 +3572,17 @@ void Document::requestTextPage( uint page )
     if ( !d->m_generator || !kp )
         return;
 
-    // Memory management for TextPages
+    // Memory management for TextPages: a text already there is only marked
+    // as used, so that it is the last one to be deleted
+    if ( kp->hasTextPage() )
+    {
+        if ( d->m_textPageCache.contains( page ) )
+            d->m_textPageCache.use( page );
+        d->textPageMemoryChanged( kp );
+        return;
+    }
 
+    d->m_textPageCache.use( page ); // counts the miss
     d->m_generator->generateTextPage( kp );
 }
 
@@ -3204,6 +3902,12 @@ void Document::setNextDocumentDestination( const QString &namedDestination )
     d->m_nextDocumentDestination = namedDestination;
 }
 
+// whether QRegExp matches @p c with \w
+static bool isWordCharacter( QChar c )
+{
+    return c.isLetterOrNumber() || c.isMark() || c == QLatin1Char( '_' );
+}
+
 void Document::searchText( int searchID, const QString & text, bool fromStart, Qt::CaseSensitivity caseSensitivity,
                                SearchType type, bool moveViewport, const QColor & color, bool noDialogs )
 {
@@ -3216,6 +3920,31 @@ void Document::searchText( int searchID, const QString & text, bool fromStart, Q
         return;
     }
 
+    // the regular expression is compiled once for the whole search
+    QRegExp regExp;
+    if ( type == RegularExpression )
+        regExp = QRegExp( text, caseSensitivity, QRegExp::RegExp2 );
+    else if ( type == WholeWords )
+    {
+        // normalized like the text of the pages, and bounded only where it
+        // has word characters, otherwise "C++" could never match; QRegExp
+        // has no lookbehind, but \b before a word character needs the
+        // previous one not to be a word character too
+        const QString normalized = text.normalized( QString::NormalizationForm_KC );
+        QString pattern = QRegExp::escape( normalized );
+        if ( !normalized.isEmpty() && isWordCharacter( normalized.at( 0 ) ) )
+            pattern.prepend( QLatin1String( "\\b" ) );
+        if ( !normalized.isEmpty() && isWordCharacter( normalized.at( normalized.length() - 1 ) ) )
+            pattern.append( QLatin1String( "(?!\\w)" ) );
+        regExp = QRegExp( pattern, caseSensitivity, QRegExp::RegExp2 );
+    }
+    if ( !regExp.isValid() )
+    {
+        kDebug(OkularDebug) << "Invalid regular expression" << text << ":" << regExp.errorString();
+        emit searchFinished( searchID, NoMatchFound );
+        return;
+    }
+
     if ( !noDialogs )
     {
 #if 0
@@ -3255,6 +3984,7 @@ void Document::searchText( int searchID, const QString & text, bool fromStart, Q
     s->cachedNoDialogs = noDialogs;
     s->cachedColor = color;
     s->isCurrentlySearching = true;
+    s->matchCount = 0;
 
     // global data for search
     QSet< int > *pagesToNotify = new QSet< int >;
@@ -3269,12 +3999,21 @@ void Document::searchText( int searchID, const QString & text, bool fromStart, Q
     QApplication::setOverrideCursor( Qt::WaitCursor );
 
     // 1. ALLDOC - proces all document marking pages
-    if ( type == AllDocument )
+    if ( type == AllDocument || type == RegularExpression || type == WholeWords || type == IgnoreAccents || type == Approximate )
     {
-        QMap< Page *, QVector<RegularAreaRect *> > *pageMatches = new QMap< Page *, QVector<RegularAreaRect *> >;
+        const TextPage::TextComparison comparison = type == IgnoreAccents ? TextPage::LooseComparison
+                                                    : type == Approximate ? TextPage::ApproximateComparison : TextPage::ExactComparison;
+
+        // extract the text and search it in worker threads, if the
+        // generator can extract text out of the GUI thread
+        if ( d->m_generator->hasFeature( Generator::Threaded ) )
+        {
+            d->startAllDocumentSearch( searchID, pagesToNotify, text, caseSensitivity, comparison, regExp, color );
+            return;
+        }
 
         // search and highlight 'text' (as a solid phrase) on all pages
-        QMetaObject::invokeMethod(this, "doContinueAllDocumentSearch", Qt::QueuedConnection, Q_ARG(void *, pagesToNotify), Q_ARG(void *, pageMatches), Q_ARG(int, 0), Q_ARG(int, searchID), Q_ARG(QString, text), Q_ARG(int, caseSensitivity), Q_ARG(QColor, color));
+        QMetaObject::invokeMethod(this, "doContinueAllDocumentSearch", Qt::QueuedConnection, Q_ARG(void *, pagesToNotify), Q_ARG(int, 0), Q_ARG(int, searchID), Q_ARG(QString, text), Q_ARG(int, caseSensitivity), Q_ARG(int, comparison), Q_ARG(QRegExp, regExp), Q_ARG(QColor, color));
     }
     // 2. NEXTMATCH - find next matching item (or start from top)
     // 3. PREVMATCH - find previous matching item (or start from bottom)
@@ -3324,11 +4063,10 @@ void Document::searchText( int searchID, const QString & text, bool fromStart, Q
     {
         bool matchAll = type == GoogleAll;
 
-        QMap< Page *, QVector< QPair<RegularAreaRect *, QColor> > > *pageMatches = new QMap< Page *, QVector<QPair<RegularAreaRect *, QColor> > >;
         const QStringList words = text.split( ' ', QString::SkipEmptyParts );
 
         // search and highlight every word in 'text' on all pages
-        QMetaObject::invokeMethod(this, "doContinueGooglesDocumentSearch", Qt::QueuedConnection, Q_ARG(void *, pagesToNotify), Q_ARG(void *, pageMatches), Q_ARG(int, 0), Q_ARG(int, searchID), Q_ARG(QStringList, words), Q_ARG(int, caseSensitivity), Q_ARG(QColor, color), Q_ARG(bool, matchAll));
+        QMetaObject::invokeMethod(this, "doContinueGooglesDocumentSearch", Qt::QueuedConnection, Q_ARG(void *, pagesToNotify), Q_ARG(int, 0), Q_ARG(int, searchID), Q_ARG(QStringList, words), Q_ARG(int, caseSensitivity), Q_ARG(QColor, color), Q_ARG(bool, matchAll));
     }
 }
 
@@ -3396,6 +4134,9 @@ void Document::resetSearch( int searchID )
 void Document::cancelSearch()
 {
     d->m_searchCancelled = true;
+
+    if ( d->m_allDocumentSearch )
+        d->finishAllDocumentSearch( SearchCancelled );
 }
 
 void Document::undo()
@@ -4230,19 +4971,39 @@ void DocumentPrivate::requestDone( PixmapRequest * req )
         kDebug(OkularDebug) << "requestDone with generator not in READY state.";
 #endif
 
-    // [MEM] 1.1 find and remove a previous entry for the same page and id
-    QLinkedList< AllocatedPixmap * >::iterator aIt = m_allocatedPixmaps.begin();
-    QLinkedList< AllocatedPixmap * >::iterator aEnd = m_allocatedPixmaps.end();
-    for ( ; aIt != aEnd; ++aIt )
-        if ( (*aIt)->page == req->pageNumber() && (*aIt)->observer == req->observer() )
+    if ( req->shouldAbortRender() )
+    {
+        // nothing was stored in the page, just let the tiles manager accept
+        // a new request for the same area (as it was before being adapted
+        // to the rotation in sendGeneratorPixmapRequest)
+        TilesManager *tm = ( req->observer() == m_tiledObserver ) ? req->page()->d->tilesManager() : 0;
+        if ( tm )
         {
-            AllocatedPixmap * p = *aIt;
-            m_allocatedPixmaps.erase( aIt );
-            m_allocatedPixmapsTotalMemory -= p->memory;
-            delete p;
-            break;
+            int width = req->width(), height = req->height();
+            if ( (int)m_rotation % 2 )
+                qSwap( width, height );
+            tm->removeRequest( TilesManager::toRotatedRect( req->normalizedRect(), m_rotation ), width, height );
         }
 
+        m_pixmapRequestsMutex.lock();
+        m_executingPixmapRequests.removeAll( req );
+        const bool hasPixmaps = !m_pixmapRequestsQueue.isEmpty();
+        m_pixmapRequestsMutex.unlock();
+        delete req;
+
+        if ( hasPixmaps )
+            sendGeneratorPixmapRequest();
+        return;
+    }
+
+    // [MEM] 1.1 find and remove a previous entry for the same page and id
+    AllocatedPixmap * previous = m_allocatedPixmaps.take( req->observer(), req->pageNumber() );
+    if ( previous )
+    {
+        m_allocatedPixmapsTotalMemory -= previous->memory;
+        delete previous;
+    }
+
     DocumentObserver *observer = req->observer();
     if ( m_observers.contains(observer) )
     {
@@ -4255,11 +5016,13 @@ void DocumentPrivate::requestDone( PixmapRequest * req )
             memoryBytes = 4 * req->width() * req->height();
 
         AllocatedPixmap * memoryPage = new AllocatedPixmap( req->observer(), req->pageNumber(), memoryBytes );
-        m_allocatedPixmaps.append( memoryPage );
+        m_allocatedPixmaps.insert( memoryPage );
         m_allocatedPixmapsTotalMemory += memoryBytes;
 
         // 2. notify an observer that its pixmap changed
         observer->notifyPageChanged( req->pageNumber(), DocumentObserver::Pixmap );
+
+        m_renderStatistics.addRequest( req->pageNumber(), req->isTile(), req->d->mTimes, RenderStatistics::timestamp() );
     }
 #ifndef NDEBUG
     else
@@ -4274,7 +5037,7 @@ void DocumentPrivate::requestDone( PixmapRequest * req )
 
     // 4. start a new generation if some is pending
     m_pixmapRequestsMutex.lock();
-    bool hasPixmaps = !m_pixmapRequestsStack.isEmpty();
+    bool hasPixmaps = !m_pixmapRequestsQueue.isEmpty();
     m_pixmapRequestsMutex.unlock();
     if ( hasPixmaps )
         sendGeneratorPixmapRequest();
@@ -4300,45 +5063,211 @@ void DocumentPrivate::setPageBoundingBox( int page, const NormalizedRect& boundi
 
 }
 
-void DocumentPrivate::calculateMaxTextPages()
+void DocumentPrivate::setPageAnnotationsLoaded( int page )
+{
+    Page * kp = m_pagesVector[ page ];
+    if ( !m_generator || !kp )
+        return;
+
+    // like the annotations loaded with the document, the ones of the
+    // document itself are lost if it is not saved as a new file
+    if ( !kp->annotations().isEmpty() && canAddAnnotationsNatively() )
+        m_annotationsNeedSaveAs = true;
+
+    notifyAnnotationChanges( page );
+}
+
+void DocumentPrivate::setPageSizes( const QHash< int, QSizeF > &sizes )
+{
+    if ( !m_generator || sizes.isEmpty() )
+        return;
+
+    QSet< int > resizedPages;
+    QHash< int, QSizeF >::const_iterator sIt = sizes.constBegin(), sEnd = sizes.constEnd();
+    for ( ; sIt != sEnd; ++sIt )
+    {
+        Page * kp = m_pagesVector.value( sIt.key() );
+        if ( !kp )
+            continue;
+
+        // the pixmaps of the page go away with its old size
+        foreach ( DocumentObserver *observer, m_observers )
+        {
+            AllocatedPixmap * p = m_allocatedPixmaps.take( observer, sIt.key() );
+            if ( p )
+            {
+                m_allocatedPixmapsTotalMemory -= p->memory;
+                delete p;
+            }
+        }
+        m_pageDiskCache.removePage( sIt.key() );
+        kp->d->changeSize( PageSize( sIt->width(), sIt->height(), QString() ) );
+        resizedPages.insert( sIt.key() );
+    }
+
+    // the requests for the old sizes are useless: drop the queued ones, and
+    // abort the ones being rendered, whose pixmaps are then discarded
+    m_pixmapRequestsMutex.lock();
+    foreach ( DocumentObserver *observer, m_observers )
+    {
+        foreach ( PixmapRequest *r, m_pixmapRequestsQueue.requests( observer ) )
+        {
+            if ( resizedPages.contains( r->pageNumber() ) )
+            {
+                m_pixmapRequestsQueue.remove( r );
+                delete r;
+            }
+        }
+    }
+    foreach ( PixmapRequest *r, m_executingPixmapRequests )
+    {
+        // synchronous requests are waited for by someone, let them finish
+        if ( r->asynchronous() && resizedPages.contains( r->pageNumber() ) )
+            r->d->abortRender();
+    }
+    m_pixmapRequestsMutex.unlock();
+
+    // the observers lay the pages out again, and request the pixmaps of
+    // the resized pages only
+    foreachObserverD( notifySetup( m_pagesVector, DocumentObserver::NewLayoutForPages ) );
+    foreach ( int page, resizedPages )
+        foreachObserverD( notifyPageChanged( page, DocumentObserver::Pixmap ) );
+}
+
+void DocumentPrivate::calculateMaxTextPageMemory()
 {
-    int multipliers = qMax(1, qRound(getTotalMemory() / 536870912.0)); // 512 MB
+    // a share of the total memory, like the pixmaps
+    qulonglong maxMemory = 0;
     switch (SettingsCore::memoryLevel())
     {
         case SettingsCore::EnumMemoryLevel::Low:
-            m_maxAllocatedTextPages = multipliers * 2;
+            maxMemory = getTotalMemory() / 512;
         break;
 
         case SettingsCore::EnumMemoryLevel::Normal:
-            m_maxAllocatedTextPages = multipliers * 50;
+            maxMemory = getTotalMemory() / 64;
         break;
 
         case SettingsCore::EnumMemoryLevel::Aggressive:
-            m_maxAllocatedTextPages = multipliers * 250;
+            maxMemory = getTotalMemory() / 16;
         break;
 
         case SettingsCore::EnumMemoryLevel::Greedy:
-            m_maxAllocatedTextPages = multipliers * 1250;
+            maxMemory = getTotalMemory() / 4;
         break;
     }
+
+    // the text pages share the memory budget with the pixmaps
+    const qulonglong budget = pixmapMemoryBudget();
+    if ( budget )
+        maxMemory = qMin( maxMemory, budget / 8 );
+
+    if ( maxMemory == m_textPageCache.maxMemory() )
+        return;
+
+    m_textPageCache.setMaxMemory( maxMemory );
+
+    // the caches of the generator get as much (see metaData())
+    if ( m_generator )
+        QMetaObject::invokeMethod( m_generator, "cacheMemoryChanged", Qt::DirectConnection );
 }
 
 void DocumentPrivate::textGenerationDone( Page *page )
 {
     if ( !m_generator || m_closingLoop ) return;
 
-    // 1. If we reached the cache limit, delete the first text page from the fifo
-    if (m_allocatedTextPagesFifo.size() == m_maxAllocatedTextPages)
+    // 1. Account the memory of the new text page
+    m_textPageCache.insert( page->number(), page->d->textPageMemory() );
+
+    // 2. Delete the least recently used text pages over the limit
+    foreach ( int pageToKick, m_textPageCache.evict( page->number() ) )
+        m_pagesVector.at(pageToKick)->setTextPage( 0 ); // deletes the textpage
+}
+
+void DocumentPrivate::textPageMemoryChanged( Page *page )
+{
+    if ( !m_generator || m_closingLoop ) return;
+
+    // the searches build structures in the text pages, like the case folded
+    // text, account them
+    if ( m_textPageCache.contains( page->number() ) )
+        m_textPageCache.setMemory( page->number(), page->d->textPageMemory() );
+    else
+        m_textPageCache.insert( page->number(), page->d->textPageMemory() );
+
+    foreach ( int pageToKick, m_textPageCache.evict( page->number() ) )
+        m_pagesVector.at(pageToKick)->setTextPage( 0 ); // deletes the textpage
+}
+
+void DocumentPrivate::decompressVisibleTiles()
+{
+    if ( !m_tiledObserver )
+        return;
+
+    foreach ( const VisiblePageRect *visibleRect, m_pageRects )
     {
-        int pageToKick = m_allocatedTextPagesFifo.takeFirst();
-        if (pageToKick != page->number()) // this should never happen but better be safe than sorry
+        if ( visibleRect->pageNumber < 0 || visibleRect->pageNumber >= m_pagesVector.count() )
+            continue;
+
+        Page *page = m_pagesVector.at( visibleRect->pageNumber );
+        TilesManager *tilesManager = page->d->tilesManager();
+        if ( !tilesManager )
+            continue;
+
+        // decompress a bit more than what is visible, so the tiles scrolled
+        // into view next are ready before they have to be painted
+        const NormalizedRect &rect = visibleRect->rect;
+        const double marginX = ( rect.right - rect.left ) / 2;
+        const double marginY = ( rect.bottom - rect.top ) / 2;
+        const NormalizedRect expandedRect( qMax( 0.0, rect.left - marginX ), qMax( 0.0, rect.top - marginY ),
+                                           qMin( 1.0, rect.right + marginX ), qMin( 1.0, rect.bottom + marginY ) );
+        if ( !tilesManager->decompressTiles( expandedRect ) )
+            continue;
+
+        AllocatedPixmap *allocatedPixmap = m_allocatedPixmaps.take( m_tiledObserver, page->number() );
+        if ( allocatedPixmap )
         {
-            m_pagesVector.at(pageToKick)->setTextPage( 0 ); // deletes the textpage
+            m_allocatedPixmapsTotalMemory -= allocatedPixmap->memory;
+            allocatedPixmap->memory = tilesManager->totalMemory();
+            m_allocatedPixmapsTotalMemory += allocatedPixmap->memory;
+            m_allocatedPixmaps.insert( allocatedPixmap );
         }
+
+        m_tiledObserver->notifyPageChanged( page->number(), DocumentObserver::Pixmap );
+    }
+}
+
+void DocumentPrivate::prefetchTextPages()
+{
+    if ( !m_generator || m_closingLoop || !m_generator->hasFeature( Generator::TextExtraction )
+         || !m_generator->hasFeature( Generator::Threaded ) )
+        return;
+
+    // the visible pages first, then the closest ones around them
+    QList< Page * > pages;
+    int first = m_pagesVector.count();
+    int last = -1;
+    foreach ( VisiblePageRect *rect, m_pageRects )
+    {
+        if ( rect->pageNumber < 0 || rect->pageNumber >= m_pagesVector.count() )
+            continue;
+        pages.append( m_pagesVector.at( rect->pageNumber ) );
+        first = qMin( first, rect->pageNumber );
+        last = qMax( last, rect->pageNumber );
+    }
+    if ( pages.isEmpty() )
+        return;
+
+    const int window = (int)SettingsCore::textPrefetchPages();
+    for ( int i = 1; i <= window; ++i )
+    {
+        if ( last + i < m_pagesVector.count() )
+            pages.append( m_pagesVector.at( last + i ) );
+        if ( first - i >= 0 )
+            pages.append( m_pagesVector.at( first - i ) );
     }
 
-    // 2. Add the page to the fifo of generated text pages
-    m_allocatedTextPagesFifo.append( page->number() );
+    m_generator->d_func()->prefetchTextPages( pages );
 }
 
 void Document::setRotation( int r )
@@ -4390,7 +5319,6 @@ void Document::setPageSize( const PageSize &size )
     for ( ; pIt != pEnd; ++pIt )
         (*pIt)->d->changeSize( size );
     // clear 'memory allocation' descriptors
-    qDeleteAll( d->m_allocatedPixmaps );
     d->m_allocatedPixmaps.clear();
     d->m_allocatedPixmapsTotalMemory = 0;
     // notify the generator that the current page size has changed
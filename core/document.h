@@ -25,6 +25,7 @@
 #include <kmimetype.h>
 
 class QPrintDialog;
+class QRegExp;
 class KComponentData;
 class KBookmark;
 class KConfigDialog;
@@ -32,6 +33,10 @@ class KXMLGUIClient;
 class KUrl;
 class DocumentItem;
 
+namespace ThreadWeaver {
+    class Job;
+}
+
 namespace Okular {
 
 class Annotation;
@@ -268,6 +273,11 @@ class OKULAR_EXPORT Document : public QObject
         /**
          * Returns the meta data for the given @p key and @p option or an empty variant
          * if the key doesn't exists.
+         *
+         * The "RenderStatistics" key returns a summary of the time spent
+         * rendering the pixmaps of the document, as a string, and the
+         * "TextPageStatistics" key a summary of the memory and the hit rate
+         * of the text pages.
          */
         QVariant metaData( const QString & key, const QVariant & option = QVariant() ) const;
 
@@ -344,7 +354,8 @@ class OKULAR_EXPORT Document : public QObject
         enum PixmapRequestFlag
         {
             NoOption = 0,                ///< No options
-            RemoveAllPrevious = 1        ///< Remove all the previous requests, even for non requested page pixmaps
+            RemoveAllPrevious = 1,       ///< Remove all the previous requests, even for non requested page pixmaps
+            LowResolutionFirst = 2       ///< For visible pages without any pixmap, render a cheap low resolution pixmap before the requested one. @since 0.17 (KDE 4.11)
         };
         Q_DECLARE_FLAGS( PixmapRequestFlags, PixmapRequestFlag )
 
@@ -469,7 +480,11 @@ class OKULAR_EXPORT Document : public QObject
             PreviousMatch,  ///< Search previous match
             AllDocument,    ///< Search complete document
             GoogleAll,      ///< Search all words in google style
-            GoogleAny       ///< Search any words in google style
+            GoogleAny,      ///< Search any words in google style
+            RegularExpression, ///< Search complete document for a regular expression @since 0.17 (KDE 4.11)
+            WholeWords,     ///< Search complete document for the text as whole words @since 0.17 (KDE 4.11)
+            IgnoreAccents,  ///< Search complete document ignoring the case, the accents and the ligatures @since 0.17 (KDE 4.11)
+            Approximate     ///< Search complete document like IgnoreAccents, a character can also be different, missing or extra @since 0.17 (KDE 4.11)
         };
 
         /**
@@ -490,8 +505,12 @@ class OKULAR_EXPORT Document : public QObject
          * @param caseSensitivity Whether the search is case sensitive.
          * @param type The type of the search. @ref SearchType
          * @param moveViewport Whether the viewport shall be moved to the position of the matches.
+         *                     Searches in the whole document move it to the first match found.
          * @param color The highlighting color of the matches.
          * @param noDialogs Whether a search dialog shall be shown.
+         *
+         * The searches in the whole document report their matches while they
+         * go with searchMatchesFound(), before searchFinished().
          */
         void searchText( int searchID, const QString & text, bool fromStart, Qt::CaseSensitivity caseSensitivity,
                          SearchType type, bool moveViewport, const QColor & color, bool noDialogs = false );
@@ -836,6 +855,15 @@ class OKULAR_EXPORT Document : public QObject
          */
         void searchFinished( int id, Okular::Document::SearchStatus endStatus );
 
+        /**
+         * Reports that the search @p id, searching the whole document, found
+         * and highlighted @p pageMatches matches in the page @p page.
+         * @p totalMatches is the number of matches found so far by the search.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        void searchMatchesFound( int id, int page, int pageMatches, int totalMatches );
+
         /**
          * This signal is emitted whenever a source reference with the given parameters has been
          * activated.
@@ -905,8 +933,10 @@ class OKULAR_EXPORT Document : public QObject
 
         // search thread simulators
         Q_PRIVATE_SLOT( d, void doContinueDirectionMatchSearch(void *doContinueDirectionMatchSearchStruct) )
-        Q_PRIVATE_SLOT( d, void doContinueAllDocumentSearch(void *pagesToNotifySet, void *pageMatchesMap, int currentPage, int searchID, const QString & text, int caseSensitivity, const QColor & color) )
-        Q_PRIVATE_SLOT( d, void doContinueGooglesDocumentSearch(void *pagesToNotifySet, void *pageMatchesMap, int currentPage, int searchID, const QStringList & words, int caseSensitivity, const QColor & color, bool matchAll) )
+        Q_PRIVATE_SLOT( d, void doContinueAllDocumentSearch(void *pagesToNotifySet, int currentPage, int searchID, const QString & text, int caseSensitivity, int comparison, const QRegExp & regExp, const QColor & color) )
+        Q_PRIVATE_SLOT( d, void doContinueGooglesDocumentSearch(void *pagesToNotifySet, int currentPage, int searchID, const QStringList & words, int caseSensitivity, const QColor & color, bool matchAll) )
+        Q_PRIVATE_SLOT( d, void textSearchJobDone( ThreadWeaver::Job *job ) )
+        Q_PRIVATE_SLOT( d, void textIndexJobDone( ThreadWeaver::Job *job ) )
 };
 
 
@@ -26,20 +26,28 @@
 // local includes
 #include "fontinfo.h"
 #include "generator.h"
+#include "pagediskcache_p.h"
+#include "pixmapcache_p.h"
+#include "renderstatistics_p.h"
+#include "textindex_p.h"
+#include "textpage.h"
+#include "textpagecache_p.h"
 
 class QUndoStack;
 class QEventLoop;
 class QTimer;
 class KTemporaryFile;
 
-struct AllocatedPixmap;
 struct ArchiveData;
 struct RunningSearch;
+struct AllDocumentSearch;
 
 namespace Okular {
 class ConfigInterface;
 class SaveInterface;
 class Scripter;
+class TextIndexJob;
+class TextSearchJob;
 class View;
 }
 
@@ -85,10 +93,11 @@ class DocumentPrivate
         DocumentPrivate( Document *parent )
           : m_parent( parent ),
             m_lastSearchID( -1 ),
+            m_allDocumentSearch( 0 ),
+            m_textIndexJob( 0 ),
             m_tempFile( 0 ),
             m_docSize( -1 ),
             m_allocatedPixmapsTotalMemory( 0 ),
-            m_maxAllocatedTextPages( 0 ),
             m_warnedOutOfMemory( false ),
             m_rotation( Rotation0 ),
             m_exportCached( false ),
@@ -105,7 +114,7 @@ class DocumentPrivate
             m_annotationEditingEnabled ( true ),
             m_annotationBeingMoved( false )
         {
-            calculateMaxTextPages();
+            calculateMaxTextPageMemory();
         }
 
         // private methods
@@ -116,7 +125,13 @@ class DocumentPrivate
         void cleanupPixmapMemory();
         void cleanupPixmapMemory( qulonglong memoryToFree );
         AllocatedPixmap * searchLowestPriorityPixmap( bool unloadableOnly = false, bool thenRemoveIt = false, DocumentObserver *observer = 0 /* any */ );
-        void calculateMaxTextPages();
+        void calculateMaxTextPageMemory();
+        /**
+         * The maximum memory for the pixmaps and the text pages: from the
+         * configuration, or derived from the memory limit of the control
+         * group okular runs in. 0 if there is no budget.
+         */
+        qulonglong pixmapMemoryBudget();
         qulonglong getTotalMemory();
         qulonglong getFreeMemory( qulonglong *freeSwap = 0 );
         void loadDocumentInfo();
@@ -152,6 +167,41 @@ class DocumentPrivate
         void saveDocumentInfo() const;
         void slotTimedMemoryCheck();
         void sendGeneratorPixmapRequest();
+        /**
+         * Sets the pixmap of @p request scaling down the one of another
+         * observer, if there is a suitable one.
+         */
+        bool loadSharedPixmap( PixmapRequest *request );
+        /**
+         * Sets the pixmap of @p request from the disk cache, if it is there.
+         */
+        bool loadCachedPixmap( PixmapRequest *request );
+        /**
+         * Returns the image of @p request from the disk cache, or a null
+         * image. Can be called from any thread.
+         */
+        QImage loadCachedImage( PixmapRequest *request );
+        /**
+         * Queues the @p image rendered for @p request to be saved in the disk
+         * cache. Can be called from any thread.
+         */
+        void storeCachedPixmap( PixmapRequest *request, const QImage &image );
+        /**
+         * A key of the rendering settings that change the rendered pixmaps,
+         * of okular and of the generator.
+         */
+        QString pixmapCacheSettings() const;
+        /**
+         * Whether a low resolution pixmap should be rendered before @p request,
+         * see Document::LowResolutionFirst.
+         */
+        bool needsPreview( PixmapRequest *request ) const;
+        /**
+         * Asks the generator to abort the executing requests of @p observer
+         * for pages not in @p pagesToKeep.
+         * Must be called with m_pixmapRequestsMutex locked.
+         */
+        void abortExecutingPixmapRequests( DocumentObserver *observer, const QSet< int > &pagesToKeep );
         void rotationFinished( int page, Okular::Page *okularPage );
         void fontReadingProgress( int page );
         void fontReadingGotFont( const Okular::FontInfo& font );
@@ -159,10 +209,24 @@ class DocumentPrivate
         void refreshPixmaps( int );
         void _o_configChanged();
         void doContinueDirectionMatchSearch(void *doContinueDirectionMatchSearchStruct);
-        void doContinueAllDocumentSearch(void *pagesToNotifySet, void *pageMatchesMap, int currentPage, int searchID, const QString & text, int caseSensitivity, const QColor & color);
-        void doContinueGooglesDocumentSearch(void *pagesToNotifySet, void *pageMatchesMap, int currentPage, int searchID, const QStringList & words, int caseSensitivity, const QColor & color, bool matchAll);
+        void doContinueAllDocumentSearch(void *pagesToNotifySet, int currentPage, int searchID, const QString & text, int caseSensitivity, int comparison, const QRegExp & regExp, const QColor & color);
+        void doContinueGooglesDocumentSearch(void *pagesToNotifySet, int currentPage, int searchID, const QStringList & words, int caseSensitivity, const QColor & color, bool matchAll);
 
         void doProcessSearchMatch( RegularAreaRect *match, RunningSearch *search, QSet< int > *pagesToNotify, int currentPage, int searchID, bool moveViewport, const QColor & color );
+        // counts the matches highlighted in a page by a whole document search
+        void reportSearchMatches( int searchID, RunningSearch *search, int pageNumber, int matches, const RegularAreaRect &firstMatch );
+
+        // whole document search in worker threads
+        void startAllDocumentSearch( int searchID, QSet< int > *pagesToNotify, const QString & text, Qt::CaseSensitivity caseSensitivity, TextPage::TextComparison comparison, const QRegExp & regExp, const QColor & color );
+        void startTextSearchJobs();
+        void textSearchJobDone( ThreadWeaver::Job *job );
+        void finishAllDocumentSearch( Document::SearchStatus status );
+        void stopAllDocumentSearch();
+
+        // index of the words of the document, built in a worker thread
+        void startTextIndex( const QString &docFile );
+        void textIndexJobDone( ThreadWeaver::Job *job );
+        void stopTextIndex();
 
         // generators stuff
         /**
@@ -171,10 +235,30 @@ class DocumentPrivate
          */
         void requestDone( PixmapRequest * request );
         void textGenerationDone( Page *page );
+        void textPageMemoryChanged( Page *page );
+        /**
+         * Decompresses the compressed tiles of the visible pages, so they are
+         * ready to be painted.
+         */
+        void decompressVisibleTiles();
+        /**
+         * Asks the generator to extract in the background the text of the
+         * visible pages and of the pages around them.
+         */
+        void prefetchTextPages();
         /**
          * Sets the bounding box of the given @p page (in terms of upright orientation, i.e., Rotation0).
          */
         void setPageBoundingBox( int page, const NormalizedRect& boundingBox );
+        /**
+         * Notifies the observers about the annotations the generator added to
+         * the given @p page after the document was opened.
+         */
+        void setPageAnnotationsLoaded( int page );
+        /**
+         * Resizes the given pages, and lays out the pages again.
+         */
+        void setPageSizes( const QHash< int, QSizeF > &sizes );
         /**
          * Request a particular metadata of the Document itself (ie, not something
          * depending on the document type/backend).
@@ -189,6 +273,11 @@ class DocumentPrivate
         QMap< int, RunningSearch * > m_searches;
         int m_lastSearchID;
         bool m_searchCancelled;
+        AllDocumentSearch *m_allDocumentSearch;
+        // jobs of the cancelled searches still running
+        QList< TextSearchJob * > m_cancelledTextSearchJobs;
+        TextIndex m_textIndex;
+        TextIndexJob *m_textIndexJob;
 
         // needed because for remote documents docFileName is a local file and
         // we want the remote url when the document refers to relativeNames
@@ -211,13 +300,15 @@ class DocumentPrivate
         // FIXME This is a hack, we need to support
         // multiple tiled observers, but for the moment we only support one
         DocumentObserver *m_tiledObserver;
-        QLinkedList< PixmapRequest * > m_pixmapRequestsStack;
+        PixmapRequestQueue m_pixmapRequestsQueue;
+        PageDiskCache m_pageDiskCache;
+        QString m_pageDiskCacheSettings;
+        RenderStatistics m_renderStatistics;
         QLinkedList< PixmapRequest * > m_executingPixmapRequests;
         QMutex m_pixmapRequestsMutex;
-        QLinkedList< AllocatedPixmap * > m_allocatedPixmaps;
+        AllocatedPixmapIndex m_allocatedPixmaps;
         qulonglong m_allocatedPixmapsTotalMemory;
-        QList< int > m_allocatedTextPagesFifo;
-        int m_maxAllocatedTextPages;
+        TextPageCache m_textPageCache;
         bool m_warnedOutOfMemory;
 
         // the rotation applied to the document
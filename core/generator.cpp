@@ -22,6 +22,8 @@
 #include "document.h"
 #include "document_p.h"
 #include "page.h"
+#include "page_p.h"
+#include "settings_core.h"
 #include "textpage.h"
 #include "utils.h"
 
@@ -29,18 +31,19 @@ using namespace Okular;
 
 GeneratorPrivate::GeneratorPrivate()
     : m_document( 0 ),
-      mPixmapGenerationThread( 0 ), mTextPageGenerationThread( 0 ),
-      m_mutex( 0 ), m_threadsMutex( 0 ), mPixmapReady( true ), mTextPageReady( true ),
+      mTextPageGenerationThread( 0 ),
+      m_mutex( 0 ), m_threadsMutex( 0 ), mRunningPixmapGenerations( 0 ), mTextPageReady( true ),
       m_closing( false ), m_closingLoop( 0 )
 {
 }
 
 GeneratorPrivate::~GeneratorPrivate()
 {
-    if ( mPixmapGenerationThread )
-        mPixmapGenerationThread->wait();
-
-    delete mPixmapGenerationThread;
+    foreach ( PixmapGenerationThread *thread, mPixmapGenerationThreads )
+    {
+        thread->wait();
+        delete thread;
+    }
 
     if ( mTextPageGenerationThread )
         mTextPageGenerationThread->wait();
@@ -51,18 +54,25 @@ GeneratorPrivate::~GeneratorPrivate()
     delete m_threadsMutex;
 }
 
-PixmapGenerationThread* GeneratorPrivate::pixmapGenerationThread()
+PixmapGenerationThread* GeneratorPrivate::idlePixmapGenerationThread()
 {
-    if ( mPixmapGenerationThread )
-        return mPixmapGenerationThread;
+    foreach ( PixmapGenerationThread *thread, mPixmapGenerationThreads )
+    {
+        if ( !thread->request() )
+            return thread;
+    }
+
+    if ( mPixmapGenerationThreads.count() >= maxPixmapGenerations() )
+        return 0;
 
     Q_Q( Generator );
-    mPixmapGenerationThread = new PixmapGenerationThread( q );
-    QObject::connect( mPixmapGenerationThread, SIGNAL(finished()),
+    PixmapGenerationThread *thread = new PixmapGenerationThread( q );
+    QObject::connect( thread, SIGNAL(finished()),
                       q, SLOT(pixmapGenerationFinished()),
                       Qt::QueuedConnection );
+    mPixmapGenerationThreads.append( thread );
 
-    return mPixmapGenerationThread;
+    return thread;
 }
 
 TextPageGenerationThread* GeneratorPrivate::textPageGenerationThread()
@@ -79,33 +89,67 @@ TextPageGenerationThread* GeneratorPrivate::textPageGenerationThread()
     return mTextPageGenerationThread;
 }
 
+int GeneratorPrivate::maxPixmapGenerations() const
+{
+    if ( !m_features.contains( Generator::ThreadSafe ) )
+        return 1;
+
+    const int threads = SettingsCore::renderingThreads();
+    return threads > 0 ? threads : qMax( 1, QThread::idealThreadCount() );
+}
+
 void GeneratorPrivate::pixmapGenerationFinished()
 {
     Q_Q( Generator );
-    PixmapRequest *request = mPixmapGenerationThread->request();
-    mPixmapGenerationThread->endGeneration();
-
-    QMutexLocker locker( threadsLock() );
-    mPixmapReady = true;
 
-    if ( m_closing )
+    // more than one thread may have finished since this slot was queued,
+    // so pick up the results of all of them
+    foreach ( PixmapGenerationThread *thread, mPixmapGenerationThreads )
     {
-        delete request;
-        if ( mTextPageReady )
+        PixmapRequest *request = thread->request();
+        if ( !request || !thread->isFinished() )
+            continue;
+
+        thread->endGeneration();
+
+        QMutexLocker locker( threadsLock() );
+        mRunningPixmapGenerations--;
+
+        if ( m_closing )
         {
-            locker.unlock();
-            m_closingLoop->quit();
+            delete request;
+            if ( mRunningPixmapGenerations == 0 && mTextPageReady )
+            {
+                locker.unlock();
+                m_closingLoop->quit();
+            }
+            continue;
         }
-        return;
-    }
+        locker.unlock();
 
-    const QImage& img = mPixmapGenerationThread->image();
-    request->page()->setPixmap( request->observer(), new QPixmap( QPixmap::fromImage( img ) ), request->normalizedRect() );
-    const int pageNumber = request->page()->number();
+        // a low resolution preview finished after the real pixmap, do not
+        // replace the latter
+        if ( request->d->isObsoletePreview() )
+            request->d->abortRender();
+
+        // the document does not want this pixmap anymore, and the image
+        // may be incomplete
+        if ( request->shouldAbortRender() )
+        {
+            q->signalPixmapRequestDone( request );
+            continue;
+        }
+
+        const QImage& img = thread->image();
+        request->page()->setPixmap( request->observer(), new QPixmap( QPixmap::fromImage( img ) ), request->normalizedRect() );
+        const int pageNumber = request->page()->number();
 
-    if ( mPixmapGenerationThread->calcBoundingBox() )
-        q->updatePageBoundingBox( pageNumber, mPixmapGenerationThread->boundingBox() );
-    q->signalPixmapRequestDone( request );
+        if ( thread->calcBoundingBox() )
+            q->updatePageBoundingBox( pageNumber, thread->boundingBox() );
+        q->signalPixmapRequestDone( request );
+    }
+
+    startTextPagePrefetch();
 }
 
 void GeneratorPrivate::textpageGenerationFinished()
@@ -120,7 +164,7 @@ void GeneratorPrivate::textpageGenerationFinished()
     if ( m_closing )
     {
         delete mTextPageGenerationThread->textPage();
-        if ( mPixmapReady )
+        if ( mRunningPixmapGenerations == 0 )
         {
             locker.unlock();
             m_closingLoop->quit();
@@ -131,8 +175,40 @@ void GeneratorPrivate::textpageGenerationFinished()
     if ( mTextPageGenerationThread->textPage() )
     {
         TextPage *tp = mTextPageGenerationThread->textPage();
-        page->setTextPage( tp );
-        q->signalTextGenerationDone( page, tp );
+        // the page may have got its text in the meanwhile, keep that one
+        if ( page->hasTextPage() )
+            delete tp;
+        else
+        {
+            page->d->setPreparedTextPage( tp );
+            q->signalTextGenerationDone( page, tp );
+        }
+    }
+
+    startTextPagePrefetch();
+}
+
+void GeneratorPrivate::prefetchTextPages( const QList< Page * > &pages )
+{
+    mTextPagePrefetchQueue = pages;
+    startTextPagePrefetch();
+}
+
+void GeneratorPrivate::startTextPagePrefetch()
+{
+    // the pixmaps go first, the prefetch goes on when they are done
+    if ( m_closing || !mTextPageReady || mRunningPixmapGenerations > 0 )
+        return;
+
+    while ( !mTextPagePrefetchQueue.isEmpty() )
+    {
+        Page *page = mTextPagePrefetchQueue.takeFirst();
+        if ( page->hasTextPage() )
+            continue;
+
+        mTextPageReady = false;
+        textPageGenerationThread()->startGeneration( page, QThread::IdlePriority );
+        return;
     }
 }
 
@@ -183,9 +259,10 @@ bool Generator::closeDocument()
     Q_D( Generator );
 
     d->m_closing = true;
+    d->mTextPagePrefetchQueue.clear();
 
     d->threadsLock()->lock();
-    if ( !( d->mPixmapReady && d->mTextPageReady ) )
+    if ( !( d->mRunningPixmapGenerations == 0 && d->mTextPageReady ) )
     {
         QEventLoop loop;
         d->m_closingLoop = &loop;
@@ -211,19 +288,21 @@ bool Generator::closeDocument()
 bool Generator::canGeneratePixmap() const
 {
     Q_D( const Generator );
-    return d->mPixmapReady;
+    return d->mRunningPixmapGenerations < d->maxPixmapGenerations();
 }
 
 void Generator::generatePixmap( PixmapRequest *request )
 {
     Q_D( Generator );
-    d->mPixmapReady = false;
+    d->mRunningPixmapGenerations++;
 
-    const bool calcBoundingBox = !request->isTile() && !request->page()->isBoundingBoxKnown();
+    // a low resolution preview would give an imprecise bounding box
+    const bool calcBoundingBox = !request->isTile() && !request->d->mPreview && !request->page()->isBoundingBoxKnown();
 
-    if ( request->asynchronous() && hasFeature( Threaded ) )
+    PixmapGenerationThread *thread = ( request->asynchronous() && hasFeature( Threaded ) ) ? d->idlePixmapGenerationThread() : 0;
+    if ( thread )
     {
-        d->pixmapGenerationThread()->startGeneration( request, calcBoundingBox );
+        thread->startGeneration( request, calcBoundingBox );
 
         /**
          * We create the text page for every page that is visible to the
@@ -238,10 +317,13 @@ void Generator::generatePixmap( PixmapRequest *request )
     }
 
     const QImage& img = image( request );
+    request->d->mTimes.rendered = RenderStatistics::timestamp();
     request->page()->setPixmap( request->observer(), new QPixmap( QPixmap::fromImage( img ) ), request->normalizedRect() );
+    if ( d->m_document )
+        d->m_document->storeCachedPixmap( request, img );
     const int pageNumber = request->page()->number();
 
-    d->mPixmapReady = true;
+    d->mRunningPixmapGenerations--;
 
     signalPixmapRequestDone( request );
     if ( calcBoundingBox )
@@ -405,6 +487,12 @@ QMutex* Generator::userMutex() const
     return d->m_mutex;
 }
 
+int Generator::maxConcurrentPixmapRequests() const
+{
+    Q_D( const Generator );
+    return d->maxPixmapGenerations();
+}
+
 void Generator::updatePageBoundingBox( int page, const NormalizedRect & boundingBox )
 {
     Q_D( Generator );
@@ -412,6 +500,20 @@ void Generator::updatePageBoundingBox( int page, const NormalizedRect & bounding
         d->m_document->setPageBoundingBox( page, boundingBox );
 }
 
+void Generator::updatePageAnnotations( int page )
+{
+    Q_D( Generator );
+    if ( d->m_document ) // still connected to document?
+        d->m_document->setPageAnnotationsLoaded( page );
+}
+
+void Generator::updatePageSizes( const QHash< int, QSizeF > &sizes )
+{
+    Q_D( Generator );
+    if ( d->m_document ) // still connected to document?
+        d->m_document->setPageSizes( sizes );
+}
+
 void Generator::requestFontData(const Okular::FontInfo & /*font*/, QByteArray * /*data*/)
 {
 
@@ -422,6 +524,10 @@ const SourceReference * Generator::dynamicSourceReference( int /*pageNr*/, doubl
   return 0;
 }
 
+void Generator::cacheMemoryChanged()
+{
+}
+
 PixmapRequest::PixmapRequest( DocumentObserver *observer, int pageNumber, int width, int height, int priority, PixmapRequestFeatures features )
   : d( new PixmapRequestPrivate )
 {
@@ -433,7 +539,9 @@ PixmapRequest::PixmapRequest( DocumentObserver *observer, int pageNumber, int wi
     d->mFeatures = features;
     d->mForce = false;
     d->mTile = false;
+    d->mPreview = false;
     d->mNormalizedRect = NormalizedRect();
+    d->mShouldAbortRender = 0;
 }
 
 PixmapRequest::~PixmapRequest()
@@ -504,11 +612,30 @@ const NormalizedRect& PixmapRequest::normalizedRect() const
     return d->mNormalizedRect;
 }
 
+bool PixmapRequest::shouldAbortRender() const
+{
+    return d->mShouldAbortRender != 0;
+}
+
 void PixmapRequestPrivate::swap()
 {
     qSwap( mWidth, mHeight );
 }
 
+void PixmapRequestPrivate::abortRender()
+{
+    mShouldAbortRender = 1;
+}
+
+bool PixmapRequestPrivate::isObsoletePreview() const
+{
+    if ( !mPreview )
+        return false;
+
+    const PagePrivate *page = mPage->d;
+    return page->m_pixmaps.contains( mObserver ) || ( mObserver == page->m_doc->m_tiledObserver && page->m_tilesManager );
+}
+
 class Okular::ExportFormatPrivate : public QSharedData
 {
     public:
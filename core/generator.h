@@ -17,9 +17,11 @@
 #include "global.h"
 #include "pagesize.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QObject>
 #include <QtCore/QSharedDataPointer>
+#include <QtCore/QSize>
 #include <QtCore/QString>
 #include <QtCore/QVariant>
 #include <QtCore/QVector>
@@ -187,6 +189,8 @@ class OKULAR_EXPORT Generator : public QObject
     /// @cond PRIVATE
     friend class PixmapGenerationThread;
     friend class TextPageGenerationThread;
+    friend class TextSearchJob;
+    friend class TextIndexJob;
     /// @endcond
 
     Q_OBJECT
@@ -206,7 +210,8 @@ class OKULAR_EXPORT Generator : public QObject
             PrintNative,       ///< Whether the Generator supports native cross-platform printing (QPainter-based).
             PrintPostscript,   ///< Whether the Generator supports postscript-based file printing.
             PrintToFile,       ///< Whether the Generator supports export to PDF & PS through the Print Dialog
-            TiledRendering     ///< Whether the Generator can render tiles @since 0.16 (KDE 4.10)
+            TiledRendering,    ///< Whether the Generator can render tiles @since 0.16 (KDE 4.10)
+            ThreadSafe         ///< Whether image() can be called concurrently from several threads, so that many pages can be rendered in parallel @since 0.17 (KDE 4.11)
         };
 
         /**
@@ -248,6 +253,9 @@ class OKULAR_EXPORT Generator : public QObject
         /**
          * This method returns whether the generator is ready to
          * handle a new pixmap request.
+         *
+         * Generators with the @ref ThreadSafe feature are ready as long as
+         * one of their rendering threads is idle.
          */
         virtual bool canGeneratePixmap() const;
 
@@ -364,6 +372,16 @@ class OKULAR_EXPORT Generator : public QObject
         /**
          * This method returns the meta data of the given @p key with the given @p option
          * of the document.
+         *
+         * Generators with their own settings changing the rendered pages
+         * answer the "RenderSettings" key with a string describing them, so
+         * that the pages rendered with other settings are not taken from the
+         * disk cache (since 0.17, KDE 4.11).
+         *
+         * Generators with their own caches answer the "CacheMemoryUsage" key
+         * with the memory in bytes they use, that the Document counts in its
+         * memory budget; it is asked while the pages are rendered (since
+         * 0.17, KDE 4.11).
          */
         virtual QVariant metaData( const QString &key, const QVariant &option ) const;
 
@@ -433,7 +451,8 @@ class OKULAR_EXPORT Generator : public QObject
          * the passed pixmap @p request.
          *
          * @warning this method may be executed in its own separated thread if the
-         * @ref Threaded is enabled!
+         * @ref Threaded is enabled, and concurrently in several threads if the
+         * @ref ThreadSafe feature is enabled too!
          */
         virtual QImage image( PixmapRequest *page );
 
@@ -466,6 +485,15 @@ class OKULAR_EXPORT Generator : public QObject
          */
         QMutex* userMutex() const;
 
+        /**
+         * Returns how many pixmap requests the generator can be asked to render
+         * at the same time, as configured by the user; 1 if the generator has
+         * not the ThreadSafe feature.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        int maxConcurrentPixmapRequests() const;
+
         /**
          * Set the bounding box of a page after the page has already been handed
          * to the Document. Call this instead of Page::setBoundingBox() to ensure
@@ -475,6 +503,25 @@ class OKULAR_EXPORT Generator : public QObject
          */
         void updatePageBoundingBox( int page, const NormalizedRect & boundingBox );
 
+        /**
+         * Tell the Document that annotations have been added to a page after
+         * the page has already been handed to the Document, so that all
+         * observers are notified.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        void updatePageAnnotations( int page );
+
+        /**
+         * Set the sizes of pages after the pages have already been handed to
+         * the Document, for generators that do not know all of them when
+         * loading the document. @p sizes maps the page numbers to their
+         * sizes; all observers are notified once for all the pages.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        void updatePageSizes( const QHash< int, QSizeF > &sizes );
+
     protected Q_SLOTS:
         /**
          * Gets the font data for the given font
@@ -498,6 +545,16 @@ class OKULAR_EXPORT Generator : public QObject
          */
         Okular::Generator::PrintError printError() const;
 
+        /**
+         * Called when the memory the Document leaves to the caches of the
+         * generator, as documentMetaData( "CacheMemory" ) returns it, changed
+         * with the memory level or budget. Generators with their own caches
+         * reimplement this slot to read it again.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        void cacheMemoryChanged();
+
     protected:
         /// @cond PRIVATE
         Generator( GeneratorPrivate &dd, QObject *parent, const QVariantList &args );
@@ -522,6 +579,9 @@ class OKULAR_EXPORT PixmapRequest
 {
     friend class Document;
     friend class DocumentPrivate;
+    friend class Generator;
+    friend class GeneratorPrivate;
+    friend class PixmapGenerationThread;
 
     public:
         enum PixmapRequestFeature
@@ -625,6 +685,21 @@ class OKULAR_EXPORT PixmapRequest
          */
         const NormalizedRect& normalizedRect() const;
 
+        /**
+         * Returns whether the generator should stop rendering this request
+         * as soon as possible, because its result is not needed anymore
+         * (e.g. the user scrolled far away from the page).
+         *
+         * Generators that render in several steps can poll this from
+         * image() and return a null image when it becomes true. The result
+         * of an aborted request is discarded anyway.
+         *
+         * It is safe to call this method from the rendering thread.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        bool shouldAbortRender() const;
+
     private:
         Q_DISABLE_COPY( PixmapRequest )
 
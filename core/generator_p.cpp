@@ -11,8 +11,11 @@
 
 #include <kdebug.h>
 
+#include "document_p.h"
 #include "fontinfo.h"
 #include "generator.h"
+#include "page.h"
+#include "page_p.h"
 #include "utils.h"
 
 using namespace Okular;
@@ -59,23 +62,37 @@ void PixmapGenerationThread::run()
 {
     mImage = QImage();
 
-    if ( mRequest )
+    // the request may have been cancelled while waiting for the thread to start
+    if ( mRequest && !mRequest->shouldAbortRender() )
     {
-        mImage = mGenerator->image( mRequest );
-        if ( mCalcBoundingBox )
+        // a page rendered in a previous session is read here, off the GUI
+        // thread, instead of rendering it again
+        DocumentPrivate *document = mGenerator->d_func()->m_document;
+        if ( document )
+            mImage = document->loadCachedImage( mRequest );
+        const bool cached = !mImage.isNull();
+        if ( !cached )
+            mImage = mGenerator->image( mRequest );
+        mRequest->d->mTimes.rendered = RenderStatistics::timestamp();
+        if ( mCalcBoundingBox && !mRequest->shouldAbortRender() )
             mBoundingBox = Utils::imageBoundingBox( &mImage );
+
+        // queue it to be saved for the next time
+        if ( document && !cached && !mRequest->shouldAbortRender() )
+            document->storeCachedPixmap( mRequest, mImage );
     }
 }
 
 
 TextPageGenerationThread::TextPageGenerationThread( Generator *generator )
-    : mGenerator( generator ), mPage( 0 )
+    : mGenerator( generator ), mPage( 0 ), mPriority( QThread::InheritPriority )
 {
 }
 
-void TextPageGenerationThread::startGeneration( Page *page )
+void TextPageGenerationThread::startGeneration( Page *page, QThread::Priority priority )
 {
     mPage = page;
+    mPriority = priority;
 
     start( QThread::InheritPriority );
 }
@@ -100,7 +117,21 @@ void TextPageGenerationThread::run()
     mTextPage = 0;
 
     if ( mPage )
+    {
+        // the generator may hold its locks while extracting the text, so a
+        // lower priority would make the pixmap generations waiting for them
+        // wait for this thread to get some time too
         mTextPage = mGenerator->textPage( mPage );
+
+        // order the text here, not in the GUI thread, and at the requested
+        // priority, as no lock of the generator is held anymore
+        if ( mTextPage )
+        {
+            if ( mPriority != QThread::InheritPriority )
+                setPriority( mPriority );
+            mPage->d->prepareTextPage( mTextPage );
+        }
+    }
 }
 
 
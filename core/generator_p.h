@@ -11,7 +11,10 @@
 #define OKULAR_THREADEDGENERATOR_P_H
 
 #include "area.h"
+#include "renderstatistics_p.h"
 
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
 #include <QtCore/QSet>
 #include <QtCore/QThread>
 #include <QtGui/QImage>
@@ -41,12 +44,32 @@ class GeneratorPrivate
         Q_DECLARE_PUBLIC( Generator )
         Generator *q_ptr;
 
-        PixmapGenerationThread* pixmapGenerationThread();
+        /**
+         * Returns an idle pixmap generation thread, creating a new one if
+         * all of them are busy and the pool can still grow; returns 0 if
+         * every allowed thread is busy.
+         */
+        PixmapGenerationThread* idlePixmapGenerationThread();
         TextPageGenerationThread* textPageGenerationThread();
 
+        /**
+         * The number of pixmaps that can be generated at the same time:
+         * always 1, unless the generator is ThreadSafe.
+         */
+        int maxPixmapGenerations() const;
+
         void pixmapGenerationFinished();
         void textpageGenerationFinished();
 
+        /**
+         * Extracts in the text page generation thread, one at a time and
+         * only while no pixmap is being generated, the text of the @p pages
+         * that do not have it yet, in their order; the text is ordered at
+         * idle priority. Replaces the pages of the previous call.
+         */
+        void prefetchTextPages( const QList< Page * > &pages );
+        void startTextPagePrefetch();
+
         QMutex* threadsLock();
 
         virtual QVariant metaData( const QString &key, const QVariant &option ) const;
@@ -56,11 +79,12 @@ class GeneratorPrivate
         // NOTE: the following should be a QSet< GeneratorFeature >,
         // but it is not to avoid #include'ing generator.h
         QSet< int > m_features;
-        PixmapGenerationThread *mPixmapGenerationThread;
+        QList< PixmapGenerationThread * > mPixmapGenerationThreads;
         TextPageGenerationThread *mTextPageGenerationThread;
+        QList< Page * > mTextPagePrefetchQueue;
         mutable QMutex *m_mutex;
         QMutex *m_threadsMutex;
-        bool mPixmapReady : 1;
+        int mRunningPixmapGenerations;
         bool mTextPageReady : 1;
         bool m_closing : 1;
         QEventLoop *m_closingLoop;
@@ -72,6 +96,18 @@ class PixmapRequestPrivate
     public:
         void swap();
 
+        /**
+         * Asks the generator to stop working on the request, see
+         * PixmapRequest::shouldAbortRender().
+         */
+        void abortRender();
+
+        /**
+         * Whether this is a low resolution preview that is not useful
+         * anymore because the page already got a pixmap.
+         */
+        bool isObsoletePreview() const;
+
         DocumentObserver *mObserver;
         int mPageNumber;
         int mWidth;
@@ -80,8 +116,11 @@ class PixmapRequestPrivate
         int mFeatures;
         bool mForce : 1;
         bool mTile : 1;
+        bool mPreview : 1;
         Page *mPage;
         NormalizedRect mNormalizedRect;
+        QAtomicInt mShouldAbortRender;
+        RenderStatistics::Times mTimes;
 };
 
 
@@ -121,7 +160,7 @@ class TextPageGenerationThread : public QThread
     public:
         TextPageGenerationThread( Generator *generator );
 
-        void startGeneration( Page *page );
+        void startGeneration( Page *page, QThread::Priority priority = QThread::InheritPriority );
 
         void endGeneration();
 
@@ -136,6 +175,7 @@ class TextPageGenerationThread : public QThread
         Generator *mGenerator;
         Page *mPage;
         TextPage *mTextPage;
+        QThread::Priority mPriority;
 };
 
 class FontExtractionThread : public QThread
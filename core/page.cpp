@@ -11,6 +11,7 @@
 
 // qt/kde includes
 #include <QtCore/QHash>
+#include <QtCore/QRegExp>
 #include <QtCore/QSet>
 #include <QtCore/QString>
 #include <QtCore/QVariant>
@@ -88,8 +89,61 @@ PagePrivate::~PagePrivate()
 }
 
 
+const QPixmap *PagePrivate::sharablePixmap( DocumentObserver *observer, int width, int height ) const
+{
+    if ( width <= 0 || height <= 0 )
+        return 0;
+
+    const double aspectRatio = (double)width / (double)height;
+    const QPixmap *pixmap = 0;
+    QMap< DocumentObserver*, PixmapObject >::const_iterator it = m_pixmaps.constBegin(), end = m_pixmaps.constEnd();
+    for ( ; it != end; ++it )
+    {
+        // pixmaps still being rotated are not usable
+        if ( it.key() == observer || (*it).m_rotation != m_rotation )
+            continue;
+
+        const QPixmap *candidate = (*it).m_pixmap;
+        if ( candidate->width() < width || candidate->height() < height )
+            continue;
+
+        // the observers round the page sizes differently, but they must be
+        // showing the same area of the page
+        const double candidateAspectRatio = (double)candidate->width() / (double)candidate->height();
+        if ( qAbs( candidateAspectRatio - aspectRatio ) > 0.01 * aspectRatio )
+            continue;
+
+        if ( !pixmap || candidate->width() < pixmap->width() )
+            pixmap = candidate;
+    }
+    return pixmap;
+}
+
+void PagePrivate::setSharedPixmap( DocumentObserver *observer, const QPixmap *source, int width, int height )
+{
+    QPixmap *pixmap;
+    if ( source->width() == width && source->height() == height )
+        pixmap = new QPixmap( *source );
+    else
+        pixmap = new QPixmap( source->scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation ) );
+
+    QMap< DocumentObserver*, PixmapObject >::iterator it = m_pixmaps.find( observer );
+    if ( it != m_pixmaps.end() )
+    {
+        delete it.value().m_pixmap;
+    }
+    else
+    {
+        it = m_pixmaps.insert( observer, PixmapObject() );
+    }
+    it.value().m_pixmap = pixmap;
+    it.value().m_rotation = m_rotation;
+}
+
 void PagePrivate::imageRotationDone( RotationJob * job )
 {
+    m_doc->m_renderStatistics.addRotation( m_number, job->startTime(), job->finishTime() );
+
     TilesManager *tm = ( job->observer() == m_doc->m_tiledObserver ) ? m_tilesManager : 0;
     if ( tm )
     {
@@ -310,6 +364,25 @@ RegularAreaRect * Page::findText( int id, const QString & text, SearchDirection
     return rect;
 }
 
+RegularAreaRect * Page::findText( int id, const QString & text, SearchDirection direction,
+                                  Qt::CaseSensitivity caseSensitivity, TextPage::TextComparison comparison,
+                                  const RegularAreaRect *lastRect ) const
+{
+    if ( text.isEmpty() || !d->m_text )
+        return 0;
+
+    return d->m_text->findText( id, text, direction, caseSensitivity, comparison, lastRect );
+}
+
+RegularAreaRect * Page::findText( int id, const QRegExp & regExp, SearchDirection direction,
+                                  const RegularAreaRect *lastRect ) const
+{
+    if ( regExp.isEmpty() || !d->m_text )
+        return 0;
+
+    return d->m_text->findText( id, regExp, direction, lastRect );
+}
+
 QString Page::text( const RegularAreaRect * area ) const
 {
     return text( area, TextPage::AnyPixelTextAreaInclusionBehaviour );
@@ -536,17 +609,30 @@ void Page::setPixmap( DocumentObserver *observer, QPixmap *pixmap, const Normali
 
 void Page::setTextPage( TextPage * textPage )
 {
-    delete d->m_text;
+    if ( textPage )
+        d->prepareTextPage( textPage );
+    d->setPreparedTextPage( textPage );
+}
 
-    d->m_text = textPage;
-    if ( d->m_text )
-    {
-        d->m_text->d->m_page = d;
-        /**
-         * Correct text order for before text selection
-         */
-        d->m_text->d->correctTextOrder();
-    }
+void PagePrivate::prepareTextPage( TextPage *textPage )
+{
+    textPage->d->m_page = this;
+    /**
+     * Correct text order for before text selection
+     */
+    textPage->d->correctTextOrder();
+}
+
+void PagePrivate::setPreparedTextPage( TextPage *textPage )
+{
+    delete m_text;
+
+    m_text = textPage;
+}
+
+qulonglong PagePrivate::textPageMemory() const
+{
+    return m_text ? m_text->d->memoryUsage() : 0;
 }
 
 void Page::setObjectRects( const QLinkedList< ObjectRect * > & rects )
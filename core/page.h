@@ -185,6 +185,40 @@ class OKULAR_EXPORT Page
         RegularAreaRect* findText( int id, const QString & text, SearchDirection direction,
                                    Qt::CaseSensitivity caseSensitivity, const RegularAreaRect * lastRect=0) const;
 
+        /**
+         * Returns the bounding rect of the text which matches the following criteria
+         * or 0 if the search is not successful.
+         *
+         * @param id An unique id for this search.
+         * @param text The search text.
+         * @param direction The direction of the search (@ref SearchDirection)
+         * @param caseSensitivity If Qt::CaseSensitive, the search is case sensitive; otherwise
+         *                        the search is case insensitive. Ignored by the loose comparisons.
+         * @param comparison How the texts are compared (@ref TextPage::TextComparison)
+         * @param lastRect If 0 (default) the search starts at the beginning of the page, otherwise
+         *                 right/below the coordinates of the given rect.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        RegularAreaRect* findText( int id, const QString & text, SearchDirection direction,
+                                   Qt::CaseSensitivity caseSensitivity, TextPage::TextComparison comparison,
+                                   const RegularAreaRect * lastRect=0) const;
+
+        /**
+         * Returns the bounding rect of the text which matches the regular
+         * expression @p regExp or 0 if the search is not successful.
+         *
+         * @param id An unique id for this search.
+         * @param regExp The regular expression to search, with its case sensitivity.
+         * @param direction The direction of the search (@ref SearchDirection)
+         * @param lastRect If 0 (default) the search starts at the beginning of the page, otherwise
+         *                 right/below the coordinates of the given rect.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        RegularAreaRect* findText( int id, const QRegExp & regExp, SearchDirection direction,
+                                   const RegularAreaRect * lastRect=0) const;
+
         /**
          * Returns the page text (or part of it).
          * @see TextPage::text()
@@ -391,6 +425,9 @@ class OKULAR_EXPORT Page
         friend class PagePrivate;
         friend class Document;
         friend class DocumentPrivate;
+        friend class TextSearchJob;
+        friend class TextIndexJob;
+        friend class TextPageGenerationThread;
 
         /**
          * To improve performance PagePainter accesses the following
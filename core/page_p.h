@@ -104,6 +104,37 @@ class PagePrivate
          */
         void deleteTextSelections();
 
+        /**
+         * Does on @p textPage the preparation work that Page::setTextPage()
+         * would do, so that it can be done out of the GUI thread.
+         */
+        void prepareTextPage( TextPage *textPage );
+
+        /**
+         * Sets @p textPage, already prepared with prepareTextPage(), as the
+         * text page of the page.
+         */
+        void setPreparedTextPage( TextPage *textPage );
+
+        /**
+         * Returns the memory used by the text page, in bytes, 0 if there is none.
+         */
+        qulonglong textPageMemory() const;
+
+        /**
+         * Returns the pixmap of another observer that can be scaled down to
+         * @p width x @p height (in the current rotation), or 0 if there is
+         * none. The smallest suitable pixmap is returned.
+         */
+        const QPixmap *sharablePixmap( DocumentObserver *observer, int width, int height ) const;
+
+        /**
+         * Sets the pixmap of @p observer to a scaled copy of @p source, that
+         * is a pixmap of the page in the current rotation. If they have the
+         * same size the pixel data is shared rather than copied.
+         */
+        void setSharedPixmap( DocumentObserver *observer, const QPixmap *source, int width, int height );
+
         /**
          * Get/set the tiles manager for the tiled observer
          */
@@ -0,0 +1,384 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "pagediskcache_p.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+#include <QtCore/QtAlgorithms>
+
+#include <kdebug.h>
+#include <kde_file.h>
+#include <kstandarddirs.h>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+// bytes hashed at the beginning and at the end of the document to identify it
+#define OKULAR_PAGECACHE_HASHEDBYTES 65536
+#define OKULAR_PAGECACHE_MAGIC 0x4f4b5043 // 'OKPC'
+#define OKULAR_PAGECACHE_VERSION 1
+
+namespace {
+
+// header of the cache files, followed by the image data
+struct ImageHeader
+{
+    qint32 magic;
+    qint32 version;
+    qint32 width;
+    qint32 height;
+    qint32 format;
+    qint32 bytesPerLine;
+};
+
+bool entryLessRecentlyUsed( const QPair< uint, QString > &e1, const QPair< uint, QString > &e2 )
+{
+    return e1.first < e2.first;
+}
+
+}
+
+class PageDiskCache::WriterThread : public QThread
+{
+    public:
+        WriterThread( PageDiskCache *cache )
+            : m_cache( cache )
+        {
+        }
+
+    protected:
+        void run()
+        {
+            m_cache->writePendingImages();
+        }
+
+    private:
+        PageDiskCache *m_cache;
+};
+
+QString PageDiskCache::documentKey( const QString &fileName, const QString &generatorName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return QString();
+
+    // hashing the whole file would take too long for big documents: the
+    // size, the modification time, the beginning and the end of the file
+    // identify it well enough
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    hash.addData( generatorName.toUtf8() );
+    hash.addData( QByteArray::number( file.size() ) );
+    hash.addData( QByteArray::number( QFileInfo( file ).lastModified().toMSecsSinceEpoch() ) );
+    hash.addData( file.read( OKULAR_PAGECACHE_HASHEDBYTES ) );
+    if ( file.size() > 2 * OKULAR_PAGECACHE_HASHEDBYTES )
+    {
+        file.seek( file.size() - OKULAR_PAGECACHE_HASHEDBYTES );
+        hash.addData( file.read( OKULAR_PAGECACHE_HASHEDBYTES ) );
+    }
+    return QString::fromLatin1( hash.result().toHex() );
+}
+
+PageDiskCache::PageDiskCache()
+    : m_writer( new WriterThread( this ) ), m_writing( false ), m_maxSize( 0 ), m_totalSize( 0 )
+{
+}
+
+PageDiskCache::~PageDiskCache()
+{
+    close();
+    delete m_writer;
+}
+
+void PageDiskCache::open( const QString &fileName, const QString &generatorName, qint64 maxSize )
+{
+    close();
+
+    const QString key = documentKey( fileName, generatorName );
+    if ( key.isEmpty() )
+        return;
+
+    QMutexLocker locker( &m_mutex );
+    m_root = KStandardDirs::locateLocal( "cache", "okular/pages/" );
+    m_dir = m_root + key + '/';
+    if ( !QDir().mkpath( m_dir ) )
+    {
+        kWarning(OkularDebug) << "Cannot create the page cache directory" << m_dir;
+        m_dir.clear();
+        return;
+    }
+    m_maxSize = maxSize;
+
+    // index the whole cache, other documents (or other instances) may have
+    // added or removed files since the last time
+    m_entries.clear();
+    m_totalSize = 0;
+    QDirIterator it( m_root, QDir::Files, QDirIterator::Subdirectories );
+    while ( it.hasNext() )
+    {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        if ( info.suffix() == QLatin1String( "part" ) )
+            continue;
+        Entry entry;
+        entry.size = info.size();
+        entry.lastUsed = info.lastModified().toTime_t();
+        m_entries.insert( info.filePath(), entry );
+        m_totalSize += entry.size;
+    }
+
+    trim();
+}
+
+void PageDiskCache::close()
+{
+    QMutexLocker locker( &m_mutex );
+    m_dir.clear();
+    m_pending.clear();
+    locker.unlock();
+
+    // let the writer finish the image it is writing
+    m_writer->wait();
+}
+
+bool PageDiskCache::isOpen() const
+{
+    return !m_dir.isEmpty();
+}
+
+bool PageDiskCache::contains( int page, int width, int height, int rotation, const QString &settings )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_dir.isEmpty() )
+        return false;
+
+    const QString path = m_dir + entryName( page, width, height, rotation, settings );
+    return m_entries.contains( path ) || !pendingImage( path ).isNull();
+}
+
+QImage PageDiskCache::load( int page, int width, int height, int rotation, const QString &settings )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_dir.isEmpty() )
+        return QImage();
+
+    const QString path = m_dir + entryName( page, width, height, rotation, settings );
+    const QImage pending = pendingImage( path );
+    if ( !pending.isNull() )
+        return pending;
+    if ( !m_entries.contains( path ) )
+        return QImage();
+    touch( path );
+    locker.unlock();
+
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) || file.size() < (qint64)sizeof( ImageHeader ) )
+        return QImage();
+
+    uchar *data = file.map( 0, file.size() );
+    if ( !data )
+        return QImage();
+
+    QImage image;
+    const ImageHeader *header = reinterpret_cast< const ImageHeader * >( data );
+    if ( header->magic == OKULAR_PAGECACHE_MAGIC && header->version == OKULAR_PAGECACHE_VERSION
+         && header->width == width && header->height == height
+         && file.size() == (qint64)sizeof( ImageHeader ) + (qint64)header->bytesPerLine * header->height )
+    {
+        // copy the data, the mapping goes away with the file
+        const QImage mapped( data + sizeof( ImageHeader ), header->width, header->height, header->bytesPerLine, (QImage::Format)header->format );
+        image = mapped.copy();
+    }
+    file.unmap( data );
+    return image;
+}
+
+void PageDiskCache::store( int page, int width, int height, int rotation, const QString &settings, const QImage &image )
+{
+    if ( image.isNull() )
+        return;
+
+    QMutexLocker locker( &m_mutex );
+    if ( m_dir.isEmpty() )
+        return;
+
+    const QString path = m_dir + entryName( page, width, height, rotation, settings );
+    if ( m_entries.contains( path ) || !pendingImage( path ).isNull() )
+        return;
+
+    // the image is implicitly shared, queueing it costs no copy
+    PendingImage pending;
+    pending.path = path;
+    pending.image = image;
+    m_pending.append( pending );
+
+    if ( !m_writing )
+    {
+        m_writing = true;
+        locker.unlock();
+        // the writer may still be returning from its previous run
+        m_writer->wait();
+        m_writer->start( QThread::LowPriority );
+    }
+}
+
+QImage PageDiskCache::pendingImage( const QString &path ) const
+{
+    foreach ( const PendingImage &pending, m_pending )
+    {
+        if ( pending.path == path )
+            return pending.image;
+    }
+    return QImage();
+}
+
+void PageDiskCache::writePendingImages()
+{
+    QMutexLocker locker( &m_mutex );
+    while ( !m_pending.isEmpty() )
+    {
+        // the image stays queued while it is written, so that load() finds it
+        const PendingImage pending = m_pending.first();
+        locker.unlock();
+        const bool written = write( pending.path, pending.image );
+        locker.relock();
+
+        // close() or clear() may have dropped it meanwhile
+        if ( !m_pending.isEmpty() && m_pending.first().path == pending.path )
+            m_pending.removeFirst();
+        else if ( written )
+        {
+            QFile::remove( pending.path );
+            continue;
+        }
+
+        if ( written )
+        {
+            Entry entry;
+            entry.size = sizeof( ImageHeader ) + pending.image.byteCount();
+            entry.lastUsed = QDateTime::currentDateTime().toTime_t();
+            m_entries.insert( pending.path, entry );
+            m_totalSize += entry.size;
+            trim();
+        }
+    }
+    m_writing = false;
+}
+
+bool PageDiskCache::write( const QString &path, const QImage &image )
+{
+    ImageHeader header;
+    header.magic = OKULAR_PAGECACHE_MAGIC;
+    header.version = OKULAR_PAGECACHE_VERSION;
+    header.width = image.width();
+    header.height = image.height();
+    header.format = image.format();
+    header.bytesPerLine = image.bytesPerLine();
+
+    // write to a temporary file, so that load() never sees half written files
+    const QString tempPath = path + QLatin1String( ".part" );
+    QFile file( tempPath );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+    bool ok = file.write( reinterpret_cast< const char * >( &header ), sizeof( header ) ) == (qint64)sizeof( header );
+    ok = ok && file.write( reinterpret_cast< const char * >( image.constBits() ), image.byteCount() ) == image.byteCount();
+    file.close();
+    if ( !ok || !QFile::rename( tempPath, path ) )
+    {
+        QFile::remove( tempPath );
+        return false;
+    }
+    return true;
+}
+
+void PageDiskCache::removePage( int page )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_dir.isEmpty() )
+        return;
+
+    removeEntries( m_dir + QString::number( page ) + '-' );
+}
+
+void PageDiskCache::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_dir.isEmpty() )
+        return;
+
+    removeEntries( m_dir );
+}
+
+QString PageDiskCache::entryName( int page, int width, int height, int rotation, const QString &settings ) const
+{
+    return QString( "%1-%2x%3-%4-%5" ).arg( page ).arg( width ).arg( height ).arg( rotation ).arg( settings );
+}
+
+void PageDiskCache::removeEntries( const QString &prefix )
+{
+    QList< PendingImage >::iterator pIt = m_pending.begin();
+    while ( pIt != m_pending.end() )
+    {
+        if ( pIt->path.startsWith( prefix ) )
+            pIt = m_pending.erase( pIt );
+        else
+            ++pIt;
+    }
+
+    QHash< QString, Entry >::iterator it = m_entries.begin();
+    while ( it != m_entries.end() )
+    {
+        if ( it.key().startsWith( prefix ) )
+        {
+            QFile::remove( it.key() );
+            m_totalSize -= it.value().size;
+            it = m_entries.erase( it );
+        }
+        else
+            ++it;
+    }
+}
+
+void PageDiskCache::touch( const QString &path )
+{
+    // the modification time keeps the LRU order across sessions
+    m_entries[ path ].lastUsed = QDateTime::currentDateTime().toTime_t();
+    KDE::utime( path, 0 );
+}
+
+void PageDiskCache::trim()
+{
+    if ( m_totalSize <= m_maxSize )
+        return;
+
+    // remove the least recently used files until we are 10% below the limit,
+    // so that we do not have to do this again for every stored page
+    QList< QPair< uint, QString > > entries;
+    QHash< QString, Entry >::const_iterator it = m_entries.constBegin(), end = m_entries.constEnd();
+    for ( ; it != end; ++it )
+        entries.append( qMakePair( it.value().lastUsed, it.key() ) );
+    qSort( entries.begin(), entries.end(), entryLessRecentlyUsed );
+
+    const qint64 targetSize = m_maxSize / 10 * 9;
+    for ( int i = 0; i < entries.count() && m_totalSize > targetSize; ++i )
+    {
+        const QString &path = entries.at( i ).second;
+        QFile::remove( path );
+        m_totalSize -= m_entries.take( path ).size;
+    }
+}
+
+/* kate: replace-tabs on; indent-width 4; */
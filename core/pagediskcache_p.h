@@ -0,0 +1,132 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_PAGEDISKCACHE_P_H_
+#define _OKULAR_PAGEDISKCACHE_P_H_
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+namespace Okular {
+
+/**
+ * Cache of rendered pages stored on disk, so that reopening a document
+ * does not require rendering again the pages that were already seen.
+ *
+ * The images of a document are stored in a directory named after a hash of
+ * the document contents, one uncompressed file per rendered image, that is
+ * memory mapped when read back. The size of the whole cache (shared by all
+ * the documents) is bounded, the least recently used images being removed
+ * first.
+ *
+ * The images are written by a thread of the cache, store() only queues
+ * them. load() and store() can be called from any thread.
+ */
+class PageDiskCache
+{
+    public:
+        PageDiskCache();
+        ~PageDiskCache();
+
+        /**
+         * Starts caching the pages of the document @p fileName rendered by
+         * the generator @p generatorName, using at most @p maxSize bytes of
+         * disk for the whole cache.
+         */
+        void open( const QString &fileName, const QString &generatorName, qint64 maxSize );
+
+        /**
+         * Stops caching, the stored images are kept for the next time. The
+         * images not written yet are dropped.
+         */
+        void close();
+
+        bool isOpen() const;
+
+        /**
+         * Returns whether an image is stored for the given parameters, without
+         * reading it.
+         */
+        bool contains( int page, int width, int height, int rotation, const QString &settings );
+
+        /**
+         * Returns the image stored for the given parameters, or a null image.
+         * The @p settings tell apart the images rendered with different
+         * rendering settings.
+         */
+        QImage load( int page, int width, int height, int rotation, const QString &settings );
+
+        /**
+         * Queues @p image to be stored for the given parameters.
+         */
+        void store( int page, int width, int height, int rotation, const QString &settings, const QImage &image );
+
+        /**
+         * Removes all the images of the given @p page of the current document.
+         */
+        void removePage( int page );
+
+        /**
+         * Removes all the images of the current document, e.g. because the
+         * rendering settings of the generator changed.
+         */
+        void clear();
+
+        /**
+         * Returns a key identifying the contents of the document @p fileName
+         * as read by the generator @p generatorName, or an empty string if
+         * the file cannot be read. The key changes when the file is modified.
+         */
+        static QString documentKey( const QString &fileName, const QString &generatorName );
+
+    private:
+        class WriterThread;
+        friend class WriterThread;
+
+        struct Entry
+        {
+            qint64 size;
+            uint lastUsed;
+        };
+
+        struct PendingImage
+        {
+            QString path;
+            QImage image;
+        };
+
+        QString entryName( int page, int width, int height, int rotation, const QString &settings ) const;
+        QImage pendingImage( const QString &path ) const;
+        void writePendingImages();
+        bool write( const QString &path, const QImage &image );
+        void removeEntries( const QString &prefix );
+        void touch( const QString &path );
+        void trim();
+
+        QMutex m_mutex;
+        WriterThread *m_writer;
+        bool m_writing;
+        // the images queued for the writer thread
+        QList< PendingImage > m_pending;
+        QString m_root;
+        QString m_dir;
+        qint64 m_maxSize;
+        qint64 m_totalSize;
+        // all the files in the cache, of all the documents
+        QHash< QString, Entry > m_entries;
+};
+
+}
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
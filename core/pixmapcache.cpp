@@ -0,0 +1,197 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "pixmapcache_p.h"
+
+#include "generator.h"
+#include "observer.h"
+
+using namespace Okular;
+
+AllocatedPixmapIndex::AllocatedPixmapIndex()
+    : m_count( 0 )
+{
+}
+
+AllocatedPixmapIndex::~AllocatedPixmapIndex()
+{
+    clear();
+}
+
+void AllocatedPixmapIndex::insert( AllocatedPixmap *pixmap )
+{
+    PageMap &pages = m_pixmaps[ pixmap->observer ];
+    PageMap::iterator it = pages.find( pixmap->page );
+    if ( it != pages.end() )
+    {
+        delete it.value();
+        it.value() = pixmap;
+        return;
+    }
+
+    pages.insert( pixmap->page, pixmap );
+    ++m_count;
+}
+
+AllocatedPixmap *AllocatedPixmapIndex::take( DocumentObserver *observer, int page )
+{
+    QHash< DocumentObserver *, PageMap >::iterator oIt = m_pixmaps.find( observer );
+    if ( oIt == m_pixmaps.end() )
+        return 0;
+
+    AllocatedPixmap *pixmap = oIt.value().take( page );
+    if ( !pixmap )
+        return 0;
+
+    --m_count;
+    if ( oIt.value().isEmpty() )
+        m_pixmaps.erase( oIt );
+    return pixmap;
+}
+
+QList< AllocatedPixmap * > AllocatedPixmapIndex::takeAll( DocumentObserver *observer )
+{
+    const QList< AllocatedPixmap * > pixmaps = m_pixmaps.take( observer ).values();
+    m_count -= pixmaps.count();
+    return pixmaps;
+}
+
+AllocatedPixmap *AllocatedPixmapIndex::farthestFrom( int currentPage, bool unloadableOnly, DocumentObserver *observer ) const
+{
+    if ( observer )
+        return farthestFrom( m_pixmaps.value( observer ), currentPage, unloadableOnly );
+
+    AllocatedPixmap *farthestPixmap = 0;
+    int maxDistance = -1;
+    QHash< DocumentObserver *, PageMap >::const_iterator oIt = m_pixmaps.constBegin(), oEnd = m_pixmaps.constEnd();
+    for ( ; oIt != oEnd; ++oIt )
+    {
+        AllocatedPixmap *p = farthestFrom( oIt.value(), currentPage, unloadableOnly );
+        if ( p && qAbs( p->page - currentPage ) > maxDistance )
+        {
+            maxDistance = qAbs( p->page - currentPage );
+            farthestPixmap = p;
+        }
+    }
+    return farthestPixmap;
+}
+
+AllocatedPixmap *AllocatedPixmapIndex::farthestFrom( const PageMap &pages, int currentPage, bool unloadableOnly ) const
+{
+    if ( pages.isEmpty() )
+        return 0;
+
+    // The farthest of the remaining pages is always at one of the two ends of
+    // the range, so walk inwards until we find a pixmap we are allowed to use
+    PageMap::const_iterator low = pages.constBegin();
+    PageMap::const_iterator high = pages.constEnd();
+    --high;
+    while ( true )
+    {
+        const bool highIsFarther = qAbs( high.key() - currentPage ) > qAbs( low.key() - currentPage );
+        AllocatedPixmap *p = highIsFarther ? high.value() : low.value();
+        if ( !unloadableOnly || p->observer->canUnloadPixmap( p->page ) )
+            return p;
+
+        if ( low == high )
+            return 0;
+
+        if ( highIsFarther )
+            --high;
+        else
+            ++low;
+    }
+}
+
+void AllocatedPixmapIndex::clear()
+{
+    QHash< DocumentObserver *, PageMap >::const_iterator oIt = m_pixmaps.constBegin(), oEnd = m_pixmaps.constEnd();
+    for ( ; oIt != oEnd; ++oIt )
+        qDeleteAll( oIt.value() );
+    m_pixmaps.clear();
+    m_count = 0;
+}
+
+bool AllocatedPixmapIndex::isEmpty() const
+{
+    return m_count == 0;
+}
+
+int AllocatedPixmapIndex::count() const
+{
+    return m_count;
+}
+
+
+PixmapRequestQueue::PixmapRequestQueue()
+    : m_sequence( 0 )
+{
+}
+
+void PixmapRequestQueue::push( PixmapRequest *request )
+{
+    remove( request );
+
+    // zero priority requests are served LIFO, all the others FIFO
+    const qint64 sequence = ++m_sequence;
+    const Key key( request->priority(), request->priority() ? sequence : -sequence );
+    m_queue.insert( key, request );
+    m_keys.insert( request, key );
+    m_observerRequests[ request->observer() ].insert( request );
+}
+
+PixmapRequest *PixmapRequestQueue::top() const
+{
+    return m_queue.isEmpty() ? 0 : m_queue.constBegin().value();
+}
+
+bool PixmapRequestQueue::remove( PixmapRequest *request )
+{
+    QHash< PixmapRequest *, Key >::iterator kIt = m_keys.find( request );
+    if ( kIt == m_keys.end() )
+        return false;
+
+    m_queue.remove( kIt.value() );
+    m_keys.erase( kIt );
+
+    QHash< DocumentObserver *, QSet< PixmapRequest * > >::iterator oIt = m_observerRequests.find( request->observer() );
+    if ( oIt != m_observerRequests.end() )
+    {
+        oIt.value().remove( request );
+        if ( oIt.value().isEmpty() )
+            m_observerRequests.erase( oIt );
+    }
+    return true;
+}
+
+QList< PixmapRequest * > PixmapRequestQueue::requests( DocumentObserver *observer ) const
+{
+    return m_observerRequests.value( observer ).toList();
+}
+
+QList< PixmapRequest * > PixmapRequestQueue::takeAll()
+{
+    const QList< PixmapRequest * > requests = m_queue.values();
+    m_queue.clear();
+    m_keys.clear();
+    m_observerRequests.clear();
+    return requests;
+}
+
+bool PixmapRequestQueue::isEmpty() const
+{
+    return m_queue.isEmpty();
+}
+
+int PixmapRequestQueue::count() const
+{
+    return m_queue.count();
+}
+
+/* kate: replace-tabs on; indent-width 4; */
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_PIXMAPCACHE_P_H_
+#define _OKULAR_PIXMAPCACHE_P_H_
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QPair>
+#include <QtCore/QSet>
+
+namespace Okular {
+
+class DocumentObserver;
+class PixmapRequest;
+
+/**
+ * Memory descriptor of a pixmap stored in a page for an observer.
+ */
+struct AllocatedPixmap
+{
+    // owner of the page
+    DocumentObserver *observer;
+    int page;
+    qulonglong memory;
+    // public constructor: initialize data
+    AllocatedPixmap( DocumentObserver *o, int p, qulonglong m ) : observer( o ), page( p ), memory( m ) {}
+};
+
+/**
+ * Index of the allocated pixmaps, used to pick the pixmap to evict.
+ *
+ * The eviction policy removes the pixmap whose page is farthest from the
+ * current viewport page. The farthest element of a set from any given point
+ * is always one of its two extremes, so keeping the allocations of each
+ * observer sorted by page number answers that query in O(log n) without
+ * having to re-sort anything when the viewport moves.
+ *
+ * The index owns the AllocatedPixmap descriptors it contains.
+ */
+class AllocatedPixmapIndex
+{
+    public:
+        AllocatedPixmapIndex();
+        ~AllocatedPixmapIndex();
+
+        /**
+         * Adds the descriptor @p pixmap, replacing (and deleting) a previous
+         * descriptor for the same observer and page.
+         */
+        void insert( AllocatedPixmap *pixmap );
+
+        /**
+         * Removes the descriptor for the @p observer and @p page from the index
+         * and returns it, or returns 0 if there is none.
+         */
+        AllocatedPixmap *take( DocumentObserver *observer, int page );
+
+        /**
+         * Removes all the descriptors of @p observer and returns them.
+         */
+        QList< AllocatedPixmap * > takeAll( DocumentObserver *observer );
+
+        /**
+         * Returns the descriptor whose page is farthest from @p currentPage,
+         * considering only the given @p observer (or all of them if 0) and, if
+         * @p unloadableOnly is set, only pixmaps that their observer allows to
+         * unload. Returns 0 if no descriptor matches.
+         */
+        AllocatedPixmap *farthestFrom( int currentPage, bool unloadableOnly, DocumentObserver *observer = 0 ) const;
+
+        /**
+         * Deletes all the descriptors.
+         */
+        void clear();
+
+        bool isEmpty() const;
+        int count() const;
+
+    private:
+        typedef QMap< int, AllocatedPixmap * > PageMap;
+        AllocatedPixmap *farthestFrom( const PageMap &pages, int currentPage, bool unloadableOnly ) const;
+
+        QHash< DocumentObserver *, PageMap > m_pixmaps;
+        int m_count;
+};
+
+/**
+ * Priority queue of the pixmap requests waiting to be sent to the generator.
+ *
+ * The request with the lowest priority() value is the top of the queue.
+ * Among requests with the same priority, zero-priority ones are served in
+ * LIFO order (the most recent synchronous/visible request first), all the
+ * others in FIFO order.
+ *
+ * The queue does not own the requests.
+ */
+class PixmapRequestQueue
+{
+    public:
+        PixmapRequestQueue();
+
+        void push( PixmapRequest *request );
+
+        /**
+         * Returns the request to serve next, or 0 if the queue is empty.
+         */
+        PixmapRequest *top() const;
+
+        /**
+         * Removes @p request from the queue, returns whether it was queued.
+         */
+        bool remove( PixmapRequest *request );
+
+        /**
+         * Returns the queued requests of the given @p observer.
+         */
+        QList< PixmapRequest * > requests( DocumentObserver *observer ) const;
+
+        /**
+         * Removes all the requests from the queue and returns them.
+         */
+        QList< PixmapRequest * > takeAll();
+
+        bool isEmpty() const;
+        int count() const;
+
+    private:
+        typedef QPair< int, qint64 > Key;
+
+        QMap< Key, PixmapRequest * > m_queue;
+        QHash< PixmapRequest *, Key > m_keys;
+        QHash< DocumentObserver *, QSet< PixmapRequest * > > m_observerRequests;
+        qint64 m_sequence;
+};
+
+}
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
@@ -0,0 +1,179 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "renderstatistics_p.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+
+#include <kdebug.h>
+
+#include "debug_p.h"
+
+// events kept at most in the trace, about 100 bytes each
+#define OKULAR_RENDERSTATS_MAXEVENTS 200000
+
+using namespace Okular;
+
+namespace {
+
+const char * const phaseNames[] = { "queueing", "rendering", "delivering", "total", "rotating" };
+
+QElapsedTimer *monotonicClock()
+{
+    static QElapsedTimer *clock = 0;
+    if ( !clock )
+    {
+        clock = new QElapsedTimer;
+        clock->start();
+    }
+    return clock;
+}
+
+}
+
+RenderStatistics::Histogram::Histogram()
+    : count( 0 ), sum( 0 ), max( 0 )
+{
+    for ( int i = 0; i < OKULAR_RENDERSTATS_BUCKETS; ++i )
+        buckets[ i ] = 0;
+}
+
+void RenderStatistics::Histogram::add( qint64 duration )
+{
+    ++count;
+    sum += duration;
+    max = qMax( max, duration );
+
+    int bucket = 0;
+    for ( qint64 limit = 1000; duration >= limit && bucket < OKULAR_RENDERSTATS_BUCKETS - 1; limit *= 2 )
+        ++bucket;
+    ++buckets[ bucket ];
+}
+
+int RenderStatistics::Histogram::percentile( int percent ) const
+{
+    const qint64 wanted = ( count * percent + 99 ) / 100;
+    qint64 seen = 0;
+    for ( int i = 0; i < OKULAR_RENDERSTATS_BUCKETS; ++i )
+    {
+        seen += buckets[ i ];
+        if ( seen >= wanted )
+            return 1 << i;
+    }
+    return 1 << ( OKULAR_RENDERSTATS_BUCKETS - 1 );
+}
+
+RenderStatistics::RenderStatistics()
+    : m_lastId( 0 )
+{
+    // make sure the clock starts before the first timestamp is taken from
+    // another thread
+    monotonicClock();
+    m_traceFile = QFile::decodeName( qgetenv( "OKULAR_RENDER_TRACE" ) );
+}
+
+qint64 RenderStatistics::timestamp()
+{
+    return monotonicClock()->nsecsElapsed() / 1000;
+}
+
+void RenderStatistics::addRequest( int pageNumber, bool tile, const Times &times, qint64 delivered )
+{
+    if ( !times.enqueued || !times.dispatched || !times.rendered )
+        return;
+
+    m_histograms[ Queueing ].add( times.dispatched - times.enqueued );
+    m_histograms[ Rendering ].add( times.rendered - times.dispatched );
+    m_histograms[ Delivering ].add( delivered - times.rendered );
+    m_histograms[ Total ].add( delivered - times.enqueued );
+
+    if ( !m_traceFile.isEmpty() )
+    {
+        const int id = ++m_lastId;
+        addTraceEvent( "queueing", id, pageNumber, times.enqueued, times.dispatched );
+        addTraceEvent( tile ? "rendering tile" : "rendering", id, pageNumber, times.dispatched, times.rendered );
+        addTraceEvent( "delivering", id, pageNumber, times.rendered, delivered );
+    }
+}
+
+void RenderStatistics::addRotation( int pageNumber, qint64 started, qint64 finished )
+{
+    m_histograms[ Rotating ].add( finished - started );
+
+    if ( !m_traceFile.isEmpty() )
+        addTraceEvent( "rotating", ++m_lastId, pageNumber, started, finished );
+}
+
+void RenderStatistics::clear()
+{
+    for ( int i = 0; i < PhaseCount; ++i )
+        m_histograms[ i ] = Histogram();
+    m_traceEvents.clear();
+}
+
+QString RenderStatistics::report() const
+{
+    QStringList lines;
+    lines << QString( "%1 %2 %3 %4 %5 %6 %7" ).arg( "phase", -12 ).arg( "count", 8 ).arg( "mean", 9 )
+                 .arg( "p50", 7 ).arg( "p90", 7 ).arg( "p99", 7 ).arg( "max", 9 );
+    for ( int i = 0; i < PhaseCount; ++i )
+    {
+        const Histogram &h = m_histograms[ i ];
+        if ( h.count == 0 )
+            continue;
+
+        // the percentiles are the upper bounds of their histogram buckets
+        lines << QString( "%1 %2 %3 %4 %5 %6 %7" ).arg( phaseNames[ i ], -12 ).arg( h.count, 8 )
+                     .arg( h.sum / 1000.0 / h.count, 9, 'f', 2 )
+                     .arg( QString( "<%1" ).arg( h.percentile( 50 ) ), 7 )
+                     .arg( QString( "<%1" ).arg( h.percentile( 90 ) ), 7 )
+                     .arg( QString( "<%1" ).arg( h.percentile( 99 ) ), 7 )
+                     .arg( h.max / 1000.0, 9, 'f', 2 );
+    }
+    lines << QString( "(durations in milliseconds)" );
+    return lines.join( "\n" );
+}
+
+void RenderStatistics::writeTrace() const
+{
+    if ( m_traceFile.isEmpty() || m_traceEvents.isEmpty() )
+        return;
+
+    QFile file( m_traceFile );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        kWarning(OkularDebug) << "Cannot write the render trace to" << m_traceFile;
+        return;
+    }
+
+    file.write( "{\"traceEvents\":[\n" );
+    for ( int i = 0; i < m_traceEvents.count(); ++i )
+    {
+        if ( i > 0 )
+            file.write( ",\n" );
+        file.write( m_traceEvents.at( i ) );
+    }
+    file.write( "\n]}\n" );
+}
+
+void RenderStatistics::addTraceEvent( const char *name, int id, int pageNumber, qint64 start, qint64 end )
+{
+    if ( m_traceEvents.count() >= OKULAR_RENDERSTATS_MAXEVENTS * 2 )
+        return;
+
+    // the phases of different requests overlap, so use async events
+    const QByteArray common = QByteArray( "\"cat\":\"pixmap\",\"name\":\"" ) + name + "\",\"id\":" + QByteArray::number( id ) + ",\"pid\":1,\"tid\":1";
+    m_traceEvents.append( "{" + common + ",\"ph\":\"b\",\"ts\":" + QByteArray::number( start )
+                          + ",\"args\":{\"page\":" + QByteArray::number( pageNumber ) + "}}" );
+    m_traceEvents.append( "{" + common + ",\"ph\":\"e\",\"ts\":" + QByteArray::number( end ) + "}" );
+}
+
+/* kate: replace-tabs on; indent-width 4; */
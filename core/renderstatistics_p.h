@@ -0,0 +1,120 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_RENDERSTATISTICS_P_H_
+#define _OKULAR_RENDERSTATISTICS_P_H_
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+// number of histogram buckets: the first one counts the durations below
+// 1 ms, each of the following ones durations twice as long as the previous
+#define OKULAR_RENDERSTATS_BUCKETS 16
+
+namespace Okular {
+
+/**
+ * Timings of the pixmap requests, to find out where the time goes between
+ * the request of a pixmap by an observer and its delivery.
+ *
+ * The durations of each phase are collected in histograms, reported by
+ * report(). Setting the OKULAR_RENDER_TRACE environment variable to a file
+ * name also records every request as an event in the Chrome trace format
+ * (chrome://tracing), written to that file by writeTrace().
+ *
+ * All the methods but timestamp() are to be called from the GUI thread.
+ */
+class RenderStatistics
+{
+    public:
+        enum Phase
+        {
+            Queueing,       ///< From Document::requestPixmaps() to the generator
+            Rendering,      ///< In the generator (or in a cache)
+            Delivering,     ///< From the generator to the observers notification
+            Total,          ///< From Document::requestPixmaps() to the observers notification
+            Rotating,       ///< Rotation of the pixmaps already in memory
+            PhaseCount
+        };
+
+        /**
+         * Timestamps of a pixmap request, see timestamp(); 0 for the phases
+         * not reached yet.
+         */
+        struct Times
+        {
+            Times() : enqueued( 0 ), dispatched( 0 ), rendered( 0 ) {}
+
+            qint64 enqueued;
+            qint64 dispatched;
+            qint64 rendered;
+        };
+
+        RenderStatistics();
+
+        /**
+         * Returns the current time in microseconds, from a monotonic clock.
+         * Thread safe.
+         */
+        static qint64 timestamp();
+
+        /**
+         * Records a request for @p pageNumber delivered at @p delivered.
+         */
+        void addRequest( int pageNumber, bool tile, const Times &times, qint64 delivered );
+
+        /**
+         * Records the rotation of a pixmap of @p pageNumber.
+         */
+        void addRotation( int pageNumber, qint64 started, qint64 finished );
+
+        /**
+         * Forgets everything recorded so far.
+         */
+        void clear();
+
+        /**
+         * Returns a human readable summary of the recorded durations.
+         */
+        QString report() const;
+
+        /**
+         * Writes the recorded trace events, if tracing is enabled.
+         */
+        void writeTrace() const;
+
+    private:
+        struct Histogram
+        {
+            Histogram();
+
+            void add( qint64 duration );
+            // upper bound (in ms) of the bucket of the given percentile
+            int percentile( int percent ) const;
+
+            qint64 count;
+            qint64 sum;
+            qint64 max;
+            qint64 buckets[ OKULAR_RENDERSTATS_BUCKETS ];
+        };
+
+        void addTraceEvent( const char *name, int id, int pageNumber, qint64 start, qint64 end );
+
+        Histogram m_histograms[ PhaseCount ];
+        QString m_traceFile;
+        QList< QByteArray > m_traceEvents;
+        int m_lastId;
+};
+
+}
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
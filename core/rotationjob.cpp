@@ -11,11 +11,13 @@
 
 #include <QtGui/QTransform>
 
+#include "renderstatistics_p.h"
+
 using namespace Okular;
 
 RotationJob::RotationJob( const QImage &image, Rotation oldRotation, Rotation newRotation, DocumentObserver *observer )
     : mImage( image ), mOldRotation( oldRotation ), mNewRotation( newRotation ), mObserver( observer ), m_pd( 0 )
-    , mRect( NormalizedRect() )
+    , mRect( NormalizedRect() ), mStartTime( 0 ), mFinishTime( 0 )
 {
 }
 
@@ -54,16 +56,30 @@ NormalizedRect RotationJob::rect() const
     return mRect;
 }
 
+qint64 RotationJob::startTime() const
+{
+    return mStartTime;
+}
+
+qint64 RotationJob::finishTime() const
+{
+    return mFinishTime;
+}
+
 void RotationJob::run()
 {
+    mStartTime = RenderStatistics::timestamp();
+
     if ( mOldRotation == mNewRotation ) {
         mRotatedImage = mImage;
+        mFinishTime = RenderStatistics::timestamp();
         return;
     }
 
     QTransform matrix = rotationMatrix( mOldRotation, mNewRotation );
 
     mRotatedImage = mImage.transformed( matrix );
+    mFinishTime = RenderStatistics::timestamp();
 }
 
 QTransform RotationJob::rotationMatrix( Rotation from, Rotation to )
@@ -39,6 +39,12 @@ class RotationJob : public ThreadWeaver::Job
         PagePrivate * page() const;
         NormalizedRect rect() const;
 
+        /**
+         * When the rotation started and finished, see RenderStatistics::timestamp()
+         */
+        qint64 startTime() const;
+        qint64 finishTime() const;
+
         static QTransform rotationMatrix( Rotation from, Rotation to );
 
     protected:
@@ -52,6 +58,8 @@ class RotationJob : public ThreadWeaver::Job
         QImage mRotatedImage;
         PagePrivate * m_pd;
         NormalizedRect mRect;
+        qint64 mStartTime;
+        qint64 mFinishTime;
 };
 
 }
@@ -0,0 +1,279 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "textindex_p.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QtAlgorithms>
+
+using namespace Okular;
+
+#define OKULAR_TEXTINDEX_MAGIC 0x4f4b5449 // 'OKTI'
+#define OKULAR_TEXTINDEX_VERSION 1
+
+namespace {
+
+/**
+ * Splits @p text in words. If @p joinHyphenated is set, the two halves of
+ * the hyphenated words are also returned joined, after the second one.
+ */
+QStringList splitWords( const QString &text, bool joinHyphenated )
+{
+    // the same normalization as the searched text in TextPage::findText
+    const QString normalized = text.normalized( QString::NormalizationForm_KC ).toCaseFolded();
+    const int length = normalized.length();
+
+    QStringList words;
+    QString hyphenatedHalf;
+    int start = -1;
+    for ( int i = 0; i <= length; ++i )
+    {
+        if ( i < length && normalized.at( i ).isLetterOrNumber() )
+        {
+            if ( start == -1 )
+                start = i;
+            continue;
+        }
+        if ( start == -1 )
+            continue;
+
+        const QString word = normalized.mid( start, i - start );
+        words.append( word );
+        if ( !hyphenatedHalf.isEmpty() )
+            words.append( hyphenatedHalf + word );
+        start = -1;
+
+        // a '-' followed by the next word, possibly after a line break, can
+        // be matched by TextPage::findText as if it was not there
+        hyphenatedHalf.clear();
+        if ( joinHyphenated && i < length && normalized.at( i ) == QLatin1Char( '-' ) )
+        {
+            int next = i + 1;
+            while ( next < length && normalized.at( next ).isSpace() )
+                ++next;
+            if ( next < length && normalized.at( next ).isLetterOrNumber() )
+                hyphenatedHalf = word;
+        }
+    }
+    return words;
+}
+
+/**
+ * Orders the suffixes of the words of a TextIndex, and compares them with
+ * a text for the binary searches.
+ */
+class SuffixLessThan
+{
+    public:
+        SuffixLessThan( const QStringList &words )
+            : m_words( words )
+        {
+        }
+
+        bool operator()( const WordSuffix &s1, const WordSuffix &s2 ) const
+        {
+            return QStringRef::compare( suffix( s1 ), suffix( s2 ) ) < 0;
+        }
+
+        bool operator()( const WordSuffix &s, const QString &text ) const
+        {
+            return QStringRef::compare( suffix( s ), text ) < 0;
+        }
+
+    private:
+        QStringRef suffix( const WordSuffix &s ) const
+        {
+            return m_words.at( s.word ).midRef( s.offset );
+        }
+
+        const QStringList &m_words;
+};
+
+void markPages( const QVector< int > &pages, QVector< bool > *marked )
+{
+    foreach ( int page, pages )
+    {
+        if ( page >= 0 && page < marked->count() )
+            (*marked)[ page ] = true;
+    }
+}
+
+}
+
+TextIndex::TextIndex()
+    : m_pageCount( 0 )
+{
+}
+
+void TextIndex::clear()
+{
+    m_words.clear();
+    m_pageCount = 0;
+    m_vocabulary.clear();
+    m_suffixes.clear();
+    m_lastText.clear();
+    m_lastCandidates.clear();
+}
+
+bool TextIndex::isValid() const
+{
+    return m_pageCount > 0;
+}
+
+int TextIndex::pageCount() const
+{
+    return m_pageCount;
+}
+
+void TextIndex::addPage( int page, const QString &text )
+{
+    const QSet< QString > words = splitWords( text, true ).toSet();
+    foreach ( const QString &word, words )
+        m_words[ word ].append( page );
+    m_pageCount = qMax( m_pageCount, page + 1 );
+    m_vocabulary.clear();
+    m_suffixes.clear();
+    m_lastText.clear();
+    m_lastCandidates.clear();
+}
+
+bool TextIndex::mayContain( int page, const QString &text ) const
+{
+    if ( text != m_lastText || m_lastText.isNull() )
+        updateCandidates( text );
+
+    return m_lastCandidates.isEmpty() || page < 0 || page >= m_lastCandidates.count() || m_lastCandidates.at( page );
+}
+
+void TextIndex::updateCandidates( const QString &text ) const
+{
+    m_lastText = text;
+    m_lastCandidates.clear();
+
+    const QStringList queryWords = splitWords( text, false );
+    if ( queryWords.isEmpty() || !isValid() )
+        return;
+
+    if ( m_suffixes.isEmpty() )
+        updateSuffixes();
+
+    // the searched text may begin in the middle of its first word and end
+    // in the middle of its last one, the words between are complete
+    QVector< bool > candidates( m_pageCount, true );
+    const int last = queryWords.count() - 1;
+    for ( int i = 0; i <= last; ++i )
+    {
+        const QString &queryWord = queryWords.at( i );
+        QVector< bool > pages( m_pageCount, false );
+        if ( i > 0 && i < last )
+        {
+            markPages( m_words.value( queryWord ), &pages );
+        }
+        else
+        {
+            // the suffixes beginning with the query word are all in a row
+            QVector< WordSuffix >::const_iterator it = qLowerBound( m_suffixes.constBegin(), m_suffixes.constEnd(), queryWord, SuffixLessThan( m_vocabulary ) );
+            for ( ; it != m_suffixes.constEnd(); ++it )
+            {
+                const QString &word = m_vocabulary.at( it->word );
+                if ( word.midRef( it->offset, queryWord.length() ) != queryWord )
+                    break;
+
+                const bool matches = last == 0 ? true
+                                   : i == 0 ? it->offset + queryWord.length() == word.length()
+                                   : it->offset == 0;
+                if ( matches )
+                    markPages( m_words.value( word ), &pages );
+            }
+        }
+
+        for ( int page = 0; page < m_pageCount; ++page )
+            candidates[ page ] = candidates.at( page ) && pages.at( page );
+    }
+    m_lastCandidates = candidates;
+}
+
+void TextIndex::updateSuffixes() const
+{
+    m_vocabulary = m_words.keys();
+    m_suffixes.clear();
+    for ( int word = 0; word < m_vocabulary.count(); ++word )
+    {
+        const int length = m_vocabulary.at( word ).length();
+        for ( int offset = 0; offset < length; ++offset )
+        {
+            const WordSuffix suffix = { word, offset };
+            m_suffixes.append( suffix );
+        }
+    }
+    qSort( m_suffixes.begin(), m_suffixes.end(), SuffixLessThan( m_vocabulary ) );
+}
+
+bool TextIndex::load( const QString &fileName, const QString &key, int pageCount )
+{
+    clear();
+
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return false;
+
+    QDataStream stream( &file );
+    qint32 magic, version, filePageCount;
+    QString fileKey;
+    QByteArray data;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != OKULAR_TEXTINDEX_MAGIC || version != OKULAR_TEXTINDEX_VERSION )
+        return false;
+    stream >> fileKey >> filePageCount >> data;
+    if ( stream.status() != QDataStream::Ok || fileKey != key || filePageCount != pageCount )
+        return false;
+
+    QDataStream wordsStream( qUncompress( data ) );
+    wordsStream >> m_words;
+    if ( wordsStream.status() != QDataStream::Ok )
+    {
+        m_words.clear();
+        return false;
+    }
+    m_pageCount = pageCount;
+    return true;
+}
+
+bool TextIndex::save( const QString &fileName, const QString &key ) const
+{
+    QByteArray data;
+    {
+        QDataStream wordsStream( &data, QIODevice::WriteOnly );
+        wordsStream << m_words;
+    }
+
+    // write to a temporary file, so that load() never sees half written files
+    const QString tempFileName = fileName + QLatin1String( ".part" );
+    QFile file( tempFileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+
+    QDataStream stream( &file );
+    stream << (qint32)OKULAR_TEXTINDEX_MAGIC << (qint32)OKULAR_TEXTINDEX_VERSION;
+    stream << key << (qint32)m_pageCount << qCompress( data );
+    file.close();
+
+    QFile::remove( fileName );
+    if ( stream.status() != QDataStream::Ok || !QFile::rename( tempFileName, fileName ) )
+    {
+        QFile::remove( tempFileName );
+        return false;
+    }
+    return true;
+}
+
+/* kate: replace-tabs on; indent-width 4; */
@@ -0,0 +1,105 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_TEXTINDEX_P_H_
+#define _OKULAR_TEXTINDEX_P_H_
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+namespace Okular {
+
+/**
+ * The suffix of the word number @p word of a TextIndex, from @p offset.
+ */
+struct WordSuffix
+{
+    int word;
+    int offset;
+};
+
+/**
+ * Inverted index of the words of a document, telling in which pages each
+ * word appears, so that a search does not need to look at the text of the
+ * pages that cannot contain the searched text.
+ *
+ * The words are the runs of letters and numbers of the text, normalized and
+ * case folded; the two halves of a word hyphenated at the end of a line are
+ * also indexed together. The index only answers "may contain": a page it
+ * keeps still needs to be searched.
+ *
+ * The index is saved to a file together with a key identifying the
+ * document contents, a file with a different key is not loaded.
+ */
+class TextIndex
+{
+    public:
+        TextIndex();
+
+        void clear();
+
+        /**
+         * Whether the index has pages, i.e. whether it can restrict a search.
+         */
+        bool isValid() const;
+
+        int pageCount() const;
+
+        /**
+         * Adds the words of the @p text of the page number @p page. The pages
+         * are to be added in increasing order.
+         */
+        void addPage( int page, const QString &text );
+
+        /**
+         * Returns false if the text of @p page cannot contain @p text, true
+         * if it may contain it or if the index cannot tell.
+         *
+         * The pages of the last text are cached, so asking for all the pages
+         * of a document in a row is cheap.
+         */
+        bool mayContain( int page, const QString &text ) const;
+
+        /**
+         * Loads the index of the document with the given @p key and
+         * @p pageCount from @p fileName.
+         */
+        bool load( const QString &fileName, const QString &key, int pageCount );
+
+        /**
+         * Saves the index to @p fileName for the document with the given @p key.
+         */
+        bool save( const QString &fileName, const QString &key ) const;
+
+    private:
+        void updateCandidates( const QString &text ) const;
+        void updateSuffixes() const;
+
+        // sorted page numbers of each word
+        QHash< QString, QVector< int > > m_words;
+        int m_pageCount;
+
+        // the suffixes of all the words, sorted, so that the words that
+        // contain, begin or end with a text are found by a binary search;
+        // built at the first search after the words change
+        mutable QStringList m_vocabulary;
+        mutable QVector< WordSuffix > m_suffixes;
+
+        // pages that may contain m_lastText, empty if the index cannot tell
+        mutable QString m_lastText;
+        mutable QVector< bool > m_lastCandidates;
+};
+
+}
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
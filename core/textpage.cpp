@@ -18,9 +18,10 @@
 #include "page.h"
 #include "page_p.h"
 
-#include <cstring>
+#include <algorithm>
 
 #include <QtAlgorithms>
+#include <QRegExp>
 #include <QVarLengthArray>
 
 using namespace Okular;
@@ -29,32 +30,309 @@ class SearchPoint
 {
     public:
         SearchPoint()
-            : offset_begin( -1 ), offset_end( -1 )
+            : begin( -1 ), end( -1 )
         {
         }
 
-        TextList::ConstIterator it_begin;
-        TextList::ConstIterator it_end;
-        int offset_begin;
-        int offset_end;
+        // the last match, in TextPagePrivate::searchText()
+        int begin;
+        int end;
 };
 
-/* text comparison functions */
+/**
+ * Folds the case of @p text one character at a time, so that the positions
+ * in the folded text are the same as in @p text.
+ */
+static QString foldCase( const QString &text )
+{
+    QString folded = text;
+    QChar *c = folded.data(), *end = c + folded.length();
+    for ( ; c != end; ++c )
+        *c = c->toCaseFolded();
+    return folded;
+}
+
+/**
+ * Returns the failure function of @p pattern for findPattern(): the length of
+ * the longest proper prefix of pattern[0..i] that is also a suffix of it.
+ */
+static QVector< int > failureFunction( const QString &pattern )
+{
+    QVector< int > failure( pattern.length() );
+    int k = 0;
+    for ( int i = 1; i < pattern.length(); ++i )
+    {
+        while ( k > 0 && pattern.at( i ) != pattern.at( k ) )
+            k = failure.at( k - 1 );
+        if ( pattern.at( i ) == pattern.at( k ) )
+            ++k;
+        failure[ i ] = k;
+    }
+    return failure;
+}
+
+/**
+ * Searches @p pattern in @p text between @p from and @p to with the
+ * Knuth-Morris-Pratt algorithm, that never goes back in the text: the time
+ * is linear in the length of the text, whatever the text and the pattern.
+ *
+ * Returns the position of the first match, or of the last one if @p last is
+ * set, or -1 if there is no match.
+ */
+static int findPattern( const QString &text, int from, int to, const QString &pattern, const QVector< int > &failure, bool last )
+{
+    const QChar *t = text.constData();
+    const QChar *p = pattern.constData();
+    const int length = pattern.length();
+    int found = -1;
+    int k = 0;
+    for ( int i = qMax( from, 0 ); i < to; ++i )
+    {
+        if ( k == 0 )
+        {
+            // skip quickly to the next candidate
+            while ( i < to && t[ i ] != p[ 0 ] )
+                ++i;
+            if ( i == to )
+                break;
+        }
+        while ( k > 0 && t[ i ] != p[ k ] )
+            k = failure.at( k - 1 );
+        if ( t[ i ] == p[ k ] )
+            ++k;
+        if ( k == length )
+        {
+            found = i - length + 1;
+            if ( !last )
+                break;
+            k = failure.at( k - 1 );
+        }
+    }
+    return found;
+}
+
+/**
+ * Searches @p regExp in @p text between @p from and @p to, like findPattern,
+ * storing the length of the match in @p length. The empty matches are
+ * skipped, there would be nothing to highlight.
+ */
+static int findRegExp( const QString &text, int from, int to, const QRegExp &regExp, bool last, int *length )
+{
+    int found = -1;
+    int pos = qMax( from, 0 );
+    while ( pos < to && ( pos = regExp.indexIn( text, pos ) ) != -1 )
+    {
+        const int matchedLength = regExp.matchedLength();
+        if ( pos + matchedLength > to )
+            break;
+        if ( matchedLength > 0 )
+        {
+            found = pos;
+            *length = matchedLength;
+            if ( !last )
+                break;
+        }
+        pos += qMax( matchedLength, 1 );
+    }
+    return found;
+}
+
+/**
+ * Returns what @p c becomes in a loose comparison, before the case folding:
+ * the letters that are not composed in Unicode but are usually written
+ * without their stroke or as two letters are replaced, the others are
+ * decomposed (the accents being removed afterwards).
+ */
+static QString looseCharacter( QChar c )
+{
+    switch ( c.unicode() )
+    {
+        case 0x00C6: // LATIN CAPITAL LETTER AE
+        case 0x00E6: // LATIN SMALL LETTER AE
+            return QString::fromLatin1( "ae" );
+        case 0x00D8: // LATIN CAPITAL LETTER O WITH STROKE
+        case 0x00F8: // LATIN SMALL LETTER O WITH STROKE
+            return QString::fromLatin1( "o" );
+        case 0x00DF: // LATIN SMALL LETTER SHARP S
+        case 0x1E9E: // LATIN CAPITAL LETTER SHARP S
+            return QString::fromLatin1( "ss" );
+        case 0x0110: // LATIN CAPITAL LETTER D WITH STROKE
+        case 0x0111: // LATIN SMALL LETTER D WITH STROKE
+            return QString::fromLatin1( "d" );
+        case 0x0131: // LATIN SMALL LETTER DOTLESS I
+            return QString::fromLatin1( "i" );
+        case 0x0141: // LATIN CAPITAL LETTER L WITH STROKE
+        case 0x0142: // LATIN SMALL LETTER L WITH STROKE
+            return QString::fromLatin1( "l" );
+        case 0x0152: // LATIN CAPITAL LIGATURE OE
+        case 0x0153: // LATIN SMALL LIGATURE OE
+            return QString::fromLatin1( "oe" );
+    }
+    return QString( c ).normalized( QString::NormalizationForm_KD );
+}
+
+/**
+ * Folds @p text for the loose comparisons: the case, the accents and the
+ * ligatures are removed. If @p offsets is not 0, it is filled with the
+ * position in @p text of each character of the folded text.
+ */
+static QString foldLoosely( const QString &text, QVector< int > *offsets )
+{
+    const int length = text.length();
+    QString folded;
+    folded.reserve( length );
+    if ( offsets )
+    {
+        offsets->clear();
+        offsets->reserve( length );
+    }
+
+    for ( int i = 0; i < length; ++i )
+    {
+        const QChar c = text.at( i );
+        if ( c.unicode() < 0x80 )
+        {
+            // most of the text, nothing to decompose
+            folded.append( c.toCaseFolded() );
+            if ( offsets )
+                offsets->append( i );
+        }
+        else if ( c.isHighSurrogate() && i + 1 < length && text.at( i + 1 ).isLowSurrogate() )
+        {
+            // outside of the BMP, kept as is
+            folded.append( c );
+            folded.append( text.at( i + 1 ) );
+            if ( offsets )
+            {
+                offsets->append( i );
+                offsets->append( i + 1 );
+            }
+            ++i;
+        }
+        else
+        {
+            const QString decomposed = looseCharacter( c );
+            for ( int j = 0; j < decomposed.length(); ++j )
+            {
+                const QChar d = decomposed.at( j );
+                const QChar::Category category = d.category();
+                if ( category == QChar::Mark_NonSpacing || category == QChar::Mark_SpacingCombining || category == QChar::Mark_Enclosing )
+                    continue;
+                folded.append( d.toCaseFolded() );
+                if ( offsets )
+                    offsets->append( i );
+            }
+        }
+    }
+    return folded;
+}
+
+/**
+ * Returns whether the @p length characters of @p pattern are at @p position
+ * of @p text, before @p to.
+ */
+static inline bool matchesAt( const QChar *text, int position, int to, const QChar *pattern, int length )
+{
+    if ( position + length > to )
+        return false;
+    for ( int i = 0; i < length; ++i )
+    {
+        if ( text[ position + i ] != pattern[ i ] )
+            return false;
+    }
+    return true;
+}
 
-bool CaseInsensitiveCmpFn( const QStringRef & from, const QStringRef & to,
-                           int *fromLength, int *toLength )
+/**
+ * Returns the length of the text at @p position of @p text that matches
+ * @p pattern with one character different, missing or extra at most, or -1;
+ * @p differences gets the number of differences, 0 or 1.
+ */
+static int approximateMatchAt( const QString &text, int position, int to, const QString &pattern, int *differences )
 {
-    *fromLength = from.length();
-    *toLength = to.length();
-    return from.compare( to, Qt::CaseInsensitive ) == 0;
+    const QChar *t = text.constData();
+    const QChar *p = pattern.constData();
+    const int length = pattern.length();
+
+    *differences = 0;
+    int i = 0;
+    while ( i < length && position + i < to && t[ position + i ] == p[ i ] )
+        ++i;
+    if ( i == length )
+        return length;
+
+    // the first difference is the only one: a different character, an
+    // extra one in the text (but at the start, the match is just after),
+    // or a missing one
+    *differences = 1;
+    if ( matchesAt( t, position + i + 1, to, p + i + 1, length - i - 1 ) )
+        return length;
+    if ( i > 0 && matchesAt( t, position + i + 1, to, p + i, length - i ) )
+        return length + 1;
+    if ( matchesAt( t, position + i, to, p + i + 1, length - i - 1 ) )
+        return length - 1;
+    return -1;
 }
 
-bool CaseSensitiveCmpFn( const QStringRef & from, const QStringRef & to,
-                           int *fromLength, int *toLength )
+/**
+ * Searches @p pattern in @p text between @p from and @p to, like
+ * findPattern, allowing a character to be different, missing or extra, and
+ * storing the length of the match in @p length.
+ *
+ * Every position is tried, but each try stops at the second difference,
+ * that is in the first characters most of the time.
+ */
+static int findApproximate( const QString &text, int from, int to, const QString &pattern, bool last, int *length )
 {
-    *fromLength = from.length();
-    *toLength = to.length();
-    return from.compare( to, Qt::CaseSensitive ) == 0;
+    from = qMax( from, 0 );
+    int differences = 0;
+    if ( last )
+    {
+        // the positions just before the first match found going backwards
+        // can match better, like "hello" before its truncated "ello": take
+        // the match with the fewest differences, then the leftmost one
+        int best = -1, bestDifferences = 0, bestLength = 0, limit = from;
+        for ( int i = to - 1; i >= limit; --i )
+        {
+            const int matchLength = approximateMatchAt( text, i, to, pattern, &differences );
+            if ( matchLength <= 0 || ( best != -1 && differences > bestDifferences ) )
+                continue;
+
+            if ( best == -1 )
+                limit = qMax( from, i - pattern.length() );
+            best = i;
+            bestDifferences = differences;
+            bestLength = matchLength;
+        }
+        *length = bestLength;
+        return best;
+    }
+    else
+    {
+        const QChar *t = text.constData();
+        for ( int i = from; i < to; ++i )
+        {
+            if ( ( *length = approximateMatchAt( text, i, to, pattern, &differences ) ) <= 0 )
+                continue;
+
+            // the positions just after an approximate match can match
+            // exactly, like "hello" in "hhello": take the exact match then
+            if ( differences > 0 )
+            {
+                const int limit = qMin( to, i + pattern.length() + 1 );
+                for ( int j = i + 1; j < limit; ++j )
+                {
+                    if ( matchesAt( t, j, to, pattern.constData(), pattern.length() ) )
+                    {
+                        *length = pattern.length();
+                        return j;
+                    }
+                }
+            }
+            return i;
+        }
+    }
+    return -1;
 }
 
 /**
@@ -115,86 +393,6 @@ static bool doesConsumeY(const QRect& first, const QRect& second, int threshold)
     return false;
 }
 
-/*
-  Rationale behind TinyTextEntity:
-
-  instead of storing directly a QString for the text of an entity,
-  we store the UTF-16 data and their length. This way, we save about
-  4 int's wrt a QString, and we can create a new string from that
-  raw data (that's the only penalty of that).
-  Even better, if the string we need to store has at most
-  MaxStaticChars characters, then we store those in place of the QChar*
-  that would be used (with new[] + free[]) for the data.
- */
-class TinyTextEntity
-{
-    static const int MaxStaticChars = sizeof( QChar * ) / sizeof( QChar );
-
-    public:
-        TinyTextEntity( const QString &text, const NormalizedRect &rect )
-            : area( rect )
-        {
-            Q_ASSERT_X( !text.isEmpty(), "TinyTextEntity", "empty string" );
-            Q_ASSERT_X( sizeof( d ) == sizeof( QChar * ), "TinyTextEntity",
-                        "internal storage is wider than QChar*, fix it!" );
-            length = text.length();
-            switch ( length )
-            {
-#if QT_POINTER_SIZE >= 8
-                case 4:
-                    d.qc[3] = text.at( 3 ).unicode();
-                    // fall through
-                case 3:
-                    d.qc[2] = text.at( 2 ).unicode();
-                    // fall through
-#endif
-                case 2:
-                    d.qc[1] = text.at( 1 ).unicode();
-                    // fall through
-                case 1:
-                    d.qc[0] = text.at( 0 ).unicode();
-                    break;
-                default:
-                    d.data = new QChar[ length ];
-                    std::memcpy( d.data, text.constData(), length * sizeof( QChar ) );
-            }
-        }
-
-        ~TinyTextEntity()
-        {
-            if ( length > MaxStaticChars )
-            {
-                delete [] d.data;
-            }
-        }
-
-        inline QString text() const
-        {
-            return length <= MaxStaticChars ? QString::fromRawData( ( const QChar * )&d.qc[0], length )
-                                            : QString::fromRawData( d.data, length );
-        }
-
-        inline NormalizedRect transformedArea( const QTransform &matrix ) const
-        {
-            NormalizedRect transformed_area = area;
-            transformed_area.transform( matrix );
-            return transformed_area;
-        }
-
-        NormalizedRect area;
-
-    private:
-        Q_DISABLE_COPY( TinyTextEntity )
-
-        union
-        {
-            QChar *data;
-            ushort qc[MaxStaticChars];
-        } d;
-        int length;
-};
-
-
 TextEntity::TextEntity( const QString &text, NormalizedRect *area )
     : m_text( text ), m_area( area ), d( 0 )
 {
@@ -223,15 +421,58 @@ NormalizedRect TextEntity::transformedArea(const QTransform &matrix) const
 }
 
 
+void FlatTextList::append( const QString &text, const NormalizedRect &area )
+{
+    m_offsets.append( m_text.length() );
+    m_text.append( text );
+    const Rect rect = { (float)area.left, (float)area.top, (float)area.right, (float)area.bottom };
+    m_areas.append( rect );
+}
+
+void FlatTextList::append( const QStringRef &text, const NormalizedRect &area )
+{
+    m_offsets.append( m_text.length() );
+    m_text.append( text );
+    const Rect rect = { (float)area.left, (float)area.top, (float)area.right, (float)area.bottom };
+    m_areas.append( rect );
+}
+
+void FlatTextList::clear()
+{
+    m_text.clear();
+    m_offsets.clear();
+    m_areas.clear();
+}
+
+void FlatTextList::squeeze()
+{
+    m_text.squeeze();
+    m_offsets.squeeze();
+    m_areas.squeeze();
+}
+
+qulonglong FlatTextList::memoryUsage() const
+{
+    return (qulonglong)m_text.capacity() * sizeof( QChar ) + (qulonglong)m_offsets.capacity() * sizeof( int )
+           + (qulonglong)m_areas.capacity() * sizeof( Rect );
+}
+
+NormalizedRect FlatTextList::transformedArea( int i, const QTransform &matrix ) const
+{
+    NormalizedRect transformed_area = area( i );
+    transformed_area.transform( matrix );
+    return transformed_area;
+}
+
+
 TextPagePrivate::TextPagePrivate()
-    : m_page( 0 )
+    : m_page( 0 ), m_patternCaseSensitivity( Qt::CaseSensitive ), m_patternComparison( TextPage::ExactComparison )
 {
 }
 
 TextPagePrivate::~TextPagePrivate()
 {
     qDeleteAll( m_searchPoints );
-    qDeleteAll( m_words );
 }
 
 
@@ -240,6 +481,19 @@ TextPage::TextPage()
 {
 }
 
+// ASCII text is already normalized, and the generators append one entity for
+// each character most of the time: do not copy it for nothing
+static bool isAscii( const QString &text )
+{
+    const QChar *c = text.constData(), *end = c + text.length();
+    for ( ; c != end; ++c )
+    {
+        if ( c->unicode() >= 0x80 )
+            return false;
+    }
+    return true;
+}
+
 TextPage::TextPage( const TextEntity::List &words )
     : d( new TextPagePrivate() )
 {
@@ -248,9 +502,10 @@ TextPage::TextPage( const TextEntity::List &words )
     {
         TextEntity *e = *it;
         if ( !e->text().isEmpty() )
-            d->m_words.append( new TinyTextEntity( e->text(), *e->area() ) );
+            d->m_words.append( isAscii( e->text() ) ? e->text() : e->text().normalized( QString::NormalizationForm_KC ), *e->area() );
         delete e;
     }
+    d->m_words.squeeze();
 }
 
 TextPage::~TextPage()
@@ -261,82 +516,12 @@ TextPage::~TextPage()
 void TextPage::append( const QString &text, NormalizedRect *area )
 {
     if ( !text.isEmpty() )
-        d->m_words.append( new TinyTextEntity( text.normalized(QString::NormalizationForm_KC), *area ) );
-    delete area;
-}
-
-struct WordWithCharacters
-{
-    WordWithCharacters(TinyTextEntity *w, const TextList &c)
-     : word(w), characters(c)
-    {
-    }
-    
-    inline QString text() const
     {
-        return word->text();
+        d->m_words.append( isAscii( text ) ? text : text.normalized(QString::NormalizationForm_KC), *area );
+        d->invalidateSearchText();
     }
-    
-    inline const NormalizedRect &area() const
-    {
-      return word->area;
-    }
-    
-    TinyTextEntity *word;
-    TextList characters;
-};
-typedef QList<WordWithCharacters> WordsWithCharacters;
-
-/**
- * We will divide the whole page in some regions depending on the horizontal and
- * vertical spacing among different regions. Each region will have an area and an
- * associated WordsWithCharacters in sorted order.
-*/
-class RegionText
-{
-
-public:
-    RegionText()
-    {
-    };
-
-    RegionText(const WordsWithCharacters &wordsWithCharacters, const QRect &area)
-        : m_region_wordWithCharacters(wordsWithCharacters), m_area(area)
-    {
-    }
-    
-    inline QString string() const
-    {
-        QString res;
-        foreach(const WordWithCharacters &word, m_region_wordWithCharacters)
-            res += word.text();
-        return res;
-    }
-
-    inline WordsWithCharacters text() const
-    {
-        return m_region_wordWithCharacters;
-    }
-
-    inline QRect area() const
-    {
-        return m_area;
-    }
-
-    inline void setArea(const QRect &area)
-    {
-        m_area = area;
-    }
-
-    inline void setText(const WordsWithCharacters &wordsWithCharacters)
-    {
-        m_region_wordWithCharacters = wordsWithCharacters;
-    }
-
-private:
-    WordsWithCharacters m_region_wordWithCharacters;
-    QRect m_area;
-};
+    delete area;
+}
 
 RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
 {
@@ -541,15 +726,15 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
         if(endC.y * scaleY < minY) endC.y = minY/scaleY;
     }
 
-    TextList::ConstIterator it = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
-    TextList::ConstIterator start = it, end = itEnd, tmpIt = it; //, tmpItEnd = itEnd;
+    int it = 0, itEnd = d->m_words.count();
+    int start = it, end = itEnd, tmpIt = it; //, tmpItEnd = itEnd;
     const MergeSide side = d->m_page ? (MergeSide)d->m_page->m_page->totalOrientation() : MergeRight;
 
     NormalizedRect tmp;
     //case 2(a)
     for ( ; it != itEnd; ++it )
     {
-        tmp = (*it)->area;
+        tmp = d->m_words.area(it);
         if(tmp.contains(startC.x,startC.y)){
             start = it;
         }
@@ -565,7 +750,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
         for ( ; it != itEnd; ++it )
         {
             // is there any text reactangle within the start_end rect
-            tmp = (*it)->area;
+            tmp = d->m_words.area(it);
             if(start_end.intersects(tmp))
                 break;
         }
@@ -591,7 +776,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
         {
             for ( ; it != itEnd; ++it )
             {
-                rect= (*it)->area;
+                rect= d->m_words.area(it);
                 rect.isBottom(startC) ? flagV = false: flagV = true;
 
                 if(flagV && rect.isRight(startC))
@@ -611,7 +796,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
 
             for ( ; it != itEnd; ++it )
             {
-                rect= (*it)->area;
+                rect= d->m_words.area(it);
 
                 if(rect.isBottomOrLevel(startC) && rect.isRight(startC))
                 {
@@ -648,7 +833,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
         {
             for ( ; itEnd >= it; itEnd-- )
             {
-                rect= (*itEnd)->area;
+                rect= d->m_words.area(itEnd);
                 rect.isTop(endC) ? flagV = false: flagV = true;
 
                 if(flagV && rect.isLeft(endC))
@@ -664,7 +849,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
             int distance = scaleX + scaleY + 100;
             for ( ; itEnd >= it; itEnd-- )
             {
-                rect= (*itEnd)->area;
+                rect= d->m_words.area(itEnd);
 
                 if(rect.isTopOrLevel(endC) && rect.isLeft(endC))
                 {
@@ -709,11 +894,11 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
     }
 
     // removes the possibility of crash, in case none of 1 to 3 is true
-    if(end == d->m_words.constEnd()) end--;
+    if(end == d->m_words.count()) end--;
 
     for( ;start <= end ; start++)
     {
-        ret->appendShape( (*start)->transformedArea( matrix ), side );
+        ret->appendShape( d->m_words.transformedArea( start, matrix ), side );
      }
 
 #endif
@@ -722,74 +907,109 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
 }
 
 
+// returns the last result of the search @p searchID, if any; otherwise
+// @p direction is changed to start from the beginning (respecting the
+// search direction)
+static const SearchPoint *lastSearchPoint( const QMap< int, SearchPoint* > &searchPoints, int searchID, SearchDirection *direction )
+{
+    const SearchPoint *sp = searchPoints.value( searchID );
+    if ( !sp )
+    {
+        if ( *direction == NextResult )
+            *direction = FromTop;
+        else if ( *direction == PreviousResult )
+            *direction = FromBottom;
+    }
+    return sp;
+}
+
 RegularAreaRect* TextPage::findText( int searchID, const QString &query, SearchDirection direct,
                                      Qt::CaseSensitivity caseSensitivity, const RegularAreaRect *area )
+{
+    return findText( searchID, query, direct, caseSensitivity, ExactComparison, area );
+}
+
+RegularAreaRect* TextPage::findText( int searchID, const QString &query, SearchDirection direct,
+                                     Qt::CaseSensitivity caseSensitivity, TextComparison comparison,
+                                     const RegularAreaRect *area )
 {
     SearchDirection dir=direct;
     // invalid search request
     if ( d->m_words.isEmpty() || query.isEmpty() || ( area && area->isNull() ) )
         return 0;
-    TextList::ConstIterator start;
-    TextList::ConstIterator end;
-    const QMap< int, SearchPoint* >::const_iterator sIt = d->m_searchPoints.constFind( searchID );
-    if ( sIt == d->m_searchPoints.constEnd() )
-    {
-        // if no previous run of this search is found, then set it to start
-        // from the beginning (respecting the search direction)
-        if ( dir == NextResult )
-            dir = FromTop;
-        else if ( dir == PreviousResult )
-            dir = FromBottom;
-    }
-    bool forward = true;
+    const SearchPoint *sp = lastSearchPoint( d->m_searchPoints, searchID, &dir );
+
+    if ( comparison != ExactComparison )
+        return d->findLooseText( searchID, query, dir, comparison == ApproximateComparison, sp );
+
+    const QString &text = d->searchText( caseSensitivity );
+    const QString &pattern = d->searchPattern( query, caseSensitivity, ExactComparison );
+    if ( pattern.isEmpty() )
+        return 0;
+
+    int begin = -1;
     switch ( dir )
     {
         case FromTop:
-            start = d->m_words.constBegin();
-            end = d->m_words.constEnd();
+            begin = findPattern( text, 0, text.length(), pattern, d->m_patternFailure, false );
             break;
         case FromBottom:
-            start = d->m_words.constEnd();
-            end = d->m_words.constBegin();
-            Q_ASSERT( start != end );
-            // we can safely go one step back, as we already checked
-            // that the list is not empty
-            --start;
-            forward = false;
+            begin = findPattern( text, 0, text.length(), pattern, d->m_patternFailure, true );
             break;
         case NextResult:
-            start = (*sIt)->it_end;
-            end = d->m_words.constEnd();
-            if ( ( start + 1 ) != end )
-                ++start;
+            begin = findPattern( text, sp->end, text.length(), pattern, d->m_patternFailure, false );
             break;
         case PreviousResult:
-            start = (*sIt)->it_begin;
-            end = d->m_words.constBegin();
-            if ( start != end )
-                --start;
-            forward = false;
+            begin = findPattern( text, 0, sp->begin, pattern, d->m_patternFailure, true );
             break;
     };
-    RegularAreaRect* ret = 0;
-    const TextComparisonFunction cmpFn = caseSensitivity == Qt::CaseSensitive
-                                       ? CaseSensitiveCmpFn : CaseInsensitiveCmpFn;
-    if ( forward )
-    {
-        ret = d->findTextInternalForward( searchID, query, caseSensitivity, cmpFn, start, end );
-    }
-    else
+    return d->searchResult( searchID, begin, begin + pattern.length() );
+}
+
+RegularAreaRect* TextPage::findText( int searchID, const QRegExp &regExp, SearchDirection direct,
+                                     const RegularAreaRect *area )
+{
+    SearchDirection dir=direct;
+    // invalid search request
+    if ( d->m_words.isEmpty() || regExp.isEmpty() || !regExp.isValid() || ( area && area->isNull() ) )
+        return 0;
+    const SearchPoint *sp = lastSearchPoint( d->m_searchPoints, searchID, &dir );
+
+    // the regular expression deals with the case by itself
+    const QString &text = d->searchText( Qt::CaseSensitive );
+
+    int begin = -1;
+    int length = 0;
+    switch ( dir )
     {
-        ret = d->findTextInternalBackward( searchID, query, caseSensitivity, cmpFn, start, end );
-    }
-    return ret;
+        case FromTop:
+            begin = findRegExp( text, 0, text.length(), regExp, false, &length );
+            break;
+        case FromBottom:
+            begin = findRegExp( text, 0, text.length(), regExp, true, &length );
+            break;
+        case NextResult:
+            begin = findRegExp( text, sp->end, text.length(), regExp, false, &length );
+            break;
+        case PreviousResult:
+            begin = findRegExp( text, 0, sp->begin, regExp, true, &length );
+            break;
+    };
+    return d->searchResult( searchID, begin, begin + length );
+}
+
+// the same as QString::midRef, that QStringRef does not have
+static inline QStringRef midRef( const QStringRef &str, int position, int n )
+{
+    position = qBound( 0, position, str.length() );
+    return QStringRef( str.string(), str.position() + position, qMin( n, str.length() - position ) );
 }
 
 // hyphenated '-' must be at the end of a word, so hyphenation means
 // we have a '-' just followed by a '\n' character
 // check if the string contains a '-' character
 // if the '-' is the last entry
-static int stringLengthAdaptedWithHyphen(const QString &str, const TextList::ConstIterator &it, const TextList::ConstIterator &end, PagePrivate *page)
+static int stringLengthAdaptedWithHyphen(const QStringRef &str, const FlatTextList &words, int it, int end, PagePrivate *page)
 {
     int len = str.length();
     
@@ -797,25 +1017,25 @@ static int stringLengthAdaptedWithHyphen(const QString &str, const TextList::Con
     // we have a '-' just followed by a '\n' character
     // check if the string contains a '-' character
     // if the '-' is the last entry
-    if ( str.endsWith( '-' ) )
+    if ( str.endsWith( QLatin1Char( '-' ) ) )
     {
         // validity chek of it + 1
         if ( ( it + 1 ) != end )
         {
             // 1. if the next character is '\n'
-            const QString &lookahedStr = (*(it+1))->text();
-            if (lookahedStr.startsWith('\n'))
+            const QStringRef lookahedStr = words.text( it + 1 );
+            if (lookahedStr.startsWith(QLatin1Char('\n')))
             {
                 len -= 1;
             }
-            else
+            else if ( page )
             {
                 // 2. if the next word is in a different line or not
                 const int pageWidth = page->m_page->width();
                 const int pageHeight = page->m_page->height();
 
-                const QRect hyphenArea = (*it)->area.roundedGeometry(pageWidth, pageHeight);
-                const QRect lookaheadArea = (*(it + 1))->area.roundedGeometry(pageWidth, pageHeight);
+                const QRect hyphenArea = words.area(it).roundedGeometry(pageWidth, pageHeight);
+                const QRect lookaheadArea = words.area(it + 1).roundedGeometry(pageWidth, pageHeight);
 
                 // lookahead to check whether both the '-' rect and next character rect overlap
                 if( !doesConsumeY( hyphenArea, lookaheadArea, 70 ) )
@@ -826,7 +1046,7 @@ static int stringLengthAdaptedWithHyphen(const QString &str, const TextList::Con
         }
     }
     // else if it is the second last entry - for example in pdf format
-    else if (str.endsWith("-\n"))
+    else if (str.endsWith(QLatin1String("-\n")))
     {
         len -= 2;
     }
@@ -834,234 +1054,135 @@ static int stringLengthAdaptedWithHyphen(const QString &str, const TextList::Con
     return len;
 }
 
-RegularAreaRect* TextPagePrivate::findTextInternalForward( int searchID, const QString &_query,
-                                                             Qt::CaseSensitivity caseSensitivity,
-                                                             TextComparisonFunction comparer,
-                                                             const TextList::ConstIterator &start,
-                                                             const TextList::ConstIterator &end )
+const QString &TextPagePrivate::searchText( Qt::CaseSensitivity caseSensitivity )
 {
-    const QTransform matrix = m_page ? m_page->rotationMatrix() : QTransform();
-
-    RegularAreaRect* ret=new RegularAreaRect;
-
-    // normalize query search all unicode (including glyphs)
-    const QString query = (caseSensitivity == Qt::CaseSensitive)
-                            ? _query.normalized(QString::NormalizationForm_KC) 
-                            : _query.toLower().normalized(QString::NormalizationForm_KC);
-
-    // j is the current position in our query
-    // len is the length of the string in TextEntity
-    // queryLeft is the length of the query we have left
-    const TinyTextEntity* curEntity = 0;
-    int j=0, len=0, queryLeft=query.length();
-    int offset = 0;
-    bool haveMatch=false;
-    bool offsetMoved = false;
-    TextList::ConstIterator it = start;
-    TextList::ConstIterator it_begin;
-    for ( ; it != end; ++it )
+    if ( m_searchOffsets.isEmpty() )
     {
-        curEntity = *it;
-        const QString &str = curEntity->text();
-        if ( !offsetMoved && ( it == start ) )
+        // the hyphens at the end of the lines are left out, so that the
+        // hyphenated words are found whole
+        const int count = m_words.count();
+        m_searchOffsets.resize( count );
+        m_searchText.clear();
+        m_foldedSearchText.clear();
+        m_looseSearchText.clear();
+        m_looseOffsets.clear();
+        for ( int i = 0; i < count; ++i )
         {
-            if ( m_searchPoints.contains( searchID ) )
-            {
-                offset = qMax( m_searchPoints[ searchID ]->offset_end, 0 );
-            }
-            offsetMoved = true;
+            const QStringRef text = m_words.text( i );
+            m_searchOffsets[ i ] = m_searchText.length();
+            m_searchText.append( midRef( text, 0, stringLengthAdaptedWithHyphen( text, m_words, i, count, m_page ) ) );
         }
-        {
-            len = stringLengthAdaptedWithHyphen(str, it, end, m_page);
-            int min=qMin(queryLeft,len);
-#ifdef DEBUG_TEXTPAGE
-            kDebug(OkularDebug) << str.mid(offset,min) << ":" << _query.mid(j,min);
-#endif
-            // we have equal (or less than) area of the query left as the length of the current 
-            // entity
+    }
 
-            int resStrLen = 0, resQueryLen = 0;
-            if ( !comparer( str.midRef( offset, min ), query.midRef( j, min ),
-                            &resStrLen, &resQueryLen ) )
-            {
-                    // we not have matched
-                    // this means we do not have a complete match
-                    // we need to get back to query start
-                    // and continue the search from this place
-                    haveMatch=false;
-                    ret->clear();
-#ifdef DEBUG_TEXTPAGE
-            kDebug(OkularDebug) << "\tnot matched";
-#endif
-                    j=0;
-                    offset = 0;
-                    queryLeft=query.length();
-                    it_begin = TextList::ConstIterator();
-            }
-            else
-            {
-                    // we have a match
-                    // move the current position in the query
-                    // to the position after the length of this string
-                    // we matched
-                    // subtract the length of the current entity from 
-                    // the left length of the query
-#ifdef DEBUG_TEXTPAGE
-            kDebug(OkularDebug) << "\tmatched";
-#endif
-                    haveMatch=true;
-                    ret->append( curEntity->transformedArea( matrix ) );
-                    j += resStrLen;
-                    queryLeft -= resQueryLen;
-                    if ( it_begin == TextList::ConstIterator() )
-                    {
-                        it_begin = it;
-                    }
-            }
-        }
+    if ( caseSensitivity == Qt::CaseSensitive )
+        return m_searchText;
 
-        if (haveMatch && queryLeft==0 && j==query.length())
-        {
-            // save or update the search point for the current searchID
-            QMap< int, SearchPoint* >::iterator sIt = m_searchPoints.find( searchID );
-            if ( sIt == m_searchPoints.end() )
-            {
-                sIt = m_searchPoints.insert( searchID, new SearchPoint );
-            }
-            SearchPoint* sp = *sIt;
-            sp->it_begin = it_begin;
-            sp->it_end = it - 1;
-            sp->offset_begin = j;
-            sp->offset_end = j + qMin( queryLeft, len );
-            ret->simplify();
-            return ret;
-        }
-    }
-    // end of loop - it means that we've ended the textentities
-    const QMap< int, SearchPoint* >::iterator sIt = m_searchPoints.find( searchID );
-    if ( sIt != m_searchPoints.end() )
+    if ( m_foldedSearchText.isNull() )
+        m_foldedSearchText = foldCase( m_searchText );
+    return m_foldedSearchText;
+}
+
+const QString &TextPagePrivate::looseSearchText()
+{
+    if ( m_searchOffsets.isEmpty() || m_looseSearchText.isNull() )
+        m_looseSearchText = foldLoosely( searchText( Qt::CaseSensitive ), &m_looseOffsets );
+    return m_looseSearchText;
+}
+
+const QString &TextPagePrivate::searchPattern( const QString &query, Qt::CaseSensitivity caseSensitivity, TextPage::TextComparison comparison )
+{
+    if ( query != m_patternQuery || caseSensitivity != m_patternCaseSensitivity || comparison != m_patternComparison || m_patternQuery.isNull() )
     {
-        SearchPoint* sp = *sIt;
-        m_searchPoints.erase( sIt );
-        delete sp;
+        // normalize query search all unicode (including glyphs)
+        const QString normalized = query.normalized( QString::NormalizationForm_KC );
+        if ( comparison != TextPage::ExactComparison )
+            m_pattern = foldLoosely( normalized, 0 );
+        else
+            m_pattern = caseSensitivity == Qt::CaseSensitive ? normalized : foldCase( normalized );
+        m_patternFailure = failureFunction( m_pattern );
+        m_patternQuery = query;
+        m_patternCaseSensitivity = caseSensitivity;
+        m_patternComparison = comparison;
     }
-    delete ret;
-    return 0;
+    return m_pattern;
 }
 
-RegularAreaRect* TextPagePrivate::findTextInternalBackward( int searchID, const QString &_query,
-                                                            Qt::CaseSensitivity caseSensitivity,
-                                                            TextComparisonFunction comparer,
-                                                            const TextList::ConstIterator &start,
-                                                            const TextList::ConstIterator &loop_end )
+RegularAreaRect * TextPagePrivate::findLooseText( int searchID, const QString &query, SearchDirection direction, bool approximate, const SearchPoint *sp )
 {
-    const QTransform matrix = m_page ? m_page->rotationMatrix() : QTransform();
+    const QString &text = looseSearchText();
+    const QString &pattern = searchPattern( query, Qt::CaseInsensitive, approximate ? TextPage::ApproximateComparison : TextPage::LooseComparison );
+    if ( pattern.isEmpty() )
+        return 0;
 
-    RegularAreaRect* ret=new RegularAreaRect;
-
-    // normalize query to search all unicode (including glyphs)
-    const QString query = (caseSensitivity == Qt::CaseSensitive) 
-                            ? _query.normalized(QString::NormalizationForm_KC) 
-                            : _query.toLower().normalized(QString::NormalizationForm_KC);
-
-    // j is the current position in our query
-    // len is the length of the string in TextEntity
-    // queryLeft is the length of the query we have left
-    const TinyTextEntity* curEntity = 0;
-    int j=query.length() - 1, len=0, queryLeft=query.length();
-    bool haveMatch=false;
-    bool offsetMoved = false;
-    TextList::ConstIterator it = start;
-    TextList::ConstIterator it_begin;
-    while ( true )
-    {
-        curEntity = *it;
-        const QString &str = curEntity->text();
-        if ( !offsetMoved && ( it == start ) )
-        {
-            offsetMoved = true;
-        }
-        {
-            len = stringLengthAdaptedWithHyphen(str, it, m_words.constEnd(), m_page);
-            int min=qMin(queryLeft,len);
-#ifdef DEBUG_TEXTPAGE
-            kDebug(OkularDebug) << str.right(min) << " : " << _query.mid(j-min+1,min);
-#endif
-            // we have equal (or less than) area of the query left as the length of the current 
-            // entity
-
-            int resStrLen = 0, resQueryLen = 0;
-            // Note len is not str.length() so we can't use rightRef here
-            const int offset = len - min;
-            if ( !comparer( str.midRef(offset, min ), query.midRef( j - min + 1, min ),
-                            &resStrLen, &resQueryLen ) )
-            {
-                    // we not have matched
-                    // this means we do not have a complete match
-                    // we need to get back to query start
-                    // and continue the search from this place
-                    haveMatch=false;
-                    ret->clear();
-#ifdef DEBUG_TEXTPAGE
-                    kDebug(OkularDebug) << "\tnot matched";
-#endif
-                    j=query.length() - 1;
-                    queryLeft=query.length();
-                    it_begin = TextList::ConstIterator();
-            }
-            else
-            {
-                    // we have a match
-                    // move the current position in the query
-                    // to the position after the length of this string
-                    // we matched
-                    // subtract the length of the current entity from 
-                    // the left length of the query
-#ifdef DEBUG_TEXTPAGE
-                    kDebug(OkularDebug) << "\tmatched";
-#endif
-                    haveMatch=true;
-                    ret->append( curEntity->transformedArea( matrix ) );
-                    j -= resStrLen;
-                    queryLeft -= resQueryLen;
-                    if ( it_begin == TextList::ConstIterator() )
-                    {
-                        it_begin = it;
-                    }
-            }
-        }
+    // the last match is in searchText(), find where it is in the loose text
+    int from = 0, to = text.length();
+    if ( direction == NextResult )
+        from = qLowerBound( m_looseOffsets.constBegin(), m_looseOffsets.constEnd(), sp->end ) - m_looseOffsets.constBegin();
+    else if ( direction == PreviousResult )
+        to = qLowerBound( m_looseOffsets.constBegin(), m_looseOffsets.constEnd(), sp->begin ) - m_looseOffsets.constBegin();
+    const bool last = direction == FromBottom || direction == PreviousResult;
+
+    // with so few characters, one more or less would match almost anywhere
+    int begin, length = pattern.length();
+    if ( approximate && pattern.length() >= 4 )
+        begin = findApproximate( text, from, to, pattern, last, &length );
+    else
+        begin = findPattern( text, from, to, pattern, m_patternFailure, last );
+
+    if ( begin == -1 )
+        return searchResult( searchID, -1, -1 );
+    return searchResult( searchID, m_looseOffsets.at( begin ), m_looseOffsets.at( begin + length - 1 ) + 1 );
+}
+
+qulonglong TextPagePrivate::memoryUsage() const
+{
+    // the search text, its case folded copy and the offsets of the entities
+    const qulonglong searchTextMemory = (qulonglong)m_words.allText().length() * 2 * sizeof( QChar ) + (qulonglong)m_words.count() * sizeof( int );
+    // and the loose copy, only made for the loose searches
+    const qulonglong looseTextMemory = (qulonglong)m_looseSearchText.capacity() * sizeof( QChar ) + (qulonglong)m_looseOffsets.capacity() * sizeof( int );
+    return sizeof( TextPagePrivate ) + m_words.memoryUsage() + searchTextMemory + looseTextMemory;
+}
+
+void TextPagePrivate::invalidateSearchText()
+{
+    m_searchOffsets.clear();
+}
+
+int TextPagePrivate::entityAt( int position ) const
+{
+    // the entities without text share the offset of the next one
+    return qUpperBound( m_searchOffsets.constBegin(), m_searchOffsets.constEnd(), position ) - m_searchOffsets.constBegin() - 1;
+}
 
-        if (haveMatch && queryLeft==0 && j<0)
+RegularAreaRect * TextPagePrivate::searchResult( int searchID, int begin, int end )
+{
+    QMap< int, SearchPoint* >::iterator sIt = m_searchPoints.find( searchID );
+    if ( begin == -1 )
+    {
+        // end of the search, forget where it was
+        if ( sIt != m_searchPoints.end() )
         {
-            // save or update the search point for the current searchID
-            QMap< int, SearchPoint* >::iterator sIt = m_searchPoints.find( searchID );
-            if ( sIt == m_searchPoints.end() )
-            {
-                sIt = m_searchPoints.insert( searchID, new SearchPoint );
-            }
-            SearchPoint* sp = *sIt;
-            sp->it_begin = it;
-            sp->it_end = it_begin;
-            sp->offset_begin = j;
-            sp->offset_end = j + qMin( queryLeft, len );
-            ret->simplify();
-            return ret;
+            delete *sIt;
+            m_searchPoints.erase( sIt );
         }
-        if ( it == loop_end )
-            break;
-        else
-            --it;
+        return 0;
     }
-    // end of loop - it means that we've ended the textentities
-    const QMap< int, SearchPoint* >::iterator sIt = m_searchPoints.find( searchID );
-    if ( sIt != m_searchPoints.end() )
+
+    // save or update the search point for the current searchID
+    if ( sIt == m_searchPoints.end() )
     {
-        SearchPoint* sp = *sIt;
-        m_searchPoints.erase( sIt );
-        delete sp;
+        sIt = m_searchPoints.insert( searchID, new SearchPoint );
     }
-    delete ret;
-    return 0;
+    (*sIt)->begin = begin;
+    (*sIt)->end = end;
+
+    const QTransform matrix = m_page ? m_page->rotationMatrix() : QTransform();
+    RegularAreaRect *ret = new RegularAreaRect;
+    const int last = entityAt( end - 1 );
+    for ( int it = entityAt( begin ); it <= last; ++it )
+        ret->append( m_words.transformedArea( it, matrix ) );
+    ret->simplify();
+    return ret;
 }
 
 QString TextPage::text(const RegularAreaRect *area) const
@@ -1074,203 +1195,213 @@ QString TextPage::text(const RegularAreaRect *area, TextAreaInclusionBehaviour b
     if ( area && area->isNull() )
         return QString();
 
-    TextList::ConstIterator it = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
+    const int count = d->m_words.count();
     QString ret;
     if ( area )
     {
-        for ( ; it != itEnd; ++it )
+        for ( int it = 0; it < count; ++it )
         {
             if (b == AnyPixelTextAreaInclusionBehaviour)
             {
-                if ( area->intersects( (*it)->area ) )
+                if ( area->intersects( d->m_words.area( it ) ) )
                 {
-                    ret += (*it)->text();
+                    ret += d->m_words.text( it );
                 }
             }
             else
             {
-                NormalizedPoint center = (*it)->area.center();
+                NormalizedPoint center = d->m_words.area( it ).center();
                 if ( area->contains( center.x, center.y ) )
                 {
-                    ret += (*it)->text();
+                    ret += d->m_words.text( it );
                 }
             }
         }
     }
     else
     {
-        for ( ; it != itEnd; ++it )
-            ret += (*it)->text();
+        // the text of all the entities is a single buffer already
+        ret = d->m_words.allText();
     }
     return ret;
 }
 
-static bool compareTinyTextEntityX(const WordWithCharacters &first, const WordWithCharacters &second)
+/**
+ * The state of the text ordering of a page. The characters and the words
+ * are kept in arrays and referred to by their index: the lines and the
+ * regions are ranges of index arrays, which are sorted and partitioned in
+ * place instead of copying lists of words at each step.
+ */
+struct LayoutCharacter
 {
-    QRect firstArea = first.area().roundedGeometry(1000,1000);
-    QRect secondArea = second.area().roundedGeometry(1000,1000);
+    // the entity of the character in the unordered text
+    int entity;
+    QRect roundedArea;
+};
 
-    return firstArea.left() < secondArea.left();
-}
+struct LayoutWord
+{
+    // the characters of the word, first and last included
+    int firstCharacter;
+    int lastCharacter;
+    // the areas of the word, computed once as roundedGeometry and geometry
+    QRect roundedArea;
+    QRect area;
+    // the position used to sort the words
+    int sortLeft;
+    int sortTop;
+};
 
-static bool compareTinyTextEntityY(const WordWithCharacters &first, const WordWithCharacters &second)
+struct LayoutRange
 {
-    const QRect firstArea = first.area().roundedGeometry(1000,1000);
-    const QRect secondArea = second.area().roundedGeometry(1000,1000);
+    LayoutRange( int b = 0, int e = 0, const QRect &a = QRect() )
+        : begin( b ), end( e ), area( a )
+    {
+    }
 
-    return firstArea.top() < secondArea.top();
-}
+    int begin;
+    int end;
+    QRect area;
+};
+
+struct PageLayout
+{
+    QVector< LayoutCharacter > characters;
+    QVector< LayoutWord > words;
+    int pageWidth;
+    int pageHeight;
+};
+
+class CompareWordsX
+{
+    public:
+        CompareWordsX( const QVector< LayoutWord > &words ) : m_words( words.constData() ) {}
+
+        bool operator()( int first, int second ) const
+        {
+            return m_words[ first ].sortLeft < m_words[ second ].sortLeft;
+        }
+
+    private:
+        const LayoutWord *m_words;
+};
+
+class CompareWordsY
+{
+    public:
+        CompareWordsY( const QVector< LayoutWord > &words ) : m_words( words.constData() ) {}
+
+        bool operator()( int first, int second ) const
+        {
+            return m_words[ first ].sortTop < m_words[ second ].sortTop;
+        }
+
+    private:
+        const LayoutWord *m_words;
+};
+
+class WordIntersects
+{
+    public:
+        WordIntersects( const QVector< LayoutWord > &words, const QRect &rect ) : m_words( words.constData() ), m_rect( rect ) {}
+
+        bool operator()( int word ) const
+        {
+            return m_rect.intersects( m_words[ word ].area );
+        }
+
+    private:
+        const LayoutWord *m_words;
+        QRect m_rect;
+};
 
 /**
- * Sets a new world list. Deleting the contents of the old one
+ * The smallest rectangle containing @p first and @p second, like
+ * QRect::united: a null rectangle adds nothing, and the rectangles with a
+ * negative size are normalized first
  */
-void TextPagePrivate::setWordList(const TextList &list)
+static inline QRect unitedArea( const QRect &first, const QRect &second )
 {
-    qDeleteAll(m_words);
-    m_words = list;
+    if ( first.isNull() )
+        return second;
+    if ( second.isNull() )
+        return first;
+
+    const int left = qMin( first.width() < 0 ? first.right() : first.left(), second.width() < 0 ? second.right() : second.left() );
+    const int right = qMax( first.width() < 0 ? first.left() : first.right(), second.width() < 0 ? second.left() : second.right() );
+    const int top = qMin( first.height() < 0 ? first.bottom() : first.top(), second.height() < 0 ? second.bottom() : second.top() );
+    const int bottom = qMax( first.height() < 0 ? first.top() : first.bottom(), second.height() < 0 ? second.top() : second.bottom() );
+    return QRect( QPoint( left, top ), QPoint( right, bottom ) );
 }
 
 /**
- * Remove all the spaces in between texts. It will make all the generators
- * same, whether they save spaces(like pdf) or not(like djvu).
+ * Take the characters out of the flat list, without the spaces in between
+ * texts. It will make all the generators same, whether they save spaces(like
+ * pdf) or not(like djvu).
  */
-static void removeSpace(TextList *words)
+static void charactersWithoutSpace( const FlatTextList &words, PageLayout *layout )
 {
-    TextList::Iterator it = words->begin();
-    const QString str(' ');
-
-    while ( it != words->end() )
+    const QLatin1String str( " " );
+    layout->characters.reserve( words.count() );
+    for ( int i = 0; i < words.count(); ++i )
     {
-        if((*it)->text() == str)
-        {
-            it = words->erase(it);
-        }
-        else
+        if ( words.text( i ) != str )
         {
-            ++it;
+            const LayoutCharacter character = { i, words.area( i ).roundedGeometry( layout->pageWidth, layout->pageHeight ) };
+            layout->characters.append( character );
         }
     }
 }
 
 /**
- * We will read the TinyTextEntity from characters and try to create words from there.
+ * We will read the characters and try to create words from there.
  * Note: characters might be already characters for some generators, but we will keep
- * the nomenclature characters for the generator produced data. The resulting
- * WordsWithCharacters memory has to be managed by the caller, both the 
- * WordWithCharacters::word and WordWithCharacters::characters contents
+ * the nomenclature characters for the generator produced data.
  */
-static WordsWithCharacters makeWordFromCharacters(const TextList &characters, int pageWidth, int pageHeight)
+static void makeWordFromCharacters( PageLayout *layout )
 {
     /**
-     * We will traverse characters and try to create words from the TinyTextEntities in it.
-     * We will search TinyTextEntity blocks and merge them until we get a
-     * space between two consecutive TinyTextEntities. When we get a space
-     * we can take it as a end of word. Then we store the word as a TinyTextEntity
-     * and keep it in newList.
-
-     * We create a RegionText named regionWord that contains the word and the characters associated with it and
-     * a rectangle area of the element in newList. 
-
+     * We will traverse characters and merge them until we get a space
+     * between two consecutive characters, or a character that is not on
+     * the same line. Then the merged characters make a word.
      */
-    WordsWithCharacters wordsWithCharacters;
+    const QVector< LayoutCharacter > &characters = layout->characters;
+    const int count = characters.count();
 
-    TextList::ConstIterator it = characters.begin(), itEnd = characters.end(), tmpIt;
-    int newLeft,newRight,newTop,newBottom;
-    int index = 0;
-
-    for( ; it != itEnd ; it++)
+    for ( int i = 0; i < count; ++i )
     {
-        QString textString = (*it)->text();
-        QString newString;
-        QRect lineArea = (*it)->area.roundedGeometry(pageWidth,pageHeight),elementArea;
-        TextList wordCharacters;
-        tmpIt = it;
-        int space = 0;
-
-        while (!space)
-        {
-            if (textString.length())
-            {
-                newString.append(textString);
-
-                // when textString is the start of the word
-                if (tmpIt == it)
-                {
-                    NormalizedRect newRect(lineArea,pageWidth,pageHeight);
-                    wordCharacters.append(new TinyTextEntity(textString.normalized
-                                                   (QString::NormalizationForm_KC), newRect));
-                }
-                else
-                {
-                    NormalizedRect newRect(elementArea,pageWidth,pageHeight);
-                    wordCharacters.append(new TinyTextEntity(textString.normalized
-                                                   (QString::NormalizationForm_KC), newRect));
-                }
-            }
+        const int first = i;
+        QRect lineArea = characters.at( i ).roundedArea;
 
-            ++it;
-
-            /*
-             we must have to put this line before the if condition of it==itEnd
-             otherwise the last character can be missed
-             */
-            if (it == itEnd) break;
-            elementArea = (*it)->area.roundedGeometry(pageWidth,pageHeight);
-            if (!doesConsumeY(elementArea, lineArea, 60))
-            {
-                --it;
+        while ( i + 1 < count )
+        {
+            const QRect &elementArea = characters.at( i + 1 ).roundedArea;
+            if ( !doesConsumeY( elementArea, lineArea, 60 ) )
                 break;
-            }
-
-            const int text_y1 = elementArea.top() ,
-                      text_x1 = elementArea.left(),
-                      text_y2 = elementArea.y() + elementArea.height(),
-                      text_x2 = elementArea.x() + elementArea.width();
-            const int line_y1 = lineArea.top() ,line_x1 = lineArea.left(),
-                      line_y2 = lineArea.y() + lineArea.height(),
-                      line_x2 = lineArea.x() + lineArea.width();
 
-            space = elementArea.left() - lineArea.right();
-
-            if (space != 0)
-            {
-                it--;
+            const int space = elementArea.left() - lineArea.right();
+            if ( space != 0 )
                 break;
-            }
-
-            newLeft = text_x1 < line_x1 ? text_x1 : line_x1;
-            newRight = line_x2 > text_x2 ? line_x2 : text_x2;
-            newTop = text_y1 > line_y1 ? line_y1 : text_y1;
-            newBottom = text_y2 > line_y2 ? text_y2 : line_y2;
-
-            lineArea.setLeft (newLeft);
-            lineArea.setTop (newTop);
-            lineArea.setWidth( newRight - newLeft );
-            lineArea.setHeight( newBottom - newTop );
 
-            textString = (*it)->text();
+            lineArea = unitedArea( lineArea, elementArea );
+            ++i;
         }
 
-        // if newString is not empty, save it
-        if (!newString.isEmpty())
-        {
-            const NormalizedRect newRect(lineArea, pageWidth, pageHeight);
-            TinyTextEntity *word = new TinyTextEntity(newString.normalized(QString::NormalizationForm_KC), newRect);
-            wordsWithCharacters.append(WordWithCharacters(word, wordCharacters));
-
-            index++;
-        }
-
-        if(it == itEnd) break;
+        const NormalizedRect wordArea( lineArea, layout->pageWidth, layout->pageHeight );
+        const QRect sortArea = wordArea.roundedGeometry( 1000, 1000 );
+        const LayoutWord word = { first, i,
+                                  wordArea.roundedGeometry( layout->pageWidth, layout->pageHeight ),
+                                  wordArea.geometry( layout->pageWidth, layout->pageHeight ),
+                                  sortArea.left(), sortArea.top() };
+        layout->words.append( word );
     }
-    
-    return wordsWithCharacters;
 }
 
 /**
- * Create Lines from the words and sort them
+ * Create Lines from the @p count words in @p words and sort them.
+ * The words of the lines are stored in @p order, the lines are ranges of it.
  */
-QList< QPair<WordsWithCharacters, QRect> > makeAndSortLines(const WordsWithCharacters &wordsTmp, int pageWidth, int pageHeight)
+static void makeAndSortLines( const PageLayout &layout, const int *words, int count, QVector< int > *order, QVector< LayoutRange > *lines )
 {
     /**
      * We cannot assume that the generator will give us texts in the right order.
@@ -1279,92 +1410,80 @@ QList< QPair<WordsWithCharacters, QRect> > makeAndSortLines(const WordsWithChara
      * So, we need to:
      **
      * 1. Sort rectangles/boxes containing texts by y0(top)
-     * 2. Create textline where there is y overlap between TinyTextEntity 's
-     * 3. Within each line sort the TinyTextEntity 's by x0(left)
-     */
-    
-    QList< QPair<WordsWithCharacters, QRect> > lines;
-
-    /*
-     Make a new copy of the TextList in the words, so that the wordsTmp and lines do
-     not contain same pointers for all the TinyTextEntity.
+     * 2. Create textline where there is y overlap between the words
+     * 3. Within each line sort the words by x0(left)
      */
-    QList<WordWithCharacters> words = wordsTmp;
+    lines->clear();
+    order->resize( count );
+    if ( count == 0 )
+        return;
 
     // Step 1
-    qSort(words.begin(),words.end(),compareTinyTextEntityY);
+    QVector< int > sorted( count );
+    qCopy( words, words + count, sorted.begin() );
+    qSort( sorted.begin(), sorted.end(), CompareWordsY( layout.words ) );
 
     // Step 2
-    QList<WordWithCharacters>::Iterator it = words.begin(), itEnd = words.end();
+    /* the line areas which will be expanded
+       they are only necessary to preserve the topmin and bottommax of all
+       the texts in the line, left and right is not necessary at all
+    */
+    QVector< QRect > lineAreas;
+    QVector< int > lineOfWord( count );
+    QVector< int > lineSizes;
 
-    //for every non-space texts(characters/words) in the textList
-    for( ; it != itEnd ; it++)
+    //for every non-space texts(characters/words)
+    for ( int i = 0; i < count; ++i )
     {
-        const QRect elementArea = (*it).area().roundedGeometry(pageWidth,pageHeight);
-        bool found = false;
+        const QRect &elementArea = layout.words.at( sorted.at( i ) ).roundedArea;
+        const int lineCount = lineAreas.count();
+        int line = 0;
 
-        for( int i = 0 ; i < lines.length() ; i++)
-        {
-            /* the line area which will be expanded
-               line_rects is only necessary to preserve the topmin and bottommax of all
-               the texts in the line, left and right is not necessary at all
-            */
-            QRect &lineArea = lines[i].second;
-            const int text_y1 = elementArea.top() ,
-                      text_y2 = elementArea.top() + elementArea.height() ,
-                      text_x1 = elementArea.left(),
-                      text_x2 = elementArea.left() + elementArea.width();
-            const int line_y1 = lineArea.top() ,
-                      line_y2 = lineArea.top() + lineArea.height(),
-                      line_x1 = lineArea.left(),
-                      line_x2 = lineArea.left() + lineArea.width();
-
-            /*
-               if the new text and the line has y overlapping parts of more than 70%,
-               the text will be added to this line
-             */
-            if(doesConsumeY(elementArea,lineArea,70))
-            {
-                WordsWithCharacters &line = lines[i].first;
-                line.append(*it);
-
-                const int newLeft = line_x1 < text_x1 ? line_x1 : text_x1;
-                const int newRight = line_x2 > text_x2 ? line_x2 : text_x2;
-                const int newTop = line_y1 < text_y1 ? line_y1 : text_y1;
-                const int newBottom = text_y2 > line_y2 ? text_y2 : line_y2;
-
-                lineArea = QRect( newLeft,newTop, newRight - newLeft, newBottom - newTop );
-                found = true;
-            }
-
-            if(found) break;
-        }
+        /*
+           if the new text and the line has y overlapping parts of more than 70%,
+           the text will be added to this line
+         */
+        while ( line < lineCount && !doesConsumeY( elementArea, lineAreas.at( line ), 70 ) )
+            ++line;
 
-        /* when we have found a new line create a new TextList containing
-           only one element and append it to the lines
+        /* when we have found a new line create a new line containing
+           only one element
          */
-        if(!found)
+        if ( line == lineCount )
         {
-            WordsWithCharacters tmp;
-            tmp.append((*it));
-            lines.append(QPair<WordsWithCharacters, QRect>(tmp, elementArea));
+            lineAreas.append( elementArea );
+            lineSizes.append( 1 );
         }
+        else
+        {
+            lineAreas[ line ] = unitedArea( lineAreas.at( line ), elementArea );
+            ++lineSizes[ line ];
+        }
+        lineOfWord[ i ] = line;
     }
 
-    // Step 3
-    for(int i = 0 ; i < lines.length() ; i++)
+    // group the words by line, keeping their order
+    lines->resize( lineAreas.count() );
+    QVector< int > next( lineAreas.count() );
+    int begin = 0;
+    for ( int line = 0; line < lineAreas.count(); ++line )
     {
-        WordsWithCharacters &list = lines[i].first;
-        qSort(list.begin(), list.end(), compareTinyTextEntityX);
+        ( *lines )[ line ] = LayoutRange( begin, begin + lineSizes.at( line ), lineAreas.at( line ) );
+        next[ line ] = begin;
+        begin += lineSizes.at( line );
     }
-    
-    return lines;
+    for ( int i = 0; i < count; ++i )
+        ( *order )[ next[ lineOfWord.at( i ) ]++ ] = sorted.at( i );
+
+    // Step 3
+    for ( int line = 0; line < lines->count(); ++line )
+        qSort( order->begin() + lines->at( line ).begin, order->begin() + lines->at( line ).end, CompareWordsX( layout.words ) );
 }
 
 /**
  * Calculate Statistical information from the lines we made previously
  */
-static void calculateStatisticalInformation(const QList<WordWithCharacters> &words, int pageWidth, int pageHeight, int *word_spacing, int *line_spacing, int *col_spacing)
+static void calculateStatisticalInformation(const PageLayout &layout, const int *words, int count, int *word_spacing, int *line_spacing, int *col_spacing)
 {
     /**
      * For the region, defined by line_rects and lines
@@ -1372,22 +1491,25 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
      * 2. Make character statistical analysis to differentiate between
      *   word spacing and column spacing.
      */
-    
+    const int pageWidth = layout.pageWidth;
+
     /**
      * Step 0
      */
-    const QList< QPair<WordsWithCharacters, QRect> > sortedLines = makeAndSortLines(words, pageWidth, pageHeight);
+    QVector< int > order;
+    QVector< LayoutRange > sortedLines;
+    makeAndSortLines(layout, words, count, &order, &sortedLines);
 
     /**
      * Step 1
      */
     QMap<int,int> line_space_stat;
-    for(int i = 0 ; i < sortedLines.length(); i++)
+    for(int i = 0 ; i < sortedLines.count(); i++)
     {
-        const QRect rectUpper = sortedLines.at(i).second;
+        const QRect rectUpper = sortedLines.at(i).area;
 
-        if(i+1 == sortedLines.length()) break;
-        const QRect rectLower = sortedLines.at(i+1).second;
+        if(i+1 == sortedLines.count()) break;
+        const QRect rectLower = sortedLines.at(i+1).area;
 
         int linespace = rectLower.top() - (rectUpper.top() + rectUpper.height());
         if(linespace < 0) linespace =-linespace;
@@ -1416,38 +1538,22 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
     // We would like to use QMap instead of QHash as it will keep the keys sorted
     QMap<int,int> hor_space_stat;
     QMap<int,int> col_space_stat;
-    QList< QList<QRect> > space_rects;
-    QList<QRect> max_hor_space_rects;
 
     // Space in every line
-    for(int i = 0 ; i < sortedLines.length() ; i++)
+    for(int i = 0 ; i < sortedLines.count() ; i++)
     {
-        const WordsWithCharacters list = sortedLines.at(i).first;
-        QList<QRect> line_space_rects;
+        const LayoutRange &line = sortedLines.at(i);
         int maxSpace = 0, minSpace = pageWidth;
 
-        // for every TinyTextEntity element in the line
-        WordsWithCharacters::ConstIterator it = list.begin(), itEnd = list.end();
-        QRect max_area1,max_area2;
-        QString before_max, after_max;
-
-        // for every line
-        for( ; it != itEnd ; it++ )
+        // for every word in the line
+        for(int j = line.begin ; j + 1 < line.end ; j++ )
         {
-            const QRect area1 = (*it).area().roundedGeometry(pageWidth,pageHeight);
-            if( it+1 == itEnd ) break;
-
-            const QRect area2 = (*(it+1)).area().roundedGeometry(pageWidth,pageHeight);
+            const QRect &area1 = layout.words.at(order.at(j)).roundedArea;
+            const QRect &area2 = layout.words.at(order.at(j+1)).roundedArea;
             int space = area2.left() - area1.right();
 
             if(space > maxSpace)
-            {
-                max_area1 = area1;
-                max_area2 = area2;
                 maxSpace = space;
-                before_max = (*it).text();
-                after_max = (*(it+1)).text();
-            }
 
             if(space < minSpace && space != 0) minSpace = space;
 
@@ -1457,22 +1563,9 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
                 // increase the count of the space amount
                 if(hor_space_stat.contains(space)) hor_space_stat[space] = hor_space_stat[space]++;
                 else hor_space_stat[space] = 1;
-
-                int left,right,top,bottom;
-
-                left = area1.right();
-                right = area2.left();
-
-                top = area2.top() < area1.top() ? area2.top() : area1.top();
-                bottom = area2.bottom() > area1.bottom() ? area2.bottom() : area1.bottom();
-
-                QRect rect(left,top,right-left,bottom-top);
-                line_space_rects.append(rect);
             }
         }
 
-        space_rects.append(line_space_rects);
-
         if(hor_space_stat.contains(maxSpace))
         {
             if(hor_space_stat[maxSpace] != 1)
@@ -1485,19 +1578,7 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
             if (col_space_stat.contains(maxSpace))
                 col_space_stat[maxSpace] = col_space_stat[maxSpace]++;
             else col_space_stat[maxSpace] = 1;
-
-            //store the max rect of each line
-            const int left = max_area1.right();
-                const int right = max_area2.left();
-            const int top = (max_area1.top() > max_area2.top()) ? max_area2.top() :
-                                                                  max_area1.top();
-            const int bottom = (max_area1.bottom() < max_area2.bottom()) ? max_area2.bottom() :
-                                                                           max_area1.bottom();
-
-            const QRect rect(left,top,right-left,bottom-top);
-            max_hor_space_rects.append(rect);
         }
-        else max_hor_space_rects.append(QRect(0,0,0,0));
     }
 
     // All the between word space counts are in hor_space_stat
@@ -1529,38 +1610,37 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
     *col_spacing = col_space_stat.key(*col_spacing);
 
     // if there is just one line in a region, there is no point in dividing it
-    if(sortedLines.length() == 1)
+    if(sortedLines.count() == 1)
         *word_spacing = *col_spacing;
 }
 
 /**
  * Implements the XY Cut algorithm for textpage segmentation
- * The resulting RegionTextList will contain RegionText whose WordsWithCharacters::word and
- * WordsWithCharacters::characters are reused from wordsWithCharacters (i.e. no new nor delete happens in this function)
+ * The resulting regions are ranges of @p words, which is partitioned in place
+ * so that the words of each region are contiguous and keep their order.
  */
-static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wordsWithCharacters, const NormalizedRect &boundingBox, int pageWidth, int pageHeight)
+static QVector< LayoutRange > XYCutForBoundingBoxes(const PageLayout &layout, QVector< int > *words, const NormalizedRect &boundingBox)
 {
-    RegionTextList tree;
-    QRect contentRect(boundingBox.geometry(pageWidth,pageHeight));
-    const RegionText root(wordsWithCharacters, contentRect);
+    QVector< LayoutRange > tree;
+    QRect contentRect(boundingBox.geometry(layout.pageWidth,layout.pageHeight));
 
     // start the tree with the root, it is our only region at the start
-    tree.push_back(root);
+    tree.append(LayoutRange(0, words->count(), contentRect));
 
     int i = 0;
 
     // while traversing the tree has not been ended
-    while(i < tree.length())
+    while(i < tree.count())
     {
-        const RegionText node = tree.at(i);
-        QRect regionRect = node.area();
+        const LayoutRange node = tree.at(i);
+        QRect regionRect = node.area;
 
         /**
          * 1. calculation of projection profiles
          */
         // allocate the size of proj profiles and initialize with 0
-        int size_proj_y = node.area().height();
-        int size_proj_x = node.area().width();
+        int size_proj_y = node.area.height();
+        int size_proj_x = node.area.width();
         //dynamic memory allocation
         QVarLengthArray<int> proj_on_xaxis(size_proj_x);
         QVarLengthArray<int> proj_on_yaxis(size_proj_y);
@@ -1568,11 +1648,12 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
         for( int j = 0 ; j < size_proj_y ; ++j ) proj_on_yaxis[j] = 0;
         for( int j = 0 ; j < size_proj_x ; ++j ) proj_on_xaxis[j] = 0;
 
-        const QList<WordWithCharacters> list = node.text();
+        const int *list = words->constData() + node.begin;
+        const int listLength = node.end - node.begin;
 
         // Calculate tcx and tcy locally for each new region
         int word_spacing, line_spacing, column_spacing;
-        calculateStatisticalInformation(list, pageWidth, pageHeight, &word_spacing, &line_spacing, &column_spacing);
+        calculateStatisticalInformation(layout, list, listLength, &word_spacing, &line_spacing, &column_spacing);
 
         const int tcx = word_spacing * 2;
         const int tcy = line_spacing * 2;
@@ -1582,10 +1663,9 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
         int count;
 
         // for every text in the region
-        for(int j = 0 ; j < list.length() ; ++j )
+        for(int j = 0 ; j < listLength ; ++j )
         {
-            TinyTextEntity *ent = list.at(j).word;
-            const QRect entRect = ent->area.geometry(pageWidth, pageHeight);
+            const QRect &entRect = layout.words.at(list[j]).area;
 
             // calculate vertical projection profile proj_on_xaxis1
             for(int k = entRect.left() ; k <= entRect.left() + entRect.width() ; ++k)
@@ -1743,130 +1823,81 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
         else
         {
             // we can now update the node rectangle with the shrinked rectangle
-            RegionText tmpNode = tree.at(i);
-            tmpNode.setArea(regionRect);
-            tree.replace(i,tmpNode);
+            tree[i].area = regionRect;
             i++;
             continue;
         }
 
-        WordsWithCharacters list1,list2;
-
-        // horizontal cut, topRect and bottomRect
-        if(cut_hor)
-        {
-            for( int j = 0 ; j < list.length() ; ++j )
-            {
-                const WordWithCharacters word = list.at(j);
-                const QRect wordRect = word.area().geometry(pageWidth,pageHeight);
-
-                if(topRect.intersects(wordRect))
-                    list1.append(word);
-                else
-                    list2.append(word);
-            }
+        // the words of the first node go first, both keeping their order
+        const QRect firstRect = cut_hor ? topRect : leftRect;
+        const QRect secondRect = cut_hor ? bottomRect : rightRect;
+        const int middle = std::stable_partition(words->begin() + node.begin, words->begin() + node.end,
+                                                 WordIntersects(layout.words, firstRect)) - words->begin();
 
-            RegionText node1(list1,topRect);
-            RegionText node2(list2,bottomRect);
-
-            tree.replace(i,node1);
-            tree.insert(i+1,node2);
-        }
-
-        //vertical cut, leftRect and rightRect
-        else if(cut_ver)
-        {
-            for( int j = 0 ; j < list.length() ; ++j )
-            {
-                const WordWithCharacters word = list.at(j);
-                const QRect wordRect = word.area().geometry(pageWidth,pageHeight);
-
-                if(leftRect.intersects(wordRect))
-                    list1.append(word);
-                else 
-                    list2.append(word);
-            }
-
-            RegionText node1(list1,leftRect);
-            RegionText node2(list2,rightRect);
-
-            tree.replace(i,node1);
-            tree.insert(i+1,node2);
-        }
+        tree[i] = LayoutRange(node.begin, middle, firstRect);
+        tree.insert(i+1, LayoutRange(middle, node.end, secondRect));
     }
 
     return tree;
 }
 
 /**
- * Add spaces in between words in a line. It reuses the pointers passed in tree and might add new ones. You will need to take care of deleting them if needed
+ * Add spaces in between words in a line, and append the characters of the
+ * words of the regions of @p tree, in reading order, to @p text.
  */
-WordsWithCharacters addNecessarySpace(RegionTextList tree, int pageWidth, int pageHeight)
+static void addNecessarySpace(const PageLayout &layout, const FlatTextList &characters, const QVector< LayoutRange > &tree, const QVector< int > &words, FlatTextList *text)
 {
     /**
      * 1. Call makeAndSortLines before adding spaces in between words in a line
      * 2. Now add spaces between every two words in a line
-     * 3. Finally, extract all the space separated texts from each region and return it
+     * 3. Finally, extract all the space separated texts from each region
      */
+    const int pageWidth = layout.pageWidth;
+    const int pageHeight = layout.pageHeight;
+    const QString spaceStr(" ");
+    QVector< int > order;
+    QVector< LayoutRange > sortedLines;
 
-    // Only change the texts under RegionTexts, not the area
-    for(int j = 0 ; j < tree.length() ; j++)
+    for(int j = 0 ; j < tree.count() ; j++)
     {
-        RegionText &tmpRegion = tree[j];
+        const LayoutRange &region = tree.at(j);
 
         // Step 01
-        QList< QPair<WordsWithCharacters, QRect> > sortedLines = makeAndSortLines(tmpRegion.text(), pageWidth, pageHeight);
+        makeAndSortLines(layout, words.constData() + region.begin, region.end - region.begin, &order, &sortedLines);
 
-        // Step 02
-        for(int i = 0 ; i < sortedLines.length() ; i++)
+        for(int i = 0 ; i < sortedLines.count() ; i++)
         {
-            WordsWithCharacters &list = sortedLines[i].first;
-            for(int k = 0 ; k < list.length() ; k++ )
+            const LayoutRange &line = sortedLines.at(i);
+            for(int k = line.begin ; k < line.end ; k++ )
             {
-                const QRect area1 = list.at(k).area().roundedGeometry(pageWidth,pageHeight);
-                if( k+1 >= list.length() ) break;
+                // Step 03
+                const LayoutWord &word = layout.words.at(order.at(k));
+                for(int c = word.firstCharacter ; c <= word.lastCharacter ; c++)
+                {
+                    const LayoutCharacter &character = layout.characters.at(c);
+                    text->append(characters.text(character.entity), NormalizedRect(character.roundedArea, pageWidth, pageHeight));
+                }
+
+                // Step 02
+                if( k+1 >= line.end ) break;
 
-                const QRect area2 = list.at(k+1).area().roundedGeometry(pageWidth,pageHeight);
+                const QRect &area1 = word.roundedArea;
+                const QRect &area2 = layout.words.at(order.at(k+1)).roundedArea;
                 const int space = area2.left() - area1.right();
 
                 if(space != 0)
                 {
-                    // Make a TinyTextEntity of string space and push it between it and it+1
                     const int left = area1.right();
                     const int right = area2.left();
                     const int top = area2.top() < area1.top() ? area2.top() : area1.top();
                     const int bottom = area2.bottom() > area1.bottom() ? area2.bottom() : area1.bottom();
 
-                    const QString spaceStr(" ");
                     const QRect rect(QPoint(left,top),QPoint(right,bottom));
-                    const NormalizedRect entRect(rect,pageWidth,pageHeight);
-                    TinyTextEntity *ent1 = new TinyTextEntity(spaceStr, entRect);
-                    TinyTextEntity *ent2 = new TinyTextEntity(spaceStr, entRect);
-                    WordWithCharacters word(ent1, QList<TinyTextEntity*>() << ent2);
-
-                    list.insert(k+1, word);
-
-                    // Skip the space
-                    k++;
+                    text->append(spaceStr, NormalizedRect(rect,pageWidth,pageHeight));
                 }
             }
         }
-
-        WordsWithCharacters tmpList;
-        for(int i = 0 ; i < sortedLines.length() ; i++)
-        {
-            tmpList += sortedLines.at(i).first;
-        }
-        tmpRegion.setText(tmpList);
-    }
-
-    // Step 03
-    WordsWithCharacters tmp;
-    for(int i = 0 ; i < tree.length() ; i++)
-    {
-        tmp += tree.at(i).text();
     }
-    return tmp;
 }
 
 /**
@@ -1874,41 +1905,36 @@ WordsWithCharacters addNecessarySpace(RegionTextList tree, int pageWidth, int pa
  */
 void TextPagePrivate::correctTextOrder()
 {
-    const int pageWidth = m_page->m_page->width();
-    const int pageHeight = m_page->m_page->height();
-
-    TextList characters = m_words;
+    PageLayout layout;
+    layout.pageWidth = m_page->m_page->width();
+    layout.pageHeight = m_page->m_page->height();
 
     /**
      * Remove spaces from the text
      */
-    removeSpace(&characters);
+    charactersWithoutSpace(m_words, &layout);
 
     /**
      * Construct words from characters
      */
-    const QList<WordWithCharacters> wordsWithCharacters = makeWordFromCharacters(characters, pageWidth, pageHeight);
+    makeWordFromCharacters(&layout);
 
     /**
      * Make a XY Cut tree for segmentation of the texts
      */
-    const RegionTextList tree = XYCutForBoundingBoxes(wordsWithCharacters, m_page->m_page->boundingBox(), pageWidth, pageHeight);
-
-    /**
-     * Add spaces to the word
-     */
-    const WordsWithCharacters listWithWordsAndSpaces = addNecessarySpace(tree, pageWidth, pageHeight);
+    QVector< int > words(layout.words.count());
+    for (int i = 0; i < words.count(); ++i)
+        words[i] = i;
+    const QVector< LayoutRange > tree = XYCutForBoundingBoxes(layout, &words, m_page->m_page->boundingBox());
 
     /**
-     * Break the words into characters
+     * Add spaces to the word, and break the words into characters
      */
-    TextList listOfCharacters;
-    foreach(const WordWithCharacters &word, listWithWordsAndSpaces)
-    {
-        delete word.word;
-        listOfCharacters.append(word.characters);
-    }
-    setWordList(listOfCharacters);
+    FlatTextList text;
+    addNecessarySpace(layout, m_words, tree, words, &text);
+    text.squeeze();
+    m_words = text;
+    invalidateSearchText();
 }
 
 TextEntity::List TextPage::words(const RegularAreaRect *area, TextAreaInclusionBehaviour b) const
@@ -1917,32 +1943,34 @@ TextEntity::List TextPage::words(const RegularAreaRect *area, TextAreaInclusionB
         return TextEntity::List();
 
     TextEntity::List ret;
+    const int count = d->m_words.count();
     if ( area )
     {
-        foreach (TinyTextEntity *te, d->m_words)
+        for ( int i = 0; i < count; ++i )
         {
+            const NormalizedRect teArea = d->m_words.area( i );
             if (b == AnyPixelTextAreaInclusionBehaviour)
             {
-                if ( area->intersects( te->area ) )
+                if ( area->intersects( teArea ) )
                 {
-                    ret.append( new TextEntity( te->text(), new Okular::NormalizedRect( te->area) ) );
+                    ret.append( new TextEntity( d->m_words.text( i ).toString(), new Okular::NormalizedRect( teArea ) ) );
                 }
             }
             else
             {
-                const NormalizedPoint center = te->area.center();
+                const NormalizedPoint center = teArea.center();
                 if ( area->contains( center.x, center.y ) )
                 {
-                    ret.append( new TextEntity( te->text(), new Okular::NormalizedRect( te->area) ) );
+                    ret.append( new TextEntity( d->m_words.text( i ).toString(), new Okular::NormalizedRect( teArea ) ) );
                 }
             }
         }
     }
     else
     {
-        foreach (TinyTextEntity *te, d->m_words)
+        for ( int i = 0; i < count; ++i )
         {
-            ret.append( new TextEntity( te->text(), new Okular::NormalizedRect( te->area) ) );
+            ret.append( new TextEntity( d->m_words.text( i ).toString(), new Okular::NormalizedRect( d->m_words.area( i ) ) ) );
         }
     }
     return ret;
@@ -1950,12 +1978,12 @@ TextEntity::List TextPage::words(const RegularAreaRect *area, TextAreaInclusionB
 
 RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) const
 {
-    TextList::ConstIterator itBegin = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
-    TextList::ConstIterator it = itBegin;
-    TextList::ConstIterator posIt = itEnd;
+    const int itBegin = 0, itEnd = d->m_words.count();
+    int it = itBegin;
+    int posIt = itEnd;
     for ( ; it != itEnd; ++it )
     {
-        if ( (*it)->area.contains( p.x, p.y ) )
+        if ( d->m_words.area( it ).contains( p.x, p.y ) )
         {
             posIt = it;
             break;
@@ -1964,15 +1992,15 @@ RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) co
     QString text;
     if ( posIt != itEnd )
     {
-        if ( (*posIt)->text().simplified().isEmpty() )
+        if ( d->m_words.text( posIt ).toString().simplified().isEmpty() )
         {
             return NULL;
         }
-        // Find the first TinyTextEntity of the word
+        // Find the first text entity of the word
         while ( posIt != itBegin )
         {
             --posIt;
-            const QString itText = (*posIt)->text();
+            const QString itText = d->m_words.text( posIt ).toString();
             if ( itText.right(1).at(0).isSpace() )
             {
                 if (itText.endsWith("-\n"))
@@ -1985,7 +2013,7 @@ RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) co
                 if (itText == "\n" && posIt != itBegin )
                 {
                     --posIt;
-                    if ((*posIt)->text().endsWith("-")) {
+                    if (d->m_words.text( posIt ).endsWith(QLatin1Char('-'))) {
                         // Is an hyphenated word
                         // continue searching the start of the word back
                         continue;
@@ -2000,14 +2028,14 @@ RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) co
         RegularAreaRect *ret = new RegularAreaRect();
         for ( ; posIt != itEnd; ++posIt )
         {
-            const QString itText = (*posIt)->text();
+            const QString itText = d->m_words.text( posIt ).toString();
             if ( itText.simplified().isEmpty() )
             {
                 break;
             }
             
-            ret->appendShape( (*posIt)->area );
-            text += (*posIt)->text();
+            ret->appendShape( d->m_words.area( posIt ) );
+            text += itText;
             if (itText.right(1).at(0).isSpace())
             {
                 if (!text.endsWith("-\n"))
@@ -16,6 +16,7 @@
 #include "okular_export.h"
 #include "global.h"
 
+class QRegExp;
 class QTransform;
 
 namespace Okular {
@@ -105,6 +106,17 @@ class OKULAR_EXPORT TextPage
             CentralPixelTextAreaInclusionBehaviour  ///< A character is included into text() result if the central pixel of his bounding box is in the given area
         };
 
+        /**
+         * Defines how findText() compares the searched text with the text of the page
+         * @since 0.17 (KDE 4.11)
+         */
+        enum TextComparison
+        {
+            ExactComparison,        ///< The texts are the same, but for the case if the search is case insensitive
+            LooseComparison,        ///< The case, the accents and the ligatures are ignored
+            ApproximateComparison   ///< As LooseComparison, and a character can also be different, missing or extra
+        };
+
         /**
          * Creates a new text page.
          */
@@ -141,6 +153,48 @@ class OKULAR_EXPORT TextPage
         RegularAreaRect* findText( int id, const QString &text, SearchDirection direction,
                                    Qt::CaseSensitivity caseSensitivity, const RegularAreaRect *lastRect );
 
+        /**
+         * Returns the bounding rect of the text which matches the following criteria
+         * or 0 if the search is not successful.
+         *
+         * The loose and approximate comparisons search a copy of the text of
+         * the page without case, accents and ligatures, made at the first of
+         * these searches; they ignore @p caseSensitivity. The approximate
+         * comparison is loose for the texts shorter than 4 characters.
+         *
+         * @param id An unique id for this search.
+         * @param text The search text.
+         * @param direction The direction of the search (@ref SearchDirection)
+         * @param caseSensitivity If Qt::CaseSensitive, the search is case sensitive; otherwise
+         *                        the search is case insensitive.
+         * @param comparison How the texts are compared (@ref TextComparison)
+         * @param lastRect If 0 the search starts at the beginning of the page, otherwise
+         *                 right/below the coordinates of the given rect.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        RegularAreaRect* findText( int id, const QString &text, SearchDirection direction,
+                                   Qt::CaseSensitivity caseSensitivity, TextComparison comparison,
+                                   const RegularAreaRect *lastRect );
+
+        /**
+         * Returns the bounding rect of the text matching the regular
+         * expression @p regExp or 0 if the search is not successful.
+         *
+         * The expression is matched against the text of the page without the
+         * hyphens at the end of the lines; its case sensitivity is used.
+         *
+         * @param id An unique id for this search.
+         * @param regExp The regular expression to search.
+         * @param direction The direction of the search (@ref SearchDirection)
+         * @param lastRect If 0 the search starts at the beginning of the page, otherwise
+         *                 right/below the coordinates of the given rect.
+         *
+         * @since 0.17 (KDE 4.11)
+         */
+        RegularAreaRect* findText( int id, const QRegExp &regExp, SearchDirection direction,
+                                   const RegularAreaRect *lastRect );
+
         /**
          * Text extraction function.
          *
@@ -14,25 +14,80 @@
 #include <QtCore/QList>
 #include <QtCore/QMap>
 #include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtCore/QVector>
 #include <QtGui/QTransform>
 
+#include "area.h"
+#include "textpage.h"
+
 class SearchPoint;
-class TinyTextEntity;
-class RegionText;
 
 namespace Okular
 {
 
 class PagePrivate;
-typedef QList< TinyTextEntity* > TextList;
-
-typedef bool ( *TextComparisonFunction )( const QStringRef & from, const QStringRef & to,
-                                          int *fromLength, int *toLength );
 
 /**
- * A list of RegionText. It keeps a bunch of TextList with their bounding rectangles
+ * The text entities of a page, stored flat: the text of all of them in one
+ * buffer, and their offsets in it and their areas in arrays. Walking the
+ * entities, as searching does, reads contiguous memory, and appending them
+ * does not allocate anything for each of them.
  */
-typedef QList<RegionText> RegionTextList;
+class FlatTextList
+{
+    public:
+        void append( const QString &text, const NormalizedRect &area );
+        void append( const QStringRef &text, const NormalizedRect &area );
+        void clear();
+
+        /**
+         * Releases the memory reserved for more entities.
+         */
+        void squeeze();
+
+        /**
+         * Returns the memory used by the entities, in bytes.
+         */
+        qulonglong memoryUsage() const;
+
+        int count() const { return m_areas.count(); }
+        bool isEmpty() const { return m_areas.isEmpty(); }
+
+        /**
+         * Returns the text of the entity @p i, valid as long as the list is
+         * not changed.
+         */
+        QStringRef text( int i ) const
+        {
+            const int end = i + 1 < m_offsets.count() ? m_offsets.at( i + 1 ) : m_text.length();
+            return QStringRef( &m_text, m_offsets.at( i ), end - m_offsets.at( i ) );
+        }
+
+        /**
+         * Returns the text of all the entities.
+         */
+        QString allText() const { return m_text; }
+
+        NormalizedRect area( int i ) const
+        {
+            const Rect &r = m_areas.at( i );
+            return NormalizedRect( r.left, r.top, r.right, r.bottom );
+        }
+
+        NormalizedRect transformedArea( int i, const QTransform &matrix ) const;
+
+    private:
+        // single precision is plenty for normalized coordinates
+        struct Rect
+        {
+            float left, top, right, bottom;
+        };
+
+        QString m_text;
+        QVector< int > m_offsets;
+        QVector< Rect > m_areas;
+};
 
 class TextPagePrivate
 {
@@ -40,32 +95,81 @@ class TextPagePrivate
         TextPagePrivate();
         ~TextPagePrivate();
 
-        RegularAreaRect * findTextInternalForward( int searchID, const QString &query,
-                                                   Qt::CaseSensitivity caseSensitivity,
-                                                   TextComparisonFunction comparer,
-                                                   const TextList::ConstIterator &start,
-                                                   const TextList::ConstIterator &end );
-        RegularAreaRect * findTextInternalBackward( int searchID, const QString &query,
-                                                    Qt::CaseSensitivity caseSensitivity,
-                                                    TextComparisonFunction comparer,
-                                                    const TextList::ConstIterator &start,
-                                                    const TextList::ConstIterator &end );
+        /**
+         * Returns the text searched by findText: the text of the entities
+         * without the hyphens at the end of the lines, case folded if the
+         * search is not case sensitive. It is built at the first search.
+         */
+        const QString &searchText( Qt::CaseSensitivity caseSensitivity );
+
+        /**
+         * Returns @p query prepared to be searched in searchText(), its
+         * failure function being in m_patternFailure.
+         */
+        const QString &searchPattern( const QString &query, Qt::CaseSensitivity caseSensitivity, TextPage::TextComparison comparison );
+
+        /**
+         * Returns searchText() without case, accents and ligatures, for the
+         * loose comparisons; m_looseOffsets has the position in searchText()
+         * of each of its characters. It is built at the first loose search.
+         */
+        const QString &looseSearchText();
+
+        /**
+         * Implements findText() for the loose and approximate comparisons,
+         * @p sp being the last match if @p direction is relative to it.
+         */
+        RegularAreaRect * findLooseText( int searchID, const QString &query, SearchDirection direction, bool approximate, const SearchPoint *sp );
+
+        /**
+         * To be called when m_words changes.
+         */
+        void invalidateSearchText();
+
+        /**
+         * Returns the memory used by the page, in bytes, counting the search
+         * text even if it is not built yet.
+         */
+        qulonglong memoryUsage() const;
 
         /**
-         * Copy a TextList to m_words, the pointers of list are adopted
+         * Returns the entity that contains the @p position of searchText().
          */
-        void setWordList(const TextList &list);
+        int entityAt( int position ) const;
 
         /**
-         * Make necessary modifications in the TextList to make the text order correct, so
+         * Stores the match between @p begin and @p end of searchText() as
+         * the last result of the search @p searchID and returns its area,
+         * or forgets the search if @p begin is -1.
+         */
+        RegularAreaRect * searchResult( int searchID, int begin, int end );
+
+        /**
+         * Make necessary modifications in m_words to make the text order correct, so
          * that textselection works fine
          */
         void correctTextOrder();
 
         // variables those can be accessed directly from TextPage
-        TextList m_words;
+        FlatTextList m_words;
         QMap< int, SearchPoint* > m_searchPoints;
         PagePrivate *m_page;
+
+        // see searchText()
+        QString m_searchText;
+        QString m_foldedSearchText;
+        QVector< int > m_searchOffsets;
+
+        // see looseSearchText()
+        QString m_looseSearchText;
+        QVector< int > m_looseOffsets;
+
+        // the last searched text, see searchPattern()
+        QString m_patternQuery;
+        Qt::CaseSensitivity m_patternCaseSensitivity;
+        TextPage::TextComparison m_patternComparison;
+        QString m_pattern;
+        QVector< int > m_patternFailure;
 };
 
 }
@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "textpagecache_p.h"
+
+using namespace Okular;
+
+TextPageCache::TextPageCache()
+    : m_clock( 0 ), m_maxMemory( 0 ), m_totalMemory( 0 ), m_hits( 0 ), m_misses( 0 )
+{
+}
+
+void TextPageCache::setMaxMemory( qulonglong maxMemory )
+{
+    m_maxMemory = maxMemory;
+}
+
+qulonglong TextPageCache::maxMemory() const
+{
+    return m_maxMemory;
+}
+
+void TextPageCache::insert( int page, qulonglong memory )
+{
+    remove( page );
+
+    Entry entry;
+    entry.memory = memory;
+    entry.lastUse = ++m_clock;
+    m_entries.insert( page, entry );
+    m_lru.insert( entry.lastUse, page );
+    m_totalMemory += memory;
+}
+
+bool TextPageCache::use( int page )
+{
+    QHash< int, Entry >::iterator it = m_entries.find( page );
+    if ( it == m_entries.end() )
+    {
+        ++m_misses;
+        return false;
+    }
+
+    ++m_hits;
+    m_lru.remove( it->lastUse );
+    it->lastUse = ++m_clock;
+    m_lru.insert( it->lastUse, page );
+    return true;
+}
+
+void TextPageCache::setMemory( int page, qulonglong memory )
+{
+    QHash< int, Entry >::iterator it = m_entries.find( page );
+    if ( it == m_entries.end() )
+        return;
+
+    m_totalMemory = m_totalMemory - it->memory + memory;
+    it->memory = memory;
+}
+
+void TextPageCache::remove( int page )
+{
+    QHash< int, Entry >::iterator it = m_entries.find( page );
+    if ( it == m_entries.end() )
+        return;
+
+    m_lru.remove( it->lastUse );
+    m_totalMemory -= it->memory;
+    m_entries.erase( it );
+}
+
+QList< int > TextPageCache::evict( int keptPage )
+{
+    QList< int > evicted;
+    QMap< qint64, int >::iterator it = m_lru.begin();
+    while ( m_totalMemory > m_maxMemory && it != m_lru.end() )
+    {
+        const int page = it.value();
+        if ( page == keptPage )
+        {
+            ++it;
+            continue;
+        }
+
+        it = m_lru.erase( it );
+        m_totalMemory -= m_entries.take( page ).memory;
+        evicted.append( page );
+    }
+    return evicted;
+}
+
+void TextPageCache::clear()
+{
+    m_entries.clear();
+    m_lru.clear();
+    m_totalMemory = 0;
+}
+
+void TextPageCache::clearStatistics()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
+bool TextPageCache::contains( int page ) const
+{
+    return m_entries.contains( page );
+}
+
+int TextPageCache::count() const
+{
+    return m_entries.count();
+}
+
+qulonglong TextPageCache::totalMemory() const
+{
+    return m_totalMemory;
+}
+
+qint64 TextPageCache::hits() const
+{
+    return m_hits;
+}
+
+qint64 TextPageCache::misses() const
+{
+    return m_misses;
+}
+
+QString TextPageCache::report() const
+{
+    const qint64 uses = m_hits + m_misses;
+    return QString( "Text pages: %1 pages, %2 of %3 KiB, %4 hits, %5 misses (%6% hit rate)" )
+           .arg( count() ).arg( m_totalMemory / 1024 ).arg( m_maxMemory / 1024 )
+           .arg( m_hits ).arg( m_misses ).arg( uses ? 100 * m_hits / uses : 0 );
+}
+
+/* kate: replace-tabs on; indent-width 4; */
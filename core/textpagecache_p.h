@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_TEXTPAGECACHE_P_H_
+#define _OKULAR_TEXTPAGECACHE_P_H_
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QString>
+
+namespace Okular {
+
+/**
+ * Index of the pages having their text in memory, used to pick the texts to
+ * delete when they take more memory than allowed.
+ *
+ * The memory of each text page is accounted in bytes, and the least
+ * recently used texts are evicted first, so that a search going through
+ * the document again finds the texts it used last.
+ *
+ * The index also counts the hits and the misses, i.e. how many times the
+ * text of a page was needed and was in memory or had to be extracted.
+ *
+ * The index does not own the text pages: the caller deletes the texts of
+ * the pages returned by evict().
+ */
+class TextPageCache
+{
+    public:
+        TextPageCache();
+
+        void setMaxMemory( qulonglong maxMemory );
+        qulonglong maxMemory() const;
+
+        /**
+         * Adds the text of @p page, taking @p memory bytes, as the most
+         * recently used one, replacing a previous entry for the same page.
+         */
+        void insert( int page, qulonglong memory );
+
+        /**
+         * Marks the text of @p page as just used. Returns whether it is in
+         * the cache, counting a hit if it is and a miss otherwise.
+         */
+        bool use( int page );
+
+        /**
+         * Accounts @p memory bytes for the text of @p page from now on, as
+         * the text grows with the structures the searches build. Does
+         * nothing if @p page is not in the cache.
+         */
+        void setMemory( int page, qulonglong memory );
+
+        void remove( int page );
+
+        /**
+         * Removes the least recently used pages, but @p keptPage, until the
+         * memory is below the maximum, and returns them.
+         */
+        QList< int > evict( int keptPage = -1 );
+
+        /**
+         * Removes all the pages; the counters are kept.
+         */
+        void clear();
+
+        /**
+         * Resets the hit and miss counters.
+         */
+        void clearStatistics();
+
+        bool contains( int page ) const;
+        int count() const;
+        qulonglong totalMemory() const;
+
+        qint64 hits() const;
+        qint64 misses() const;
+
+        /**
+         * Returns a human readable summary of the memory and the counters.
+         */
+        QString report() const;
+
+    private:
+        struct Entry
+        {
+            qulonglong memory;
+            qint64 lastUse;
+        };
+
+        QHash< int, Entry > m_entries;
+        // the pages by time of last use, the least recently used first
+        QMap< qint64, int > m_lru;
+        qint64 m_clock;
+        qulonglong m_maxMemory;
+        qulonglong m_totalMemory;
+        qint64 m_hits;
+        qint64 m_misses;
+};
+
+}
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "textsearchjob_p.h"
+
+#include <kdebug.h>
+
+#include "debug_p.h"
+#include "generator.h"
+#include "page.h"
+#include "page_p.h"
+#include "textpage.h"
+
+using namespace Okular;
+
+TextSearchJob::TextSearchJob( Generator *generator, const QVector< Page * > &pages, int searchID, const QString &text, Qt::CaseSensitivity caseSensitivity, TextPage::TextComparison comparison, const QRegExp &regExp )
+    : mGenerator( generator ), mPages( pages ), mSearchID( searchID ), mText( text ), mCaseSensitivity( caseSensitivity ), mComparison( comparison ), mRegExp( regExp ), mCancelled( 0 )
+{
+    mExtract.resize( mPages.count() );
+    for ( int i = 0; i < mPages.count(); ++i )
+        mExtract[ i ] = !mPages.at( i )->hasTextPage();
+}
+
+TextSearchJob::~TextSearchJob()
+{
+    foreach ( const Result &result, mResults )
+    {
+        delete result.textPage;
+        qDeleteAll( result.matches );
+    }
+}
+
+QVector< Page * > TextSearchJob::pages() const
+{
+    return mPages;
+}
+
+bool TextSearchJob::isExtracting( int index ) const
+{
+    return mExtract.at( index );
+}
+
+QList< TextSearchJob::Result > TextSearchJob::takeResults()
+{
+    const QList< Result > results = mResults;
+    mResults.clear();
+    return results;
+}
+
+void TextSearchJob::cancel()
+{
+    mCancelled = 1;
+}
+
+void TextSearchJob::run()
+{
+    for ( int i = 0; i < mPages.count() && !mCancelled; ++i )
+    {
+        if ( !mExtract.at( i ) )
+            continue;
+
+        Page *page = mPages.at( i );
+        TextPage *textPage = mGenerator->textPage( page );
+        if ( !textPage )
+            continue;
+
+        // do here the text ordering, so that the GUI thread has nothing left
+        // to do when it gets the text page
+        page->d->prepareTextPage( textPage );
+
+        Result result;
+        result.page = page;
+        result.textPage = textPage;
+        RegularAreaRect *lastMatch = 0;
+        while ( ( lastMatch = mRegExp.isEmpty()
+                              ? textPage->findText( mSearchID, mText, lastMatch ? NextResult : FromTop, mCaseSensitivity, mComparison, lastMatch )
+                              : textPage->findText( mSearchID, mRegExp, lastMatch ? NextResult : FromTop, lastMatch ) ) )
+            result.matches.append( lastMatch );
+        mResults.append( result );
+    }
+}
+
+
+TextIndexJob::TextIndexJob( Generator *generator, const QVector< Page * > &pages, const QString &fileName, const QString &key )
+    : mGenerator( generator ), mPages( pages ), mFileName( fileName ), mKey( key ), mComplete( false ), mCancelled( 0 )
+{
+}
+
+bool TextIndexJob::isComplete() const
+{
+    return mComplete;
+}
+
+const TextIndex &TextIndexJob::index() const
+{
+    return mIndex;
+}
+
+void TextIndexJob::cancel()
+{
+    mCancelled = 1;
+}
+
+int TextIndexJob::priority() const
+{
+    return -1;
+}
+
+void TextIndexJob::run()
+{
+    for ( int i = 0; i < mPages.count(); ++i )
+    {
+        if ( mCancelled )
+            return;
+
+        Page *page = mPages.at( i );
+        TextPage *textPage = mGenerator->textPage( page );
+        if ( !textPage )
+        {
+            mIndex.addPage( page->number(), QString() );
+            continue;
+        }
+
+        // the order of the words decides which ones are joined across lines
+        page->d->prepareTextPage( textPage );
+        mIndex.addPage( page->number(), textPage->text() );
+        delete textPage;
+    }
+
+    mComplete = true;
+    if ( !mIndex.save( mFileName, mKey ) )
+        kWarning(OkularDebug) << "Cannot save the text index to" << mFileName;
+}
+
+#include "textsearchjob_p.moc"
+
+/* kate: replace-tabs on; indent-width 4; */
@@ -0,0 +1,136 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_TEXTSEARCHJOB_P_H_
+#define _OKULAR_TEXTSEARCHJOB_P_H_
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
+#include <QtCore/QRegExp>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include <threadweaver/Job.h>
+
+#include "core/area.h"
+#include "core/textindex_p.h"
+#include "core/textpage.h"
+
+namespace Okular {
+
+class Generator;
+class Page;
+
+/**
+ * Job searching a text in a chunk of pages of a document, extracting the
+ * text of the pages that do not have it yet.
+ *
+ * The pages that already have their text are not touched by the job, as
+ * their TextPage can be used (or deleted) by the GUI thread at any time:
+ * they are to be searched by the GUI thread when the job is done.
+ */
+class TextSearchJob : public ThreadWeaver::Job
+{
+    Q_OBJECT
+
+    public:
+        struct Result
+        {
+            Page *page;
+            // the text extracted by the job, prepared for the page
+            TextPage *textPage;
+            QVector< RegularAreaRect * > matches;
+        };
+
+        /**
+         * Searches @p regExp if it is not empty, @p text otherwise, compared as told by @p comparison.
+         */
+        TextSearchJob( Generator *generator, const QVector< Page * > &pages, int searchID, const QString &text, Qt::CaseSensitivity caseSensitivity, TextPage::TextComparison comparison, const QRegExp &regExp );
+        ~TextSearchJob();
+
+        /**
+         * The pages of the chunk; those with text already at the time the
+         * job was created are not searched by the job.
+         */
+        QVector< Page * > pages() const;
+        bool isExtracting( int index ) const;
+
+        /**
+         * Returns the results of the job, whose ownership passes to the caller.
+         */
+        QList< Result > takeResults();
+
+        /**
+         * Asks the job to stop as soon as possible. Thread safe.
+         */
+        void cancel();
+
+    protected:
+        virtual void run();
+
+    private:
+        Generator *mGenerator;
+        QVector< Page * > mPages;
+        QVector< bool > mExtract;
+        int mSearchID;
+        QString mText;
+        Qt::CaseSensitivity mCaseSensitivity;
+        TextPage::TextComparison mComparison;
+        // the job has its own copy, QRegExp is reentrant but not thread safe
+        QRegExp mRegExp;
+        QList< Result > mResults;
+        QAtomicInt mCancelled;
+};
+
+/**
+ * Job extracting the text of all the pages of a document to build its
+ * TextIndex, which is saved to a file once complete.
+ *
+ * Like TextSearchJob, it never uses the text the pages already have.
+ */
+class TextIndexJob : public ThreadWeaver::Job
+{
+    Q_OBJECT
+
+    public:
+        TextIndexJob( Generator *generator, const QVector< Page * > &pages, const QString &fileName, const QString &key );
+
+        /**
+         * Whether all the pages were indexed, i.e. the job was not cancelled.
+         */
+        bool isComplete() const;
+
+        const TextIndex &index() const;
+
+        /**
+         * Asks the job to stop as soon as possible. Thread safe.
+         */
+        void cancel();
+
+        // below the searches, that are waited for by the user
+        virtual int priority() const;
+
+    protected:
+        virtual void run();
+
+    private:
+        Generator *mGenerator;
+        QVector< Page * > mPages;
+        QString mFileName;
+        QString mKey;
+        TextIndex mIndex;
+        bool mComplete;
+        QAtomicInt mCancelled;
+};
+
+}
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
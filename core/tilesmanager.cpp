@@ -13,12 +13,33 @@
 #include <QList>
 #include <QPainter>
 
+#include <string.h>
+
 #include "tile.h"
 
-#define TILES_MAXSIZE 2000000
+// bounds of the maximum number of pixels of a tile, which is a quarter of
+// the number of pixels of the visible part of the page
+#define TILES_MINSIZE 500000
+#define TILES_MAXSIZE 4000000
+#define TILES_DEFAULTSIZE 2000000
+// pending requests kept at most, older ones are assumed lost
+#define TILES_MAXREQUESTS 8
 
 using namespace Okular;
 
+namespace Okular {
+
+struct CompressedPixmap
+{
+    QByteArray data;
+    int width;
+    int height;
+    int bytesPerLine;
+    QImage::Format format;
+};
+
+}
+
 static bool rankedTilesLessThan( TileNode *t1, TileNode *t2 )
 {
     // Order tiles by its dirty state and then by distance from the viewport.
@@ -37,6 +58,26 @@ class TilesManager::Private
         void tilesAt( const NormalizedRect &rect, TileNode &tile, QList<Tile> &result, TileLeaf tileLeaf );
         void setPixmap( const QPixmap *pixmap, const NormalizedRect &rect, TileNode &tile );
 
+        /**
+         * Deletes the pixmap (compressed or not) of @p tile
+         */
+        void deletePixmap( TileNode &tile );
+
+        /**
+         * Replaces the pixmap of @p tile with a compressed copy of it.
+         * Returns false, leaving the tile untouched, if the pixmap does not
+         * compress well enough to be worth it.
+         */
+        bool compress( TileNode &tile );
+
+        /**
+         * Gives back to @p tile the pixmap it had before being compressed
+         */
+        void decompress( TileNode &tile );
+        bool decompressTiles( const NormalizedRect &rect, TileNode &tile );
+
+        qulonglong tileMemory( const TileNode &tile ) const;
+
         /**
          * Mark @p tile and all its children as dirty
          */
@@ -65,17 +106,30 @@ class TilesManager::Private
          */
         bool splitBigTiles( TileNode &tile, const NormalizedRect &rect );
 
+        struct Request
+        {
+            NormalizedRect rect;
+            int width;
+            int height;
+        };
+
+        int findRequest( const NormalizedRect &rect, int pageWidth, int pageHeight ) const;
+
         // The page is split in a 4x4 grid of tiles
         TileNode tiles[16];
         int width;
         int height;
         int pageNumber;
         qulonglong totalPixels;
+        qulonglong compressedBytes;
+        qulonglong maxTileSize;
         Rotation rotation;
         NormalizedRect visibleRect;
-        NormalizedRect requestRect;
-        int requestWidth;
-        int requestHeight;
+        QList<Request> requests;
+        // once something has been requested only the expected pixmaps are
+        // accepted
+        bool requested;
+        bool partialRendering;
 };
 
 TilesManager::Private::Private()
@@ -83,10 +137,11 @@ TilesManager::Private::Private()
     , height( 0 )
     , pageNumber( 0 )
     , totalPixels( 0 )
+    , compressedBytes( 0 )
+    , maxTileSize( TILES_DEFAULTSIZE )
     , rotation( Rotation0 )
-    , requestRect( NormalizedRect() )
-    , requestWidth( 0 )
-    , requestHeight( 0 )
+    , requested( false )
+    , partialRendering( false )
 {
 }
 
@@ -124,6 +179,12 @@ void TilesManager::Private::deleteTiles( const TileNode &tile )
         delete tile.pixmap;
     }
 
+    if ( tile.compressed )
+    {
+        compressedBytes -= tile.compressed->data.size();
+        delete tile.compressed;
+    }
+
     if ( tile.nTiles > 0 )
     {
         for ( int i = 0; i < tile.nTiles; ++i )
@@ -141,6 +202,9 @@ void TilesManager::setSize( int width, int height )
     d->width = width;
     d->height = height;
 
+    // pixmaps for the previous size will be discarded anyway
+    d->requests.clear();
+
     markDirty();
 }
 
@@ -175,6 +239,16 @@ void TilesManager::markDirty()
     }
 }
 
+void TilesManager::setPartialRendering( bool partial )
+{
+    d->partialRendering = partial;
+}
+
+bool TilesManager::isPartialRendering() const
+{
+    return d->partialRendering;
+}
+
 void TilesManager::Private::markDirty( TileNode &tile )
 {
     tile.dirty = true;
@@ -188,14 +262,15 @@ void TilesManager::Private::markDirty( TileNode &tile )
 void TilesManager::setPixmap( const QPixmap *pixmap, const NormalizedRect &rect )
 {
     NormalizedRect rotatedRect = TilesManager::fromRotatedRect( rect, d->rotation );
-    if ( !d->requestRect.isNull() )
+    if ( d->requested )
     {
-        if ( !(d->requestRect == rect) )
+        const int request = d->findRequest( rect, width(), height() );
+        if ( request == -1 )
             return;
 
         // Check whether the pixmap has the same absolute size of the expected
         // request.
-        // If the document is rotated, rotate requestRect back to the original
+        // If the document is rotated, rotate the requested rect back to the original
         // rotation before comparing to pixmap's size. This is to avoid
         // conversion issues. The pixmap request was made using an unrotated
         // rect.
@@ -211,7 +286,7 @@ void TilesManager::setPixmap( const QPixmap *pixmap, const NormalizedRect &rect
         if ( rotatedRect.geometry( w, h ).size() != pixmapSize )
             return;
 
-        d->requestRect = NormalizedRect();
+        d->requests.removeAt( request );
     }
 
     for ( int i = 0; i < 16; ++i )
@@ -238,8 +313,7 @@ void TilesManager::Private::setPixmap( const QPixmap *pixmap, const NormalizedRe
             for ( int i = 0; i < tile.nTiles; ++i )
                 setPixmap( pixmap, rect, tile.tiles[ i ] );
 
-            delete tile.pixmap;
-            tile.pixmap = 0;
+            deletePixmap( tile );
         }
 
         return;
@@ -253,11 +327,7 @@ void TilesManager::Private::setPixmap( const QPixmap *pixmap, const NormalizedRe
         // check whether the tile size is big and split it if necessary
         if ( !splitBigTiles( tile, rect ) )
         {
-            if ( tile.pixmap )
-            {
-                totalPixels -= tile.pixmap->width()*tile.pixmap->height();
-                delete tile.pixmap;
-            }
+            deletePixmap( tile );
             NormalizedRect rotatedRect = TilesManager::toRotatedRect( tile.rect, rotation );
             tile.pixmap = new QPixmap( pixmap->copy( rotatedRect.geometry( width, height ).translated( -pixmapRect.topLeft() ) ) );
             tile.rotation = rotation;
@@ -265,12 +335,7 @@ void TilesManager::Private::setPixmap( const QPixmap *pixmap, const NormalizedRe
         }
         else
         {
-            if ( tile.pixmap )
-            {
-                totalPixels -= tile.pixmap->width()*tile.pixmap->height();
-                delete tile.pixmap;
-                tile.pixmap = 0;
-            }
+            deletePixmap( tile );
 
             for ( int i = 0; i < tile.nTiles; ++i )
                 setPixmap( pixmap, rect, tile.tiles[ i ] );
@@ -281,15 +346,10 @@ void TilesManager::Private::setPixmap( const QPixmap *pixmap, const NormalizedRe
         QRect tileRect = tile.rect.geometry( width, height );
         // sets the pixmap of the children tiles. if the tile's size is too
         // small, discards the children tiles and use the current one
-        if ( tileRect.width()*tileRect.height() >= TILES_MAXSIZE )
+        if ( (qulonglong)tileRect.width()*tileRect.height() >= maxTileSize )
         {
             tile.dirty = false;
-            if ( tile.pixmap )
-            {
-                totalPixels -= tile.pixmap->width()*tile.pixmap->height();
-                delete tile.pixmap;
-                tile.pixmap = 0;
-            }
+            deletePixmap( tile );
 
             for ( int i = 0; i < tile.nTiles; ++i )
                 setPixmap( pixmap, rect, tile.tiles[ i ] );
@@ -301,6 +361,7 @@ void TilesManager::Private::setPixmap( const QPixmap *pixmap, const NormalizedRe
             {
                 deleteTiles( tile.tiles[ i ] );
                 tile.tiles[ i ].pixmap = 0;
+                tile.tiles[ i ].compressed = 0;
             }
 
             delete [] tile.tiles;
@@ -308,11 +369,7 @@ void TilesManager::Private::setPixmap( const QPixmap *pixmap, const NormalizedRe
             tile.nTiles = 0;
 
             // paint tile
-            if ( tile.pixmap )
-            {
-                totalPixels -= tile.pixmap->width()*tile.pixmap->height();
-                delete tile.pixmap;
-            }
+            deletePixmap( tile );
             tile.pixmap = new QPixmap( pixmap->copy( tile.rect.geometry( width, height ).translated( -pixmapRect.topLeft() ) ) );
             tile.rotation = rotation;
             totalPixels += tile.pixmap->width()*tile.pixmap->height();
@@ -376,7 +433,7 @@ void TilesManager::Private::tilesAt( const NormalizedRect &rect, TileNode &tile,
     // requesting huge areas unnecessarily
     splitBigTiles( tile, rect );
 
-    if ( ( tileLeaf == TerminalTile && tile.nTiles == 0 ) || ( tileLeaf == PixmapTile && tile.pixmap ) )
+    if ( ( tileLeaf == TerminalTile && tile.nTiles == 0 ) || ( tileLeaf == PixmapTile && ( tile.pixmap || tile.compressed ) ) )
     {
         NormalizedRect rotatedRect;
         if ( rotation != Rotation0 )
@@ -431,7 +488,8 @@ void TilesManager::Private::tilesAt( const NormalizedRect &rect, TileNode &tile,
             tile.pixmap = rotatedPixmap;
             tile.rotation = rotation;
         }
-        result.append( Tile( rotatedRect, tile.pixmap, tile.isValid() ) );
+        if ( tileLeaf == TerminalTile || tile.pixmap )
+            result.append( Tile( rotatedRect, tile.pixmap, tile.isValid() ) );
     }
     else
     {
@@ -440,12 +498,46 @@ void TilesManager::Private::tilesAt( const NormalizedRect &rect, TileNode &tile,
     }
 }
 
+bool TilesManager::decompressTiles( const NormalizedRect &rect )
+{
+    const NormalizedRect rotatedRect = fromRotatedRect( rect, d->rotation );
+    bool decompressed = false;
+    for ( int i = 0; i < 16; ++i )
+    {
+        if ( d->decompressTiles( rotatedRect, d->tiles[ i ] ) )
+            decompressed = true;
+    }
+
+    return decompressed;
+}
+
+bool TilesManager::Private::decompressTiles( const NormalizedRect &rect, TileNode &tile )
+{
+    if ( !tile.rect.intersects( rect ) )
+        return false;
+
+    if ( tile.compressed )
+    {
+        decompress( tile );
+        return true;
+    }
+
+    bool decompressed = false;
+    for ( int i = 0; i < tile.nTiles; ++i )
+    {
+        if ( decompressTiles( rect, tile.tiles[ i ] ) )
+            decompressed = true;
+    }
+
+    return decompressed;
+}
+
 qulonglong TilesManager::totalMemory() const
 {
-    return 4*d->totalPixels;
+    return 4*d->totalPixels + d->compressedBytes;
 }
 
-void TilesManager::cleanupPixmapMemory( qulonglong numberOfBytes, const NormalizedRect &visibleRect, int visiblePageNumber )
+void TilesManager::cleanupPixmapMemory( qulonglong numberOfBytes, const NormalizedRect &visibleRect, int visiblePageNumber, bool compress )
 {
     QList<TileNode*> rankedTiles;
     for ( int i = 0; i < 16; ++i )
@@ -454,30 +546,115 @@ void TilesManager::cleanupPixmapMemory( qulonglong numberOfBytes, const Normaliz
     }
     qSort( rankedTiles.begin(), rankedTiles.end(), rankedTilesLessThan );
 
-    while ( numberOfBytes > 0 && !rankedTiles.isEmpty() )
+    // compress the least ranked tiles first, and only discard them if that
+    // is not enough
+    for ( int pass = compress ? 0 : 1; pass < 2 && numberOfBytes > 0; ++pass )
     {
-        TileNode *tile = rankedTiles.takeLast();
-        if ( !tile->pixmap )
-            continue;
-
-        // do not evict visible pixmaps
-        if ( tile->rect.intersects( visibleRect ) )
-            continue;
-
-        qulonglong pixels = tile->pixmap->width()*tile->pixmap->height();
-        d->totalPixels -= pixels;
-        if ( numberOfBytes < 4*pixels )
-            numberOfBytes = 0;
-        else
-            numberOfBytes -= 4*pixels;
+        for ( int i = rankedTiles.count() - 1; i >= 0 && numberOfBytes > 0; --i )
+        {
+            TileNode *tile = rankedTiles.at( i );
+
+            // do not evict visible pixmaps
+            if ( tile->rect.intersects( visibleRect ) )
+                continue;
+
+            const qulonglong memory = d->tileMemory( *tile );
+            if ( memory == 0 )
+                continue;
+
+            if ( pass == 0 )
+            {
+                if ( !tile->pixmap || !d->compress( *tile ) )
+                    continue;
+            }
+            else
+            {
+                d->deletePixmap( *tile );
+                d->markParentDirty( *tile );
+            }
+
+            const qulonglong freedBytes = memory - d->tileMemory( *tile );
+            if ( numberOfBytes < freedBytes )
+                numberOfBytes = 0;
+            else
+                numberOfBytes -= freedBytes;
+        }
+    }
+}
 
-        delete tile->pixmap;
-        tile->pixmap = 0;
+void TilesManager::Private::deletePixmap( TileNode &tile )
+{
+    if ( tile.pixmap )
+    {
+        totalPixels -= tile.pixmap->width()*tile.pixmap->height();
+        delete tile.pixmap;
+        tile.pixmap = 0;
+    }
 
-        d->markParentDirty( *tile );
+    if ( tile.compressed )
+    {
+        compressedBytes -= tile.compressed->data.size();
+        delete tile.compressed;
+        tile.compressed = 0;
     }
 }
 
+bool TilesManager::Private::compress( TileNode &tile )
+{
+    const QImage image = tile.pixmap->toImage();
+
+    // Tiles are mostly made of the paper color, so the fastest zlib level
+    // already shrinks them a lot. Tiles full of pictures are left alone, as
+    // they would hardly save anything
+    const QByteArray data = qCompress( image.constBits(), image.byteCount(), 1 );
+    if ( data.isEmpty() || data.size() > image.byteCount() / 4 )
+        return false;
+
+    CompressedPixmap *compressed = new CompressedPixmap;
+    compressed->data = data;
+    compressed->width = image.width();
+    compressed->height = image.height();
+    compressed->bytesPerLine = image.bytesPerLine();
+    compressed->format = image.format();
+
+    deletePixmap( tile );
+    tile.compressed = compressed;
+    compressedBytes += data.size();
+    return true;
+}
+
+void TilesManager::Private::decompress( TileNode &tile )
+{
+    const CompressedPixmap *compressed = tile.compressed;
+    const QByteArray data = qUncompress( compressed->data );
+    QImage image( compressed->width, compressed->height, compressed->format );
+    const bool ok = !image.isNull() && image.bytesPerLine() == compressed->bytesPerLine && data.size() == image.byteCount();
+    if ( ok )
+        memcpy( image.bits(), data.constData(), data.size() );
+
+    deletePixmap( tile );
+    if ( !ok )
+    {
+        // should never happen, but it is just a matter of rendering it again
+        markParentDirty( tile );
+        tile.dirty = true;
+        return;
+    }
+
+    tile.pixmap = new QPixmap( QPixmap::fromImage( image ) );
+    totalPixels += tile.pixmap->width()*tile.pixmap->height();
+}
+
+qulonglong TilesManager::Private::tileMemory( const TileNode &tile ) const
+{
+    qulonglong memory = 0;
+    if ( tile.pixmap )
+        memory += 4*tile.pixmap->width()*tile.pixmap->height();
+    if ( tile.compressed )
+        memory += tile.compressed->data.size();
+    return memory;
+}
+
 void TilesManager::Private::markParentDirty( const TileNode &tile )
 {
     if ( !tile.parent )
@@ -501,7 +678,7 @@ void TilesManager::Private::rankTiles( TileNode &tile, QList<TileNode*> &rankedT
     if ( visibleRect.isNull() && visiblePageNumber < 0 )
         return;
 
-    if ( tile.pixmap )
+    if ( tile.pixmap || tile.compressed )
     {
         // Update distance
         if ( !visibleRect.isNull() )
@@ -532,20 +709,57 @@ void TilesManager::Private::rankTiles( TileNode &tile, QList<TileNode*> &rankedT
 
 bool TilesManager::isRequesting( const NormalizedRect &rect, int pageWidth, int pageHeight ) const
 {
-    return rect == d->requestRect && pageWidth == d->requestWidth && pageHeight == d->requestHeight;
+    return d->findRequest( rect, pageWidth, pageHeight ) != -1;
 }
 
-void TilesManager::setRequest( const NormalizedRect &rect, int pageWidth, int pageHeight )
+void TilesManager::addRequest( const NormalizedRect &rect, int pageWidth, int pageHeight )
 {
-    d->requestRect = rect;
-    d->requestWidth = pageWidth;
-    d->requestHeight = pageHeight;
+    if ( isRequesting( rect, pageWidth, pageHeight ) )
+        return;
+
+    if ( d->requests.count() >= TILES_MAXREQUESTS )
+        d->requests.removeFirst();
+
+    Private::Request request;
+    request.rect = rect;
+    request.width = pageWidth;
+    request.height = pageHeight;
+    d->requests.append( request );
+    d->requested = true;
+}
+
+void TilesManager::removeRequest( const NormalizedRect &rect, int pageWidth, int pageHeight )
+{
+    const int request = d->findRequest( rect, pageWidth, pageHeight );
+    if ( request != -1 )
+        d->requests.removeAt( request );
+}
+
+int TilesManager::Private::findRequest( const NormalizedRect &rect, int pageWidth, int pageHeight ) const
+{
+    for ( int i = 0; i < requests.count(); ++i )
+    {
+        const Request &request = requests.at( i );
+        if ( request.rect == rect && request.width == pageWidth && request.height == pageHeight )
+            return i;
+    }
+    return -1;
+}
+
+void TilesManager::adaptTileSize( const NormalizedRect &visibleRect )
+{
+    if ( visibleRect.isNull() )
+        return;
+
+    const QRect visibleArea = visibleRect.geometry( d->width, d->height );
+    const qulonglong visiblePixels = (qulonglong)visibleArea.width() * visibleArea.height();
+    d->maxTileSize = qBound( (qulonglong)TILES_MINSIZE, visiblePixels / 4, (qulonglong)TILES_MAXSIZE );
 }
 
 bool TilesManager::Private::splitBigTiles( TileNode &tile, const NormalizedRect &rect )
 {
     QRect tileRect = tile.rect.geometry( width, height );
-    if ( tileRect.width()*tileRect.height() < TILES_MAXSIZE )
+    if ( (qulonglong)tileRect.width()*tileRect.height() < maxTileSize )
         return false;
 
     split( tile, rect );
@@ -629,6 +843,7 @@ NormalizedRect TilesManager::toRotatedRect( const NormalizedRect &rect, Rotation
 
 TileNode::TileNode()
     : pixmap( 0 )
+    , compressed( 0 )
     , rotation( Rotation0 )
     , dirty ( true )
     , distance( -1 )
@@ -640,7 +855,7 @@ TileNode::TileNode()
 
 bool TileNode::isValid() const
 {
-    return pixmap && !dirty;
+    return ( pixmap || compressed ) && !dirty;
 }
 
 class Tile::Private
@@ -17,6 +17,7 @@ class QPixmap;
 namespace Okular {
 
 class Tile;
+struct CompressedPixmap;
 
 /**
  * Node in the quadtree structure used by the tiles manager to store tiles.
@@ -24,8 +25,8 @@ class Tile;
  * Except for the first level, the tiles manager stores tiles in a quadtree
  * structure.
  * Each node stores the pixmap of a tile and its location on the page.
- * There's a limit on the size of the pixmaps (TILES_MAXSIZE, defined in
- * tilesmanager.cpp), and tiles that are bigger than that value are split into
+ * There's a limit on the size of the pixmaps (see TilesManager::adaptTileSize),
+ * and tiles that are bigger than that value are split into
  * four children tiles, which are stored as children of the original tile.
  * If children tiles are still too big, they are recursively split again.
  * If the zoom level changes and a big tile goes below the limit, it is merged
@@ -54,6 +55,15 @@ class TileNode
          */
         QPixmap *pixmap;
 
+        /**
+         * Compressed copy of the pixmap, kept instead of it when the tile is
+         * far from the viewport, or NULL if not present.
+         *
+         * A tile never has both a pixmap and a compressed pixmap, it gets its
+         * pixmap back as soon as it is needed again.
+         */
+        CompressedPixmap *compressed;
+
         /**
          * Rotation of this individual tile.
          *
@@ -136,7 +146,15 @@ class TilesManager
         QList<Tile> tilesAt( const NormalizedRect &rect, TileLeaf tileLeaf );
 
         /**
-         * The total memory consumed by the tiles manager
+         * Gives back their pixmap to the compressed tiles intersecting with
+         * @p rect, as tilesAt() does not return the compressed tiles.
+         * Returns whether any tile was decompressed.
+         */
+        bool decompressTiles( const NormalizedRect &rect );
+
+        /**
+         * The total memory consumed by the tiles manager, including the
+         * compressed tiles
          */
         qulonglong totalMemory() const;
 
@@ -146,8 +164,11 @@ class TilesManager
          * Set @p visibleRect to the visible region of the page. Set a
          * @p visiblePageNumber if the current page is not visible.
          * Visible tiles are not discarded.
+         *
+         * If @p compress is true, the pixmaps of the tiles are compressed in
+         * memory first, and only discarded if that does not free enough memory.
          */
-        void cleanupPixmapMemory( qulonglong numberOfBytes, const NormalizedRect &visibleRect, int visiblePageNumber );
+        void cleanupPixmapMemory( qulonglong numberOfBytes, const NormalizedRect &visibleRect, int visiblePageNumber, bool compress = false );
 
         /**
          * Checks whether a given region has already been requested
@@ -155,10 +176,25 @@ class TilesManager
         bool isRequesting( const NormalizedRect &rect, int pageWidth, int pageHeight ) const;
 
         /**
-         * Sets a region to be requested so the tiles manager knows which
-         * pixmaps to expect and discard those not useful anymore (late pixmaps)
+         * Adds a region to the ones being requested so the tiles manager knows
+         * which pixmaps to expect and discard those not useful anymore (late
+         * pixmaps). Several regions can be requested at the same time, e.g. the
+         * visible one and the one the user is scrolling to.
          */
-        void setRequest( const NormalizedRect &rect, int pageWidth, int pageHeight );
+        void addRequest( const NormalizedRect &rect, int pageWidth, int pageHeight );
+
+        /**
+         * Removes a region added with addRequest() whose pixmap will not come.
+         */
+        void removeRequest( const NormalizedRect &rect, int pageWidth, int pageHeight );
+
+        /**
+         * Chooses the maximum size of the tiles from the @p visibleRect of the
+         * page: smaller screens get smaller tiles, so that less pixels outside
+         * of the viewport are rendered, bigger screens get bigger tiles, so
+         * that less requests are needed.
+         */
+        void adaptTileSize( const NormalizedRect &visibleRect );
 
         /**
          * Inform the new size of the page and mark all tiles to repaint
@@ -186,6 +222,13 @@ class TilesManager
          */
         void markDirty();
 
+        /**
+         * Sets whether the page is tiled because only a small part of it is
+         * visible, rather than because of its size
+         */
+        void setPartialRendering( bool partial );
+        bool isPartialRendering() const;
+
         /**
          * Returns a rotated NormalizedRect given a @p rotation
          */
@@ -9,12 +9,19 @@
 
 #include "document.h"
 
+#include <QtCore/QBuffer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QProcess>
 #include <QtCore/QScopedPointer>
 #include <QtGui/QImage>
 #include <QtGui/QImageReader>
 
 #include <klocale.h>
 #include <kmimetype.h>
+#include <ktempdir.h>
 #include <kzip.h>
 #include <ktar.h>
 
@@ -28,6 +35,10 @@
 
 using namespace ComicBook;
 
+// enough for the headers of the common image formats, even with big
+// EXIF blocks before the size of a JPEG image
+static const qint64 headerSize = 64 * 1024;
+
 static void imagesInArchive( const QString &prefix, const KArchiveDirectory* dir, QStringList *entries )
 {
     Q_FOREACH ( const QString &entry, dir->entries() ) {
@@ -42,7 +53,7 @@ static void imagesInArchive( const QString &prefix, const KArchiveDirectory* dir
 
 
 Document::Document()
-    : mDirectory( 0 ), mUnrar( 0 ), mArchive( 0 )
+    : mDirectory( 0 ), mUnrar( 0 ), mArchive( 0 ), mExtractDir( 0 )
 {
 }
 
@@ -99,6 +110,7 @@ bool Document::open( const QString &fileName )
         }
 
         mEntries = mUnrar->list();
+        mExtractDir = new KTempDir();
     } else if ( mime->is( "inode/directory" ) ) {
         mDirectory = new Directory();
 
@@ -131,6 +143,9 @@ void Document::close()
     mDirectory = 0;
     delete mUnrar;
     mUnrar = 0;
+    delete mExtractDir;
+    mExtractDir = 0;
+    mExtractedFiles.clear();
     mPageMap.clear();
     mEntries.clear();
 }
@@ -158,42 +173,89 @@ bool Document::processArchive() {
     return true;
 }
 
+QIODevice* Document::createDevice( const QString &file, qint64 maxSize ) const
+{
+    if ( mArchive ) {
+        const KArchiveFile *entry = static_cast<const KArchiveFile*>( mArchiveDir->entry( file ) );
+        if ( entry ) {
+            return entry->createDevice();
+        }
+    } else if ( mDirectory ) {
+        return mDirectory->createDevice( file );
+    } else if ( mUnrar ) {
+        if ( mExtractedFiles.contains( file ) ) {
+            std::auto_ptr< QFile > extracted( new QFile( mExtractDir->name() + file ) );
+            if ( extracted->open( QIODevice::ReadOnly ) ) {
+                return extracted.release();
+            }
+        }
+
+        // every read extracts the file again, only take its start if asked
+        std::auto_ptr< QBuffer > buffer( new QBuffer() );
+        buffer->setData( mUnrar->contentOf( file, maxSize ) );
+        if ( buffer->open( QIODevice::ReadOnly ) ) {
+            return buffer.release();
+        }
+    }
+
+    return 0;
+}
+
+QSize Document::imageSize( const QString &file ) const
+{
+    QScopedPointer< QIODevice > dev( createDevice( file, headerSize ) );
+    if ( dev.isNull() ) {
+        return QSize();
+    }
+
+    QImageReader reader( dev.data() );
+    QSize size = reader.size();
+    if ( !size.isValid() ) {
+        // the format does not tell the size in its header, decode it all
+        dev.reset( createDevice( file, -1 ) );
+        if ( dev.isNull() ) {
+            return QSize();
+        }
+        reader.setDevice( dev.data() );
+        size = reader.read().size();
+    }
+    return size;
+}
+
 void Document::pages( QVector<Okular::Page*> * pagesVector )
 {
     qSort( mEntries.begin(), mEntries.end(), caseSensitiveNaturalOrderLessThen );
-    QScopedPointer< QIODevice > dev;
 
-    int count = 0;
-    pagesVector->clear();
-    pagesVector->resize( mEntries.size() );
+    // the entries with the suffix of an image format are taken as pages
+    // without reading them, only the others are checked
+    const QList<QByteArray> formats = QImageReader::supportedImageFormats();
     QImageReader reader;
     foreach(const QString &file, mEntries) {
-        if ( mArchive ) {
-            const KArchiveFile *entry = static_cast<const KArchiveFile*>( mArchiveDir->entry( file ) );
-            if ( entry ) {
-                dev.reset( entry->createDevice() );
-            }
-        } else if ( mDirectory ) {
-            dev.reset( mDirectory->createDevice( file ) );
-        } else {
-            dev.reset( mUnrar->createDevice( file ) );
+        const QByteArray suffix = QFileInfo( file ).suffix().toLower().toLatin1();
+        if ( !suffix.isEmpty() && formats.contains( suffix ) ) {
+            mPageMap.append( file );
+            continue;
         }
 
-        if ( ! dev.isNull() ) {
+        QScopedPointer< QIODevice > dev( createDevice( file, headerSize ) );
+        if ( !dev.isNull() ) {
             reader.setDevice( dev.data() );
-            if ( reader.canRead() )
-            {
-                QSize pageSize = reader.size();
-                if ( !pageSize.isValid() ) {
-                    pageSize = reader.read().size();
-                }
-                pagesVector->replace( count, new Okular::Page( count, pageSize.width(), pageSize.height(), Okular::Rotation0 ) );
-                mPageMap.append(file);
-                count++;
+            if ( reader.canRead() ) {
+                mPageMap.append( file );
             }
         }
     }
-    pagesVector->resize( count );
+
+    pagesVector->clear();
+    if ( mPageMap.isEmpty() ) {
+        return;
+    }
+
+    const QSize firstPageSize = imageSize( mPageMap.first() );
+    pagesVector->resize( mPageMap.count() );
+    for ( int i = 0; i < mPageMap.count(); ++i ) {
+        pagesVector->replace( i, new Okular::Page( i, firstPageSize.width(), firstPageSize.height(), Okular::Rotation0 ) );
+    }
 }
 
 QStringList Document::pageTitles() const
@@ -201,19 +263,117 @@ QStringList Document::pageTitles() const
     return QStringList();
 }
 
-QImage Document::pageImage( int page ) const
+QByteArray Document::pageData( int page ) const
 {
     if ( mArchive ) {
         const KArchiveFile *entry = static_cast<const KArchiveFile*>( mArchiveDir->entry( mPageMap[ page ] ) );
-        if ( entry )
-            return QImage::fromData( entry->data() );
-    } else if ( mDirectory ) {
-        return QImage( mPageMap[ page ] );
+        if ( entry ) {
+            return entry->data();
+        }
     } else {
-        return QImage::fromData( mUnrar->contentOf( mPageMap[ page ] ) );
+        QScopedPointer< QIODevice > dev( createDevice( mPageMap[ page ], -1 ) );
+        if ( !dev.isNull() ) {
+            return dev->readAll();
+        }
+    }
+
+    return QByteArray();
+}
+
+QImage Document::pageImage( const QByteArray &data, const QSize &size )
+{
+    if ( data.isEmpty() ) {
+        return QImage();
+    }
+
+    QBuffer buffer;
+    buffer.setData( data );
+    buffer.open( QIODevice::ReadOnly );
+
+    QImageReader reader( &buffer );
+    const QSize imageSize = reader.size();
+    if ( size.isValid() && imageSize.isValid() &&
+         size.width() < imageSize.width() && size.height() < imageSize.height() ) {
+        // the decoders supporting it, like the JPEG one, skip most of the
+        // work for the small sizes instead of decoding the whole image
+        reader.setScaledSize( size );
+    }
+    return reader.read();
+}
+
+void Document::readPageSizes( int firstPage, QMutex *archiveMutex, PageSizeReceiver *receiver ) const
+{
+    if ( !mUnrar ) {
+        for ( int page = firstPage; page < mPageMap.count() && !receiver->isCancelled(); ++page ) {
+            archiveMutex->lock();
+            const QSize size = imageSize( mPageMap[ page ] );
+            archiveMutex->unlock();
+            receiver->pageSizeRead( page, size );
+        }
+        return;
     }
 
-    return QImage();
+    // extracting the files one by one would decompress a solid archive
+    // again for every file: extract all of them in one pass, and read each
+    // page once the next one shows up; the pages are kept for pageData(),
+    // the other files go with the directory when closing
+    QHash< QString, int > pageNumbers;
+    for ( int page = 0; page < mPageMap.count(); ++page ) {
+        pageNumbers.insert( mPageMap[ page ], page );
+    }
+    QStringList files;
+    Q_FOREACH ( const QString &file, mUnrar->list() ) {
+        if ( pageNumbers.contains( file ) ) {
+            files.append( file );
+        }
+    }
+
+    const QString directory = mExtractDir->name();
+    QProcess process;
+    if ( files.isEmpty() || !mUnrar->startExtraction( &process, directory ) ) {
+        return;
+    }
+
+    int next = 0;
+    bool finished = false;
+    while ( next < files.count() && !receiver->isCancelled() ) {
+        if ( !finished ) {
+            finished = process.waitForFinished( 100 );
+        }
+
+        while ( next < files.count() &&
+                ( finished || ( next + 1 < files.count() && QFile::exists( directory + files[ next + 1 ] ) ) ) ) {
+            // a failed extraction may leave the last file incomplete
+            const bool complete = !finished ||
+                ( process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0 );
+            QFile file( directory + files[ next ] );
+            if ( complete && file.exists() ) {
+                archiveMutex->lock();
+                mExtractedFiles.insert( files[ next ] );
+                archiveMutex->unlock();
+            }
+
+            const int page = pageNumbers.value( files[ next ] );
+            if ( page >= firstPage ) {
+                QSize size;
+                if ( file.open( QIODevice::ReadOnly ) ) {
+                    QImageReader reader( &file );
+                    size = reader.size();
+                    if ( !size.isValid() ) {
+                        size = reader.read().size();
+                    }
+                    file.close();
+                }
+                receiver->pageSizeRead( page, size );
+            }
+            ++next;
+        }
+    }
+
+    if ( !finished ) {
+        process.kill();
+        process.waitForFinished( -1 );
+    }
 }
 
 QString Document::lastErrorString() const
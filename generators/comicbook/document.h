@@ -10,12 +10,16 @@
 #ifndef COMICBOOK_DOCUMENT_H
 #define COMICBOOK_DOCUMENT_H
 
+#include <QtCore/QSet>
+#include <QtCore/QSize>
 #include <QtCore/QStringList>
 
 class KArchiveDirectory;
 class KArchive;
+class KTempDir;
 class QImage;
-class QSize;
+class QIODevice;
+class QMutex;
 class Unrar;
 class Directory;
 
@@ -25,6 +29,22 @@ class Page;
 
 namespace ComicBook {
 
+/**
+ * Gets the sizes of the pages read by Document::readPageSizes().
+ */
+class PageSizeReceiver
+{
+    public:
+        virtual ~PageSizeReceiver() {}
+
+        virtual void pageSizeRead( int page, const QSize &size ) = 0;
+
+        /**
+         * Whether to stop reading the sizes.
+         */
+        virtual bool isCancelled() const = 0;
+};
+
 class Document
 {
     public:
@@ -34,15 +54,45 @@ class Document
         bool open( const QString &fileName );
         void close();
 
+        /**
+         * Fills the @p pagesVector with the pages of the document. Only the
+         * size of the first page is read, all the pages get that size; the
+         * others can be read later with readPageSizes().
+         */
         void pages( QVector<Okular::Page*> * pagesVector );
         QStringList pageTitles() const;
 
-        QImage pageImage( int page ) const;
+        /**
+         * Returns the encoded image of the @p page, as read from the archive.
+         */
+        QByteArray pageData( int page ) const;
+
+        /**
+         * Decodes the image @p data of a page. If @p size is valid and smaller
+         * than the image, the image is decoded at about that size.
+         *
+         * Only pageData() reads the archive, so this needs no locking.
+         */
+        static QImage pageImage( const QByteArray &data, const QSize &size = QSize() );
+
+        /**
+         * Reads the sizes of the pages from @p firstPage on, giving them to
+         * the @p receiver. Only the headers of the images are read when the
+         * image format allows it; RAR archives are instead extracted in one
+         * pass to a temporary directory, where pageData() then reads the
+         * pages from until the document is closed.
+         *
+         * Meant to run in a thread: @p archiveMutex is locked while the
+         * archive is read, as when reading the images of the pages.
+         */
+        void readPageSizes( int firstPage, QMutex *archiveMutex, PageSizeReceiver *receiver ) const;
 
         QString lastErrorString() const;
 
     private:
         bool processArchive();
+        QIODevice* createDevice( const QString &file, qint64 maxSize ) const;
+        QSize imageSize( const QString &file ) const;
 
         QStringList mPageMap;
         Directory *mDirectory;
@@ -51,6 +101,10 @@ class Document
         KArchiveDirectory *mArchiveDir;
         QString mLastErrorString;
         QStringList mEntries;
+        // the files of a RAR archive extracted by readPageSizes(), guarded
+        // by its archive mutex
+        KTempDir *mExtractDir;
+        mutable QSet< QString > mExtractedFiles;
 };
 
 }
@@ -9,6 +9,7 @@
 
 #include "generator_comicbook.h"
 
+#include <QtCore/QTimer>
 #include <QtGui/QPainter>
 #include <QtGui/QPrinter>
 
@@ -19,6 +20,8 @@
 #include <core/page.h>
 #include <core/fileprinter.h>
 
+#include "pagesizethread.h"
+
 static KAboutData createAboutData()
 {
     KAboutData aboutData(
@@ -38,11 +41,15 @@ static KAboutData createAboutData()
 OKULAR_EXPORT_PLUGIN( ComicBookGenerator, createAboutData() )
 
 ComicBookGenerator::ComicBookGenerator( QObject *parent, const QVariantList &args )
-    : Generator( parent, args )
+    : Generator( parent, args ), mSizeThread( 0 )
 {
     setFeature( Threaded );
     setFeature( PrintNative );
     setFeature( PrintToFile );
+
+    mSizesTimer = new QTimer( this );
+    mSizesTimer->setSingleShot( true );
+    connect( mSizesTimer, SIGNAL(timeout()), this, SLOT(flushPageSizes()) );
 }
 
 ComicBookGenerator::~ComicBookGenerator()
@@ -60,12 +67,37 @@ bool ComicBookGenerator::loadDocument( const QString & fileName, QVector<Okular:
     }
 
     mDocument.pages( &pagesVector );
+
+    cacheMemoryChanged();
+
+    if ( pagesVector.count() > 1 )
+    {
+        const QSize firstPageSize( qRound( pagesVector[0]->width() ), qRound( pagesVector[0]->height() ) );
+        mSizeThread = new PageSizeThread( &mDocument, userMutex(), firstPageSize, this );
+        connect( mSizeThread, SIGNAL(sizesRead()), this, SLOT(pageSizesRead()), Qt::QueuedConnection );
+        connect( mSizeThread, SIGNAL(finished()), this, SLOT(flushPageSizes()), Qt::QueuedConnection );
+        mLastSizesUpdate.start();
+        mSizeThread->start( QThread::LowPriority );
+    }
     return true;
 }
 
 bool ComicBookGenerator::doCloseDocument()
 {
+    // the thread reads the archive, stop it before closing it
+    mSizesTimer->stop();
+    if ( mSizeThread )
+    {
+        mSizeThread->stop();
+        delete mSizeThread;
+        mSizeThread = 0;
+    }
+
+    userMutex()->lock();
+    mImageCache.clear();
+    mImageCacheCost = 0;
     mDocument.close();
+    userMutex()->unlock();
 
     return true;
 }
@@ -74,8 +106,37 @@ QImage ComicBookGenerator::image( Okular::PixmapRequest * request )
 {
     int width = request->width();
     int height = request->height();
+    const int pageNumber = request->pageNumber();
+
+    QImage image;
+    QByteArray data;
+    userMutex()->lock();
+    // an image decoded for a request serves the smaller ones of the same
+    // page, like the thumbnail after the page view, without extracting and
+    // decoding it again
+    const QImage *cached = mImageCache.object( pageNumber );
+    if ( cached && cached->width() >= width && cached->height() >= height )
+        image = *cached;
+    else
+        data = mDocument.pageData( pageNumber );
+    userMutex()->unlock();
+
+    // only reading the archive needs the lock, the other pages can be read
+    // while this one is decoded
+    if ( !data.isEmpty() )
+    {
+        image = ComicBook::Document::pageImage( data, QSize( width, height ) );
+        if ( !image.isNull() )
+        {
+            userMutex()->lock();
+            mImageCache.insert( pageNumber, new QImage( image ), image.byteCount() / 1024 );
+            mImageCacheCost = mImageCache.totalCost();
+            userMutex()->unlock();
+        }
+    }
 
-    QImage image = mDocument.pageImage( request->pageNumber() );
+    if ( image.width() == width && image.height() == height )
+        return image;
 
     return image.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
 }
@@ -90,7 +151,10 @@ bool ComicBookGenerator::print( QPrinter& printer )
 
     for ( int i = 0; i < pageList.count(); ++i ) {
 
-        QImage image = mDocument.pageImage( pageList[i] - 1 );
+        userMutex()->lock();
+        const QByteArray data = mDocument.pageData( pageList[i] - 1 );
+        userMutex()->unlock();
+        QImage image = ComicBook::Document::pageImage( data );
 
         if ( ( image.width() > printer.width() ) || ( image.height() > printer.height() ) )
 
@@ -106,5 +170,53 @@ bool ComicBookGenerator::print( QPrinter& printer )
     return true;
 }
 
+QVariant ComicBookGenerator::metaData( const QString &key, const QVariant &option ) const
+{
+    if ( key == QLatin1String( "CacheMemoryUsage" ) )
+        return qulonglong( int( mImageCacheCost ) ) * 1024;
+
+    return Okular::Generator::metaData( key, option );
+}
+
+void ComicBookGenerator::cacheMemoryChanged()
+{
+    // the document gives the memory in bytes, the cost of the images is
+    // in KiB
+    const qulonglong cacheMemory = documentMetaData( "CacheMemory" ).toULongLong();
+
+    userMutex()->lock();
+    mImageCache.setMaxCost( cacheMemory > 0 ? int( cacheMemory / 1024 ) : 64 * 1024 );
+    mImageCacheCost = mImageCache.totalCost();
+    userMutex()->unlock();
+}
+
+void ComicBookGenerator::pageSizesRead()
+{
+    // relayouting is not cheap, do it at most once per second
+    const int elapsed = mLastSizesUpdate.elapsed();
+    if ( elapsed < 1000 )
+    {
+        if ( !mSizesTimer->isActive() )
+            mSizesTimer->start( 1000 - elapsed );
+        return;
+    }
+
+    flushPageSizes();
+}
+
+void ComicBookGenerator::flushPageSizes()
+{
+    if ( !mSizeThread )
+        return;
+
+    mSizesTimer->stop();
+    const QHash< int, QSizeF > sizes = mSizeThread->takeSizes();
+    if ( !sizes.isEmpty() )
+    {
+        updatePageSizes( sizes );
+        mLastSizesUpdate.restart();
+    }
+}
+
 #include "generator_comicbook.moc"
 
@@ -12,8 +12,16 @@
 
 #include <core/generator.h>
 
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCache>
+#include <QtCore/QTime>
+#include <QtGui/QImage>
+
 #include "document.h"
 
+class QTimer;
+class PageSizeThread;
+
 class ComicBookGenerator : public Okular::Generator
 {
     Q_OBJECT
@@ -28,12 +36,33 @@ class ComicBookGenerator : public Okular::Generator
         // [INHERITED] print document using already configured kprinter
         bool print( QPrinter& printer );
 
+        // [INHERITED] the memory used by the image cache
+        QVariant metaData( const QString &key, const QVariant &option ) const;
+
     protected:
         bool doCloseDocument();
         QImage image( Okular::PixmapRequest * request );
 
+    protected slots:
+        void cacheMemoryChanged();
+
+    private slots:
+        void pageSizesRead();
+        void flushPageSizes();
+
     private:
       ComicBook::Document mDocument;
+
+      // the pages get the size of the first one when loading, the actual
+      // sizes of the others are read by a thread
+      PageSizeThread *mSizeThread;
+      QTimer *mSizesTimer;
+      QTime mLastSizesUpdate;
+
+      // the last images decoded, by page, with their cost in KiB; the
+      // total cost is kept aside to be read without locking
+      QCache< int, QImage > mImageCache;
+      QAtomicInt mImageCacheCost;
 };
 
 #endif
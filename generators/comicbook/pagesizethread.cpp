@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "pagesizethread.h"
+
+PageSizeThread::PageSizeThread( const ComicBook::Document *document, QMutex *archiveMutex, const QSize &firstPageSize, QObject *parent )
+    : QThread( parent ), mDocument( document ), mArchiveMutex( archiveMutex ), mFirstPageSize( firstPageSize ), mCancelled( 0 )
+{
+}
+
+PageSizeThread::~PageSizeThread()
+{
+    stop();
+}
+
+void PageSizeThread::stop()
+{
+    mCancelled.fetchAndStoreOrdered( 1 );
+    wait();
+}
+
+QHash< int, QSizeF > PageSizeThread::takeSizes()
+{
+    QMutexLocker locker( &mSizesMutex );
+    QHash< int, QSizeF > sizes;
+    qSwap( sizes, mSizes );
+    return sizes;
+}
+
+void PageSizeThread::pageSizeRead( int page, const QSize &size )
+{
+    if ( !size.isValid() || size == mFirstPageSize )
+        return;
+
+    QMutexLocker locker( &mSizesMutex );
+    const bool first = mSizes.isEmpty();
+    mSizes.insert( page, size );
+    locker.unlock();
+
+    if ( first )
+        emit sizesRead();
+}
+
+bool PageSizeThread::isCancelled() const
+{
+    return mCancelled;
+}
+
+void PageSizeThread::run()
+{
+    mDocument->readPageSizes( 1, mArchiveMutex, this );
+}
+
+#include "pagesizethread.moc"
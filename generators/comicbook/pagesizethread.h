@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef COMICBOOK_PAGESIZETHREAD_H
+#define COMICBOOK_PAGESIZETHREAD_H
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QSizeF>
+#include <QtCore/QThread>
+
+#include "document.h"
+
+/**
+ * Thread reading the sizes of the pages of a comic book, but the first one,
+ * after the document is loaded.
+ *
+ * The pages get the size of the first page when loading, only the sizes
+ * different from it are kept, until taken with takeSizes().
+ */
+class PageSizeThread : public QThread, public ComicBook::PageSizeReceiver
+{
+    Q_OBJECT
+
+    public:
+        /**
+         * The archive of @p document is read with @p archiveMutex locked.
+         */
+        PageSizeThread( const ComicBook::Document *document, QMutex *archiveMutex, const QSize &firstPageSize, QObject *parent = 0 );
+        ~PageSizeThread();
+
+        /**
+         * Stops reading the sizes, and waits for the thread to finish.
+         */
+        void stop();
+
+        /**
+         * Returns the sizes read since the previous call, by page.
+         */
+        QHash< int, QSizeF > takeSizes();
+
+        // [INHERITED] from ComicBook::PageSizeReceiver, called by the thread
+        void pageSizeRead( int page, const QSize &size );
+        bool isCancelled() const;
+
+    signals:
+        /**
+         * Emitted when sizes are available to takeSizes(), once until they
+         * are taken.
+         */
+        void sizesRead();
+
+    protected:
+        void run();
+
+    private:
+        const ComicBook::Document *mDocument;
+        QMutex *mArchiveMutex;
+        QSize mFirstPageSize;
+        QAtomicInt mCancelled;
+
+        QMutex mSizesMutex;
+        QHash< int, QSizeF > mSizes;
+};
+
+#endif
@@ -9,15 +9,14 @@
 
 #include "unrar.h"
 
+#include <QtCore/QBuffer>
 #include <QtCore/QEventLoop>
-#include <QtCore/QFile>
 #include <QtCore/QRegExp>
 
 #include <kdebug.h>
 #include <kglobal.h>
 #include <klocale.h>
 #include <kstandarddirs.h>
-#include <ktempdir.h>
 #if !defined(Q_OS_WIN)
 #include <kptyprocess.h>
 #include <kptydevice.h>
@@ -89,13 +88,12 @@ UnrarHelper::~UnrarHelper()
 
 
 Unrar::Unrar()
-    : QObject( 0 ), mLoop( 0 ), mTempDir( 0 )
+    : QObject( 0 ), mLoop( 0 )
 {
 }
 
 Unrar::~Unrar()
 {
-    delete mTempDir;
 }
 
 bool Unrar::open( const QString &fileName )
@@ -103,53 +101,66 @@ bool Unrar::open( const QString &fileName )
     if ( !isSuitableVersionAvailable() )
         return false;
 
-    delete mTempDir;
-    mTempDir = new KTempDir();
-
     mFileName = fileName;
+    mEntries.clear();
 
     /**
-     * Extract the archive to a temporary directory
+     * Only list the archive, the files are extracted one by one when needed
      */
     mStdOutData.clear();
     mStdErrData.clear();
 
-    int ret = startSyncProcess( QStringList() << "e" << mFileName << mTempDir->name() );
+    int ret = startSyncProcess( QStringList() << "lb" << "--" << mFileName );
     bool ok = ret == 0;
 
+    if ( ok )
+        mEntries = helper->kind->processListing( QString::fromLocal8Bit( mStdOutData ).split( '\n', QString::SkipEmptyParts ) );
+
     return ok;
 }
 
 QStringList Unrar::list()
 {
-    mStdOutData.clear();
-    mStdErrData.clear();
-
-    if ( !isSuitableVersionAvailable() )
-        return QStringList();
-
-    startSyncProcess( QStringList() << "lb" << mFileName );
-
-    const QStringList listFiles = helper->kind->processListing( QString::fromLocal8Bit( mStdOutData ).split( '\n', QString::SkipEmptyParts ) );
-    QStringList newList;
-    Q_FOREACH ( const QString &f, listFiles ) {
-        if ( QFile::exists( mTempDir->name() + f ) ) {
-            newList.append( f );
-        }
-    }
-    return newList;
+    return mEntries;
 }
 
-QByteArray Unrar::contentOf( const QString &fileName ) const
+QByteArray Unrar::contentOf( const QString &fileName, qint64 maxSize ) const
 {
     if ( !isSuitableVersionAvailable() )
         return QByteArray();
 
-    QFile file( mTempDir->name() + fileName );
-    if ( !file.open( QIODevice::ReadOnly ) )
+    // "p" prints the file to the standard output, -inul silences everything
+    // else, -p- does not ask for a password and "--" ends the switches, for
+    // the entries starting with a dash; a plain QProcess as there is no
+    // event loop in the worker threads
+    QProcess process;
+    process.start( helper->unrarPath, QStringList() << "p" << "-inul" << "-p-" << "--" << mFileName << fileName, QIODevice::ReadOnly );
+    if ( !process.waitForStarted( -1 ) )
         return QByteArray();
 
-    return file.readAll();
+    QByteArray data;
+    while ( process.waitForReadyRead( -1 ) )
+    {
+        data += process.readAllStandardOutput();
+        if ( maxSize >= 0 && data.size() >= maxSize )
+        {
+            process.kill();
+            break;
+        }
+    }
+    process.waitForFinished( -1 );
+
+    if ( maxSize < 0 || data.size() < maxSize )
+    {
+        data += process.readAllStandardOutput();
+        if ( process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0 )
+        {
+            kDebug() << "Could not extract" << fileName << "from" << mFileName;
+            return QByteArray();
+        }
+    }
+
+    return data;
 }
 
 QIODevice* Unrar::createDevice( const QString &fileName ) const
@@ -157,11 +168,22 @@ QIODevice* Unrar::createDevice( const QString &fileName ) const
     if ( !isSuitableVersionAvailable() )
         return 0;
 
-    std::auto_ptr< QFile> file( new QFile( mTempDir->name() + fileName ) );
-    if ( !file->open( QIODevice::ReadOnly ) )
+    std::auto_ptr< QBuffer > buffer( new QBuffer() );
+    buffer->setData( contentOf( fileName ) );
+    if ( buffer->data().isEmpty() || !buffer->open( QIODevice::ReadOnly ) )
         return 0;
 
-    return file.release();
+    return buffer.release();
+}
+
+bool Unrar::startExtraction( QProcess *process, const QString &directory ) const
+{
+    if ( !isSuitableVersionAvailable() )
+        return false;
+
+    // no question about the passwords or the files to overwrite
+    process->start( helper->unrarPath, QStringList() << "x" << "-inul" << "-p-" << "-o+" << "--" << mFileName << directory, QIODevice::ReadOnly );
+    return process->waitForStarted( -1 );
 }
 
 bool Unrar::isAvailable()
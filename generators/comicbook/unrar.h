@@ -15,7 +15,6 @@
 #include <QtCore/QStringList>
 
 class QEventLoop;
-class KTempDir;
 class KPtyProcess;
 
 class Unrar : public QObject
@@ -44,15 +43,30 @@ class Unrar : public QObject
         QStringList list();
 
         /**
-         * Returns the content of the file with the given name.
+         * Returns the content of the file with the given name, extracted
+         * from the archive on demand. If @p maxSize is not negative, stops
+         * extracting after reading that many bytes.
+         *
+         * Can be called from any thread.
          */
-        QByteArray contentOf( const QString &fileName ) const;
+        QByteArray contentOf( const QString &fileName, qint64 maxSize = -1 ) const;
 
         /**
          * Returns a new device for reading the file with the given name.
          */
         QIODevice* createDevice( const QString &fileName ) const;
 
+        /**
+         * Starts @p process extracting all the files of the archive, with
+         * their paths, into @p directory (ending with a slash), in the order
+         * of list(). Reading many files that way takes a single pass over
+         * the archive, that contentOf() makes for every file with solid
+         * archives.
+         *
+         * Can be called from any thread.
+         */
+        bool startExtraction( QProcess *process, const QString &directory ) const;
+
         static bool isAvailable();
         static bool isSuitableVersionAvailable();
 
@@ -74,7 +88,7 @@ class Unrar : public QObject
         QString mFileName;
         QByteArray mStdOutData;
         QByteArray mStdErrData;
-        KTempDir *mTempDir;
+        QStringList mEntries;
 };
 
 #endif
@@ -128,10 +128,15 @@ bool DjVuGenerator::doCloseDocument()
     return true;
 }
 
+static bool shouldAbortRender( const void *payload )
+{
+    return static_cast< const Okular::PixmapRequest * >( payload )->shouldAbortRender();
+}
+
 QImage DjVuGenerator::image( Okular::PixmapRequest *request )
 {
     userMutex()->lock();
-    QImage img = m_djvu->image( request->pageNumber(), request->width(), request->height(), request->page()->rotation() );
+    QImage img = m_djvu->image( request->pageNumber(), request->width(), request->height(), request->page()->rotation(), shouldAbortRender, request );
     userMutex()->unlock();
     return img;
 }
@@ -905,7 +905,7 @@ const QVector<KDjVu::Page*> &KDjVu::pages() const
     return d->m_pages;
 }
 
-QImage KDjVu::image( int page, int width, int height, int rotation )
+QImage KDjVu::image( int page, int width, int height, int rotation, AbortCallback shouldAbort, const void *payload )
 {
     if ( d->m_cacheEnabled )
     {
@@ -972,11 +972,18 @@ QImage KDjVu::image( int page, int width, int height, int rotation )
         // more than one part -- need to render piece-by-piece and to compose
         // the results
         newimg = QImage( width, height, QImage::Format_RGB32 );
+        bool aborted = false;
         QPainter p;
         p.begin( &newimg );
         int parts = xparts * yparts;
         for ( int i = 0; i < parts; ++i )
         {
+            if ( shouldAbort && shouldAbort( payload ) )
+            {
+                aborted = true;
+                res = 0;
+                break;
+            }
             int row = i % xparts;
             int col = i / xparts;
             int tmpres = 0;
@@ -989,6 +996,8 @@ QImage KDjVu::image( int page, int width, int height, int rotation )
             res = qMin( tmpres, res );
         }
         p.end();
+        if ( aborted )
+            newimg = QImage();
     }
 
     if ( res && d->m_cacheEnabled )
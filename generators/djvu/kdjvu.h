@@ -250,12 +250,22 @@ class KDjVu
          */
         void linksAndAnnotationsForPage( int pageNum, QList<KDjVu::Link*> *links, QList<KDjVu::Annotation*> *annotations ) const;
 
+        /**
+         * Callback polled between the rendered strips of a big page; if it
+         * returns true the rendering is stopped.
+         */
+        typedef bool (*AbortCallback)( const void *payload );
+
         /**
          * Check if the image for the specified \p page with the specified
          * \p width, \p height and \p rotation is already in cache, and returns
          * it. If not, a null image is returned.
+         *
+         * If \p shouldAbort is given, it is called with \p payload between
+         * the strips of big pages; when it returns true a null image is
+         * returned and nothing is cached.
          */
-        QImage image( int page, int width, int height, int rotation );
+        QImage image( int page, int width, int height, int rotation, AbortCallback shouldAbort = 0, const void *payload = 0 );
 
         /**
          * Export the currently open document as PostScript file \p fileName.
@@ -130,6 +130,15 @@ QImage KIMGIOGenerator::image( Okular::PixmapRequest * request )
     if ( request->page()->rotation() % 2 == 1 )
         qSwap( width, height );
 
+    // the smooth scaling costs as much as the pixels of the source, so for
+    // the small sizes, like the thumbnails, first go quickly down to twice
+    // the wanted size, with hardly a visible difference
+    if ( width * 2 < m_img.width() && height * 2 < m_img.height() )
+    {
+        const QImage reduced = m_img.scaled( width * 2, height * 2, Qt::IgnoreAspectRatio, Qt::FastTransformation );
+        return reduced.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    }
+
     return m_img.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
 }
 
@@ -124,6 +124,7 @@ void PopplerAnnotationProxy::notifyAddition( Okular::Annotation *okl_ann, int pa
     Poppler::Page *ppl_page = ppl_doc->page( page );
     ppl_page->addAnnotation( ppl_ann );
     delete ppl_page;
+    setPageModified( page );
 
     // Set pointer to poppler annotation as native Id
     okl_ann->setNativeId( qVariantFromValue( ppl_ann ) );
@@ -136,7 +137,6 @@ void PopplerAnnotationProxy::notifyAddition( Okular::Annotation *okl_ann, int pa
 void PopplerAnnotationProxy::notifyModification( const Okular::Annotation *okl_ann, int page, bool appearanceChanged )
 {
 #ifdef HAVE_POPPLER_0_20
-    Q_UNUSED( page );
     Q_UNUSED( appearanceChanged );
 
     Poppler::Annotation *ppl_ann = qvariant_cast<Poppler::Annotation*>( okl_ann->nativeId() );
@@ -145,6 +145,7 @@ void PopplerAnnotationProxy::notifyModification( const Okular::Annotation *okl_a
         return;
 
     QMutexLocker ml(mutex);
+    setPageModified( page );
 
     if ( okl_ann->flags() & Okular::Annotation::BeingMoved )
     {
@@ -257,12 +258,25 @@ void PopplerAnnotationProxy::notifyRemoval( Okular::Annotation *okl_ann, int pag
     Poppler::Page *ppl_page = ppl_doc->page( page );
     ppl_page->removeAnnotation( ppl_ann ); // Also destroys ppl_ann
     delete ppl_page;
+    setPageModified( page );
 
     okl_ann->setNativeId( qVariantFromValue(0) ); // So that we don't double-free in disposeAnnotation
 
     kDebug(PDFGenerator::PDFDebug) << okl_ann->uniqueName();
 #endif
 }
+
+bool PopplerAnnotationProxy::isPageModified( int page ) const
+{
+    QMutexLocker ml(&modifiedPagesMutex);
+    return modifiedPages.contains( page );
+}
+
+void PopplerAnnotationProxy::setPageModified( int page )
+{
+    QMutexLocker ml(&modifiedPagesMutex);
+    modifiedPages.insert( page );
+}
 //END PopplerAnnotationProxy implementation
 
 Okular::Annotation* createAnnotationFromPopplerAnnotation( Poppler::Annotation *ann, bool *doDelete )
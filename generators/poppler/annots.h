@@ -14,6 +14,7 @@
 #include <poppler-qt4.h>
 
 #include <qmutex.h>
+#include <qset.h>
 
 #include "core/annotations.h"
 #include "config-okular-poppler.h"
@@ -30,9 +31,17 @@ class PopplerAnnotationProxy : public Okular::AnnotationProxy
         void notifyAddition( Okular::Annotation *annotation, int page );
         void notifyModification( const Okular::Annotation *annotation, int page, bool appearanceChanged );
         void notifyRemoval( Okular::Annotation *annotation, int page );
+
+        // whether the annotations of the page have been changed in the
+        // document, so that it does not render like the file anymore
+        bool isPageModified( int page ) const;
     private:
+        void setPageModified( int page );
+
         Poppler::Document *ppl_doc;
         QMutex *mutex;
+        QSet<int> modifiedPages;
+        mutable QMutex modifiedPagesMutex;
 };
 
 #endif
@@ -14,13 +14,16 @@
 // qt/kde includes
 #include <qcheckbox.h>
 #include <qcolor.h>
+#include <qdatetime.h>
 #include <qfile.h>
 #include <qimage.h>
 #include <qlayout.h>
 #include <qmutex.h>
 #include <qregexp.h>
+#include <qset.h>
 #include <qstack.h>
 #include <qtextstream.h>
+#include <qtimer.h>
 #include <QtGui/QPrinter>
 #include <QtGui/QPainter>
 
@@ -428,7 +431,7 @@ PDFGenerator::PDFGenerator( QObject *parent, const QVariantList &args )
     docInfoDirty( true ), docSynopsisDirty( true ),
     docEmbeddedFilesDirty( true ), nextFontPage( 0 ),
     dpiX( 72.0 /*Okular::Utils::dpiX()*/ ), dpiY( 72.0 /*Okular::Utils::dpiY()*/ ),
-    annotProxy( 0 ), synctex_scanner( 0 )
+    annotProxy( 0 ), nextMetadataPage( 0 ), synctex_scanner( 0 )
 {
     setFeature( Threaded );
     setFeature( TextExtraction );
@@ -442,12 +445,19 @@ PDFGenerator::PDFGenerator( QObject *parent, const QVariantList &args )
         setFeature( PrintToFile );
     setFeature( ReadRawData );
     setFeature( TiledRendering );
+    // pages are rendered from the instances of documentPool, as many as
+    // the pages rendered at once (see reparseConfig())
+    setFeature( ThreadSafe );
 
 #ifdef HAVE_POPPLER_0_16
     // You only need to do it once not for each of the documents but it is cheap enough
     // so doing it all the time won't hurt either
     Poppler::setDebugErrorFunction(PDFGeneratorPopplerDebugFunction, QVariant());
 #endif
+
+    metadataTimer = new QTimer( this );
+    metadataTimer->setSingleShot( true );
+    connect( metadataTimer, SIGNAL(timeout()), this, SLOT(loadNextPagesMetadata()) );
 }
 
 PDFGenerator::~PDFGenerator()
@@ -470,6 +480,8 @@ bool PDFGenerator::loadDocument( const QString & filePath, QVector<Okular::Page*
     bool success = init(pagesVector, filePath.section('/', -1, -1));
     if (success)
     {
+        documentPool.setSource( filePath, QByteArray(), documentPassword, pdfdoc->numPages() );
+
         // no need to check for the existence of a synctex file, no parser will be
         // created if none exists
         initSynctexParser(filePath);
@@ -492,11 +504,16 @@ bool PDFGenerator::loadDocumentFromData( const QByteArray & fileData, QVector<Ok
 #endif
     // create PDFDoc for the given file
     pdfdoc = Poppler::Document::loadFromData( fileData, 0, 0 );
-    return init(pagesVector, QString());
+    bool success = init(pagesVector, QString());
+    if (success)
+        documentPool.setSource( QString(), fileData, documentPassword, pdfdoc->numPages() );
+    return success;
 }
 
 bool PDFGenerator::init(QVector<Okular::Page*> & pagesVector, const QString &walletKey)
 {
+    documentPassword.clear();
+
     // if the file didn't open correctly it might be encrypted, so ask for a pass
     bool firstInput = true;
     bool triedWallet = false;
@@ -552,6 +569,7 @@ bool PDFGenerator::init(QVector<Okular::Page*> & pagesVector, const QString &wal
 
         // 2. reopen the document using the password
         pdfdoc->unlock( password.toLatin1(), password.toLatin1() );
+        documentPassword = password.toLatin1();
 
         // 3. if the password is correct and the user chose to remember it, store it to the wallet
         if ( !pdfdoc->isLocked() && wallet && /*safety check*/ wallet->isOpen() && keep )
@@ -569,12 +587,19 @@ bool PDFGenerator::init(QVector<Okular::Page*> & pagesVector, const QString &wal
     // build Pages (currentPage was set -1 by deletePages)
     uint pageCount = pdfdoc->numPages();
     pagesVector.resize(pageCount);
-    rectsGenerated.fill(false, pageCount);
+    rectsGenerated.fill(0, pageCount);
+    metadataLoaded.fill(false, pageCount);
 
     annotationsHash.clear();
 
     loadPages(pagesVector, 0, false);
 
+    // the annotations, transitions and actions of the pages are loaded when
+    // the pages are rendered for the first time, and in the background
+    metadataPages = pagesVector;
+    nextMetadataPage = 0;
+    metadataTimer->start( 0 );
+
     // update the configuration
     reparseConfig();
 
@@ -587,7 +612,10 @@ bool PDFGenerator::init(QVector<Okular::Page*> & pagesVector, const QString &wal
 
 bool PDFGenerator::doCloseDocument()
 {
+    metadataTimer->stop();
+
     // remove internal objects
+    documentPool.clear();
     userMutex()->lock();
     delete annotProxy;
     annotProxy = 0;
@@ -602,6 +630,9 @@ bool PDFGenerator::doCloseDocument()
     docEmbeddedFiles.clear();
     nextFontPage = 0;
     rectsGenerated.clear();
+    metadataLoaded.clear();
+    metadataPages.clear();
+    urgentMetadataPages.clear();
     if ( synctex_scanner )
     {
         synctex_scanner_free( synctex_scanner );
@@ -615,6 +646,14 @@ void PDFGenerator::loadPages(QVector<Okular::Page*> &pagesVector, int rotation,
 {
     // TODO XPDF 3.01 check
     const int count = pagesVector.count();
+#ifdef HAVE_POPPLER_0_22
+    // the form widgets are created when the document is set up, and the
+    // saved contents of the forms are restored right after loading, so the
+    // form fields can not be loaded later; only skip them without a form
+    const bool hasFormFields = pdfdoc->formType() != Poppler::Document::NoForm;
+#else
+    const bool hasFormFields = true;
+#endif
     double w = 0, h = 0;
     for ( int i = 0; i < count ; i++ )
     {
@@ -636,25 +675,14 @@ void PDFGenerator::loadPages(QVector<Okular::Page*> &pagesVector, int rotation,
             }
             if (rotation % 2 == 1)
             qSwap(w,h);
-            // init a Okular::page, add transition and annotation information
+            // init a Okular::page, the transition, annotations and actions
+            // are added by loadPageMetadata()
             page = new Okular::Page( i, w, h, orientation );
-            addTransition( p, page );
-            if ( true ) //TODO real check
-            addAnnotations( p, page );
-            Poppler::Link * tmplink = p->action( Poppler::Page::Opening );
-            if ( tmplink )
-            {
-                page->setPageAction( Okular::Page::Opening, createLinkFromPopplerLink( tmplink ) );
-            }
-            tmplink = p->action( Poppler::Page::Closing );
-            if ( tmplink )
-            {
-                page->setPageAction( Okular::Page::Closing, createLinkFromPopplerLink( tmplink ) );
-            }
             page->setDuration( p->duration() );
             page->setLabel( p->label() );
 
-            addFormFields( p, page );
+            if ( hasFormFields )
+                addFormFields( p, page );
 //        kWarning(PDFDebug).nospace() << page->width() << "x" << page->height();
 
 #ifdef PDFGENERATOR_DEBUG
@@ -668,12 +696,85 @@ void PDFGenerator::loadPages(QVector<Okular::Page*> &pagesVector, int rotation,
         else
         {
             page = new Okular::Page( i, defaultPageWidth, defaultPageHeight, Okular::Rotation0 );
+            metadataLoaded.setBit( i );
         }
         // set the Okular::page at the right position in document's pages vector
         pagesVector[i] = page;
     }
 }
 
+bool PDFGenerator::loadPageMetadata( int page, bool wait )
+{
+    if ( metadataLoaded.testBit( page ) )
+        return true;
+
+    if ( wait )
+        userMutex()->lock();
+    else if ( !userMutex()->tryLock() )
+        return false;
+
+    Okular::Page * okularPage = metadataPages[ page ];
+    Poppler::Page * p = pdfdoc->page( page );
+    if ( p )
+    {
+        addTransition( p, okularPage );
+        addAnnotations( p, okularPage );
+        Poppler::Link * tmplink = p->action( Poppler::Page::Opening );
+        if ( tmplink )
+        {
+            okularPage->setPageAction( Okular::Page::Opening, createLinkFromPopplerLink( tmplink ) );
+        }
+        tmplink = p->action( Poppler::Page::Closing );
+        if ( tmplink )
+        {
+            okularPage->setPageAction( Okular::Page::Closing, createLinkFromPopplerLink( tmplink ) );
+        }
+        delete p;
+    }
+    metadataLoaded.setBit( page );
+
+    // the page may have been rendered already, without the annotations
+    // the media links refer to
+    if ( rectsGenerated.at( page ) )
+        resolveMediaLinkReferences( okularPage );
+
+    userMutex()->unlock();
+
+    // the page may be shown already, and its opening actions are to be
+    // performed now
+    if ( !okularPage->annotations().isEmpty() || okularPage->pageAction( Okular::Page::Opening ) )
+        updatePageAnnotations( page );
+
+    return true;
+}
+
+void PDFGenerator::loadNextPagesMetadata()
+{
+    // load for some milliseconds at a time to keep the user interface
+    // responsive, and wait for the next round when a page is being rendered
+    QTime time;
+    time.start();
+    const int count = metadataLoaded.size();
+    bool busy = false;
+    while ( ( !urgentMetadataPages.isEmpty() || nextMetadataPage < count ) && time.elapsed() < 20 )
+    {
+        // the pages asked for a pixmap first
+        const bool urgent = !urgentMetadataPages.isEmpty();
+        if ( !loadPageMetadata( urgent ? urgentMetadataPages.first() : nextMetadataPage, false ) )
+        {
+            busy = true;
+            break;
+        }
+        if ( urgent )
+            urgentMetadataPages.removeFirst();
+        else
+            ++nextMetadataPage;
+    }
+
+    if ( !urgentMetadataPages.isEmpty() || nextMetadataPage < count )
+        metadataTimer->start( busy ? 50 : 0 );
+}
+
 const Okular::DocumentInfo * PDFGenerator::generateDocumentInfo()
 {
     if ( docInfoDirty )
@@ -891,6 +992,23 @@ bool PDFGenerator::isAllowed( Okular::Permission permission ) const
     return b;
 }
 
+void PDFGenerator::generatePixmap( Okular::PixmapRequest * request )
+{
+    // the annotations and actions of the page are needed now, but waiting
+    // for a page being rendered would block the user interface: then they
+    // are loaded by the timer before the other pages
+    const int pageNumber = request->pageNumber();
+    if ( !loadPageMetadata( pageNumber, false ) )
+    {
+        urgentMetadataPages.removeAll( pageNumber );
+        urgentMetadataPages.prepend( pageNumber );
+        if ( !metadataTimer->isActive() )
+            metadataTimer->start( 50 );
+    }
+
+    Okular::Generator::generatePixmap( request );
+}
+
 QImage PDFGenerator::image( Okular::PixmapRequest * request )
 {
     // debug requests to this (xpdf) generator
@@ -908,17 +1026,70 @@ QImage PDFGenerator::image( Okular::PixmapRequest * request )
     double fakeDpiX = request->width() * dpiX / pageWidth,
            fakeDpiY = request->height() * dpiY / pageHeight;
 
-    // generate links rects only the first time
+    // generate links rects only the first time; read without the lock, so
+    // generateObjectRects() checks it again
     bool genObjectRects = !rectsGenerated.at( page->number() );
 
+    // the pages with changed annotations or with forms render right only
+    // from the main document, the others can be rendered from an instance
+    // of the pool at the same time as other pages
+    Poppler::Document *renderDocument = 0;
+    if ( page->formFields().isEmpty() && !( annotProxy && annotProxy->isPageModified( page->number() ) ) )
+        renderDocument = documentPool.acquire();
+
+    QImage img;
+    if ( renderDocument )
+    {
+        if ( request->shouldAbortRender() )
+        {
+            documentPool.release( renderDocument );
+            return QImage();
+        }
+
+        Poppler::Page *p = renderDocument->page( page->number() );
+        img = renderPage( p, request, fakeDpiX, fakeDpiY );
+        delete p;
+        documentPool.release( renderDocument );
+
+        if ( genObjectRects )
+        {
+            userMutex()->lock();
+            generateObjectRects( page );
+            userMutex()->unlock();
+        }
+
+        return img;
+    }
+
     // 0. LOCK [waits for the thread end]
     userMutex()->lock();
 
+    // the request may have been cancelled while we were waiting for the lock;
+    // poppler-qt4 can not interrupt a render, so this is the last chance
+    if ( request->shouldAbortRender() )
+    {
+        userMutex()->unlock();
+        return QImage();
+    }
+
     // 1. Set OutputDev parameters and Generate contents
-    // note: thread safety is set on 'false' for the GUI (this) thread
     Poppler::Page *p = pdfdoc->page(page->number());
 
     // 2. Take data from outputdev and attach it to the Page
+    img = renderPage( p, request, fakeDpiX, fakeDpiY );
+    delete p;
+
+    if ( genObjectRects )
+        generateObjectRects( page );
+
+    // 3. UNLOCK [re-enables shared access]
+    userMutex()->unlock();
+
+    return img;
+}
+
+QImage PDFGenerator::renderPage( Poppler::Page *p, Okular::PixmapRequest *request, double fakeDpiX, double fakeDpiY )
+{
     QImage img;
     if (p)
     {
@@ -937,24 +1108,29 @@ QImage PDFGenerator::image( Okular::PixmapRequest * request )
         img = QImage( request->width(), request->height(), QImage::Format_Mono );
         img.fill( Qt::white );
     }
+    return img;
+}
 
-    if ( p && genObjectRects )
-    {
-        // TODO previously we extracted Image type rects too, but that needed porting to poppler
-        // and as we are not doing anything with Image type rects i did not port it, have a look at
-        // dead gp_outputdev.cpp on image extraction
-        page->setObjectRects( generateLinks(p->links()) );
-        rectsGenerated[ request->page()->number() ] = true;
+void PDFGenerator::generateObjectRects( Okular::Page *page )
+// called with the MUTEX locked
+{
+    // another thread may have rendered the same page meanwhile
+    if ( rectsGenerated.at( page->number() ) )
+        return;
 
-        resolveMediaLinkReferences( page );
-    }
+    Poppler::Page *p = pdfdoc->page( page->number() );
+    if ( !p )
+        return;
 
-    // 3. UNLOCK [re-enables shared access]
-    userMutex()->unlock();
+    // TODO previously we extracted Image type rects too, but that needed porting to poppler
+    // and as we are not doing anything with Image type rects i did not port it, have a look at
+    // dead gp_outputdev.cpp on image extraction
+    page->setObjectRects( generateLinks(p->links()) );
+    rectsGenerated[ page->number() ].fetchAndStoreRelease( 1 );
 
-    delete p;
+    resolveMediaLinkReferences( page );
 
-    return img;
+    delete p;
 }
 
 template <typename PopplerLinkType, typename OkularLinkType, typename PopplerAnnotationType, typename OkularAnnotationType>
@@ -1037,15 +1213,21 @@ Okular::TextPage* PDFGenerator::textPage( Okular::Page *page )
 #ifdef PDFGENERATOR_DEBUG
     kDebug(PDFDebug) << "page" << page->number();
 #endif
+    // the text does not change with the annotations and the forms, so
+    // extract it from an instance of the pool when possible, without
+    // waiting for the pages being rendered from the main document; the
+    // pool keeps an instance for the rendering meanwhile
+    Poppler::Document *textDocument = documentPool.acquire( PopplerDocumentPool::TextExtraction );
+    if ( !textDocument )
+        userMutex()->lock();
+
     // build a TextList...
     QList<Poppler::TextBox*> textList;
     double pageWidth, pageHeight;
-    Poppler::Page *pp = pdfdoc->page( page->number() );
+    Poppler::Page *pp = ( textDocument ? textDocument : pdfdoc )->page( page->number() );
     if (pp)
     {
-        userMutex()->lock();
         textList = pp->textList();
-        userMutex()->unlock();
 
         QSizeF s = pp->pageSizeF();
         pageWidth = s.width();
@@ -1059,6 +1241,11 @@ Okular::TextPage* PDFGenerator::textPage( Okular::Page *page )
         pageHeight = defaultPageHeight;
     }
 
+    if ( textDocument )
+        documentPool.release( textDocument );
+    else
+        userMutex()->unlock();
+
     Okular::TextPage *tp = abstractTextPage(textList, pageHeight, pageWidth, (Poppler::Page::Rotation)page->orientation());
     qDeleteAll(textList);
     return tp;
@@ -1249,6 +1436,10 @@ QVariant PDFGenerator::metaData( const QString & key, const QVariant & option )
         QMutexLocker ml(userMutex());
         return pdfdoc->scripts();
     }
+    else if ( key == "RenderSettings" )
+    {
+        return QString::fromLatin1( "EnhanceThinLines=%1" ).arg( PDFSettings::enhanceThinLines() );
+    }
     else if ( key == "HasUnsupportedXfaForm" )
     {
 #ifdef HAVE_POPPLER_0_22
@@ -1281,6 +1472,9 @@ bool PDFGenerator::reparseConfig()
     }
     bool aaChanged = setDocumentRenderHints();
     somethingchanged = somethingchanged || aaChanged;
+    documentPool.setRenderSettings( pdfdoc->renderHints(), pdfdoc->paperColor() );
+    // as many instances as pages rendered at once, they are full documents
+    documentPool.setMaxDocuments( maxConcurrentPixmapRequests() );
     return somethingchanged;
 }
 
@@ -1482,8 +1676,20 @@ void PDFGenerator::addAnnotations( Poppler::Page * popplerPage, Okular::Page * p
     // Reverse the list so that the z-order of Poppler/PDF matches the z-order used by Okular
     std::reverse(popplerAnnotations.begin(), popplerAnnotations.end());
 
+    // the annotations are loaded after the document is opened: the ones
+    // restored from the local metadata meanwhile are already in the page
+    QSet<QString> existingNames;
+    foreach(Okular::Annotation *annotation, page->annotations())
+        existingNames.insert( annotation->uniqueName() );
+
     foreach(Poppler::Annotation *a, popplerAnnotations)
     {
+        if ( !a->uniqueName().isEmpty() && existingNames.contains( a->uniqueName() ) )
+        {
+            delete a;
+            continue;
+        }
+
         bool doDelete = true;
         Okular::Annotation * newann = createAnnotationFromPopplerAnnotation( a, &doDelete );
         if (newann)
@@ -1536,7 +1742,7 @@ void PDFGenerator::addAnnotations( Poppler::Page * popplerPage, Okular::Page * p
 }
 
 void PDFGenerator::addTransition( Poppler::Page * pdfPage, Okular::Page * page )
-// called on opening when MUTEX is not used
+// called by loadPageMetadata() with the MUTEX locked
 {
     Poppler::PageTransition *pdfTransition = pdfPage->transition();
     if ( !pdfTransition || pdfTransition->type() == Poppler::PageTransition::Replace )
@@ -14,11 +14,15 @@
 #define UNSTABLE_POPPLER_QT4
 
 #include "synctex/synctex_parser.h"
+#include "popplerdocumentpool.h"
 
 #include <poppler-qt4.h>
 
+#include <qatomic.h>
 #include <qbitarray.h>
+#include <qlist.h>
 #include <qpointer.h>
+#include <qvector.h>
 
 #include <core/document.h>
 #include <core/generator.h>
@@ -33,6 +37,7 @@ class SourceReference;
 
 class PDFOptionsPage;
 class PopplerAnnotationProxy;
+class QTimer;
 
 /**
  * @short A generator that builds contents from a PDF document.
@@ -74,6 +79,7 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
         bool isAllowed( Okular::Permission permission ) const;
 
         // [INHERITED] perform actions on document / pages
+        void generatePixmap( Okular::PixmapRequest *request );
         QImage image( Okular::PixmapRequest *page );
 
         // [INHERITED] print page using an already configured kprinter
@@ -107,6 +113,10 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
         const Okular::SourceReference * dynamicSourceReference( int pageNr, double absX, double absY );
         Okular::Generator::PrintError printError() const;
 
+    private slots:
+        // load the annotations, transitions, actions of the pages in the background
+        void loadNextPagesMetadata();
+
     private:
         bool init(QVector<Okular::Page*> & pagesVector, const QString &walletKey);
 
@@ -118,6 +128,9 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
         void addTransition( Poppler::Page * popplerPage, Okular::Page * page );
         // fetch the form fields and add them to the page
         void addFormFields( Poppler::Page * popplerPage, Okular::Page * page );
+        // fetch the annotations, transition and actions of the page if not
+        // done yet; returns false if the document is busy and wait is false
+        bool loadPageMetadata( int page, bool wait );
         // load the source references from a pdfsync file
         void loadPdfSync( const QString & fileName, QVector<Okular::Page*> & pagesVector );
         // init the synctex parser if a synctex file exists
@@ -125,6 +138,11 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
         // search document for source reference
         void fillViewportFromSourceReference( Okular::DocumentViewport & viewport, const QString & reference ) const;
 
+        // render the page as asked by the request, or a blank image if there is no page
+        QImage renderPage( Poppler::Page *p, Okular::PixmapRequest *request, double fakeDpiX, double fakeDpiY );
+        // generate the object rects of the page from the main document; called with the MUTEX locked
+        void generateObjectRects( Okular::Page *page );
+
         Okular::TextPage * abstractTextPage(const QList<Poppler::TextBox*> &text, double height, double width, int rot);
 
         void resolveMediaLinkReferences( Okular::Page *page );
@@ -134,6 +152,9 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
 
         // poppler dependant stuff
         Poppler::Document *pdfdoc;
+        // instances of the document to render and extract text in parallel
+        PopplerDocumentPool documentPool;
+        QByteArray documentPassword;
 
 
         // misc variables for document info and synopsis caching
@@ -149,7 +170,15 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
         PopplerAnnotationProxy *annotProxy;
         QHash<Okular::Annotation*, Poppler::Annotation*> annotationsHash;
 
-        QBitArray rectsGenerated;
+        // per page, read by the rendering threads without the MUTEX
+        QVector<QAtomicInt> rectsGenerated;
+        // the pages whose annotations, transition and actions are loaded
+        QBitArray metadataLoaded;
+        QVector<Okular::Page*> metadataPages;
+        // the pages asked for a pixmap while the document was busy
+        QList<int> urgentMetadataPages;
+        int nextMetadataPage;
+        QTimer *metadataTimer;
 
         QPointer<PDFOptionsPage> pdfOptionsPage;
         
@@ -0,0 +1,237 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "popplerdocumentpool.h"
+
+#include <kdebug.h>
+#include <kde_file.h>
+
+#include "generator_pdf.h"
+
+static Poppler::Document* loadDocument( const QString &fileName, const QByteArray &data, const QByteArray &password )
+{
+    Poppler::Document *document = fileName.isEmpty()
+        ? Poppler::Document::loadFromData( data, password, password )
+        : Poppler::Document::load( fileName, password, password );
+    if ( document && document->isLocked() )
+    {
+        delete document;
+        document = 0;
+    }
+    return document;
+}
+
+static void applyRenderSettings( Poppler::Document *document, Poppler::Document::RenderHints hints, const QColor &paperColor )
+{
+    if ( document->paperColor() != paperColor )
+        document->setPaperColor( paperColor );
+
+    const Poppler::Document::RenderHints currentHints = document->renderHints();
+    for ( int bit = 0; bit < 31; ++bit )
+    {
+        const Poppler::Document::RenderHint hint = static_cast< Poppler::Document::RenderHint >( 1 << bit );
+        if ( hints.testFlag( hint ) != currentHints.testFlag( hint ) )
+            document->setRenderHint( hint, hints.testFlag( hint ) );
+    }
+}
+
+PopplerDocumentPool::FileIdentity::FileIdentity()
+    : device( -1 ), inode( -1 ), size( -1 ), modified( -1 )
+{
+}
+
+bool PopplerDocumentPool::FileIdentity::operator==( const FileIdentity &other ) const
+{
+    return device == other.device && inode == other.inode && size == other.size && modified == other.modified;
+}
+
+PopplerDocumentPool::FileIdentity PopplerDocumentPool::fileIdentity( const QString &fileName )
+{
+    FileIdentity identity;
+    KDE_struct_stat buf;
+    if ( KDE::stat( fileName, &buf ) == 0 )
+    {
+        identity.device = buf.st_dev;
+        identity.inode = buf.st_ino;
+        identity.size = buf.st_size;
+        identity.modified = buf.st_mtime;
+    }
+    return identity;
+}
+
+PopplerDocumentPool::PopplerDocumentPool()
+    : m_count( 0 ), m_maxDocuments( 0 ), m_pageCount( 0 ), m_paperColor( Qt::white ), m_loadFailed( false )
+{
+}
+
+PopplerDocumentPool::~PopplerDocumentPool()
+{
+    clear();
+}
+
+void PopplerDocumentPool::setSource( const QString &fileName, const QByteArray &data, const QByteArray &password, int pageCount )
+{
+    clear();
+
+    const FileIdentity identity = fileName.isEmpty() ? FileIdentity() : fileIdentity( fileName );
+
+    QMutexLocker locker( &m_mutex );
+    m_fileName = fileName;
+    m_data = data;
+    m_password = password;
+    m_pageCount = pageCount;
+    m_fileIdentity = identity;
+    // without an identity the file can not be told from another one
+    m_loadFailed = !fileName.isEmpty() && identity.inode == -1;
+}
+
+void PopplerDocumentPool::setMaxDocuments( int maxDocuments )
+{
+    QMutexLocker locker( &m_mutex );
+    m_maxDocuments = maxDocuments;
+
+    // the instances in use over the maximum go when released
+    while ( m_count > m_maxDocuments && !m_idle.isEmpty() )
+    {
+        delete m_idle.takeLast();
+        --m_count;
+    }
+}
+
+int PopplerDocumentPool::maxDocuments() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_maxDocuments;
+}
+
+void PopplerDocumentPool::setRenderSettings( Poppler::Document::RenderHints hints, const QColor &paperColor )
+{
+    QMutexLocker locker( &m_mutex );
+    m_hints = hints;
+    m_paperColor = paperColor;
+}
+
+Poppler::Document* PopplerDocumentPool::acquire( Usage usage )
+{
+    QMutexLocker locker( &m_mutex );
+    Poppler::Document *document = 0;
+    while ( !document )
+    {
+        if ( m_loadFailed || ( m_fileName.isEmpty() && m_data.isEmpty() ) )
+            return 0;
+
+        if ( usage == TextExtraction && m_textDocuments.count() >= m_maxDocuments - 1 )
+        {
+            // leave an instance for the rendering
+            if ( m_maxDocuments <= 1 )
+                return 0;
+
+            m_released.wait( &m_mutex );
+        }
+        else if ( !m_idle.isEmpty() )
+        {
+            document = m_idle.takeLast();
+        }
+        else if ( m_count < m_maxDocuments )
+        {
+            // load outside of the lock, the other threads can take the
+            // instances released meanwhile
+            ++m_count;
+            const QString fileName = m_fileName;
+            const QByteArray data = m_data;
+            const QByteArray password = m_password;
+            const int pageCount = m_pageCount;
+            const FileIdentity identity = m_fileIdentity;
+            locker.unlock();
+            // the file is checked before and after the load, not to load
+            // another document when it was replaced since the main one was
+            bool changed = !fileName.isEmpty() && !( fileIdentity( fileName ) == identity );
+            if ( !changed )
+            {
+                document = loadDocument( fileName, data, password );
+                changed = document && ( document->numPages() != pageCount
+                    || ( !fileName.isEmpty() && !( fileIdentity( fileName ) == identity ) ) );
+                if ( changed )
+                {
+                    delete document;
+                    document = 0;
+                }
+            }
+            locker.relock();
+
+            if ( !document )
+            {
+                if ( changed )
+                    kWarning(PDFGenerator::PDFDebug) << "The document changed since it was opened, not loading other instances of it";
+                else
+                    kWarning(PDFGenerator::PDFDebug) << "Could not load another instance of the document";
+                --m_count;
+                m_loadFailed = true;
+                m_released.wakeAll();
+                return 0;
+            }
+        }
+        else if ( m_count == 0 )
+        {
+            // the pool is disabled
+            return 0;
+        }
+        else
+        {
+            m_released.wait( &m_mutex );
+        }
+    }
+
+    if ( usage == TextExtraction )
+        m_textDocuments.insert( document );
+
+    const Poppler::Document::RenderHints hints = m_hints;
+    const QColor paperColor = m_paperColor;
+    locker.unlock();
+
+    applyRenderSettings( document, hints, paperColor );
+    return document;
+}
+
+void PopplerDocumentPool::release( Poppler::Document *document )
+{
+    QMutexLocker locker( &m_mutex );
+    m_textDocuments.remove( document );
+    if ( m_count > m_maxDocuments )
+    {
+        // the maximum was lowered meanwhile
+        delete document;
+        --m_count;
+        m_released.wakeAll();
+        return;
+    }
+
+    m_idle.append( document );
+    // wakes clear() as well as the threads waiting for an instance
+    m_released.wakeAll();
+}
+
+void PopplerDocumentPool::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    // no other instance is loaded from now on
+    m_fileName.clear();
+    m_data.clear();
+    m_password.clear();
+
+    // the instances in use, or being loaded, are deleted once released
+    while ( m_idle.count() < m_count )
+        m_released.wait( &m_mutex );
+
+    qDeleteAll( m_idle );
+    m_idle.clear();
+    m_count = 0;
+}
+
+/* kate: replace-tabs on; indent-width 4; */
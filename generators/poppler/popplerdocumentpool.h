@@ -0,0 +1,131 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_GENERATOR_PDF_DOCUMENTPOOL_H_
+#define _OKULAR_GENERATOR_PDF_DOCUMENTPOOL_H_
+
+#include <poppler-qt4.h>
+
+#include <qbytearray.h>
+#include <qcolor.h>
+#include <qlist.h>
+#include <qmutex.h>
+#include <qset.h>
+#include <qstring.h>
+#include <qwaitcondition.h>
+
+/**
+ * Additional instances of the open document, so that several threads can
+ * render pages and extract their text at the same time.
+ *
+ * A Poppler::Document can not be used by two threads at once, but two
+ * documents loaded from the same file are independent. The instances are
+ * loaded from the same file or the same data as the main document when a
+ * thread needs one and all the others are in use, up to a maximum; then
+ * the threads wait for an instance to be released.
+ *
+ * The instances do not see the changes made to the main document, like the
+ * annotations added to its pages or the contents of its forms. The pool
+ * disables itself when the file is not the one of the main document any
+ * more, as when it is overwritten while open.
+ *
+ * At least one instance is always left for the rendering: the text
+ * extraction can hold all the instances but one.
+ */
+class PopplerDocumentPool
+{
+    public:
+        /**
+         * What an instance is acquired for.
+         */
+        enum Usage
+        {
+            Rendering,       ///< Rendering a page
+            TextExtraction   ///< Extracting the text of a page
+        };
+
+        PopplerDocumentPool();
+        ~PopplerDocumentPool();
+
+        /**
+         * Sets where the instances are loaded from: the file @p fileName,
+         * or the @p data if the file name is empty. The instances are
+         * unlocked with @p password and must have @p pageCount pages, as
+         * the main document. Deletes the previous instances.
+         *
+         * The file must be the one the main document was just loaded from.
+         */
+        void setSource( const QString &fileName, const QByteArray &data, const QByteArray &password, int pageCount );
+
+        /**
+         * Sets the maximum number of instances; 0 disables the pool.
+         */
+        void setMaxDocuments( int maxDocuments );
+        int maxDocuments() const;
+
+        /**
+         * Sets the render hints and the paper color the instances render
+         * with, as the ones of the main document.
+         */
+        void setRenderSettings( Poppler::Document::RenderHints hints, const QColor &paperColor );
+
+        /**
+         * Returns an instance for the exclusive use of the calling thread,
+         * until it gives it back with release(). Waits if all the instances
+         * available for @p usage are in use; returns 0 if the pool is
+         * disabled, if the document can not be loaded again, or for the
+         * TextExtraction when the pool can not spare an instance.
+         */
+        Poppler::Document* acquire( Usage usage = Rendering );
+        void release( Poppler::Document *document );
+
+        /**
+         * Deletes all the instances, waiting for the ones in use to be
+         * released first.
+         */
+        void clear();
+
+    private:
+        struct FileIdentity
+        {
+            FileIdentity();
+            bool operator==( const FileIdentity &other ) const;
+
+            qint64 device;
+            qint64 inode;
+            qint64 size;
+            qint64 modified;
+        };
+
+        static FileIdentity fileIdentity( const QString &fileName );
+
+        mutable QMutex m_mutex;
+        QWaitCondition m_released;
+        QList<Poppler::Document*> m_idle;
+        // the instances in use for the TextExtraction
+        QSet<Poppler::Document*> m_textDocuments;
+        // the instances loaded, idle or in use
+        int m_count;
+        int m_maxDocuments;
+        QString m_fileName;
+        QByteArray m_data;
+        QByteArray m_password;
+        int m_pageCount;
+        // the file of the main document, when it was loaded
+        FileIdentity m_fileIdentity;
+        Poppler::Document::RenderHints m_hints;
+        QColor m_paperColor;
+        // whether a load failed or the file changed, not to try again for
+        // every page
+        bool m_loadFailed;
+};
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
@@ -315,6 +315,10 @@ QVariant GSGenerator::metaData(const QString &key, const QVariant &option) const
         if (title)
             return QString::fromAscii(title);
     }
+    else if (key == "RenderSettings")
+    {
+        return QString::fromLatin1("PlatformFonts=%1").arg(GSSettings::platformFonts());
+    }
     return QVariant();
 }
 
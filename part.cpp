@@ -1119,6 +1119,12 @@ QString Part::documentMetaData( const QString &metaData ) const
 }
 
 
+QString Part::renderStatistics() const
+{
+    return m_document->metaData( "RenderStatistics" ).toString();
+}
+
+
 bool Part::slotImportPSFile()
 {
     QString app = KStandardDirs::findExe( "ps2pdf" );
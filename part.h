@@ -139,6 +139,7 @@ class OKULAR_PART_EXPORT Part : public KParts::ReadWritePart, public Okular::Doc
         Q_SCRIPTABLE uint currentPage();
         Q_SCRIPTABLE QString currentDocument();
         Q_SCRIPTABLE QString documentMetaData( const QString &metaData ) const;
+        Q_SCRIPTABLE QString renderStatistics() const;
         Q_SCRIPTABLE void slotPreferences();
         Q_SCRIPTABLE void slotFind();
         Q_SCRIPTABLE void slotPrintPreview();
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include <kmimetype.h>
+
+#include "../core/document.h"
+#include "../core/generator.h"
+#include "../core/observer.h"
+#include "../core/page.h"
+#include "../settings_core.h"
+
+// Observer standing for the page view, with no widget
+class PixmapObserver : public Okular::DocumentObserver
+{
+};
+
+class DocumentOpenTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void testFirstPixmap();
+        void benchmarkOpenToFirstPixmap_data();
+        void benchmarkOpenToFirstPixmap();
+};
+
+// opens the document and renders its first page synchronously, like the
+// page view does when showing a document for the first time
+static bool openAndRenderFirstPage( Okular::Document *document, PixmapObserver *observer, const QString &fileName )
+{
+    const KMimeType::Ptr mime = KMimeType::findByPath( fileName );
+    if ( !document->openDocument( fileName, KUrl(), mime ) )
+        return false;
+
+    QLinkedList< Okular::PixmapRequest * > requests;
+    requests << new Okular::PixmapRequest( observer, 0, 200, 200, 1, Okular::PixmapRequest::NoFeature );
+    document->requestPixmaps( requests );
+    return document->page( 0 )->hasPixmap( observer );
+}
+
+void DocumentOpenTest::initTestCase()
+{
+    Okular::SettingsCore::instance( "documentopentest" );
+}
+
+void DocumentOpenTest::testFirstPixmap()
+{
+    Okular::Document document( 0 );
+    PixmapObserver observer;
+    document.addObserver( &observer );
+
+    QVERIFY( openAndRenderFirstPage( &document, &observer, KDESRCDIR "data/file1.pdf" ) );
+    QVERIFY( document.pages() > 0 );
+
+    // let the rest of the data of the pages load in the background, closing
+    // the document must stop it
+    QTest::qWait( 100 );
+    document.closeDocument();
+    QTest::qWait( 100 );
+    document.removeObserver( &observer );
+}
+
+void DocumentOpenTest::benchmarkOpenToFirstPixmap_data()
+{
+    QTest::addColumn<QString>( "file" );
+
+    QTest::newRow( "file1" ) << KDESRCDIR "data/file1.pdf";
+    QTest::newRow( "tocreload" ) << KDESRCDIR "data/tocreload.pdf";
+}
+
+void DocumentOpenTest::benchmarkOpenToFirstPixmap()
+{
+    QFETCH( QString, file );
+
+    Okular::Document document( 0 );
+    PixmapObserver observer;
+    document.addObserver( &observer );
+
+    QBENCHMARK
+    {
+        QVERIFY( openAndRenderFirstPage( &document, &observer, file ) );
+        document.closeDocument();
+    }
+
+    document.removeObserver( &observer );
+}
+
+QTEST_KDEMAIN( DocumentOpenTest, GUI )
+
+#include "documentopentest.moc"
@@ -0,0 +1,149 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "../core/generator.h"
+#include "../core/observer.h"
+#include "../core/pixmapcache_p.h"
+
+// Observer that refuses to unload the pixmaps of the pages in a range,
+// like PageView does for the visible pages
+class RangeObserver : public Okular::DocumentObserver
+{
+    public:
+        RangeObserver( int first = -1, int last = -1 )
+            : m_first( first ), m_last( last )
+        {
+        }
+
+        bool canUnloadPixmap( int page ) const
+        {
+            return page < m_first || page > m_last;
+        }
+
+        int m_first;
+        int m_last;
+};
+
+class PixmapCacheTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void testFarthest();
+        void testQueueOrder();
+        void benchmarkEviction();
+};
+
+void PixmapCacheTest::testFarthest()
+{
+    RangeObserver pageView( 40, 60 );
+    RangeObserver thumbnails;
+    Okular::AllocatedPixmapIndex index;
+
+    for ( int page = 0; page < 100; ++page )
+        index.insert( new Okular::AllocatedPixmap( &pageView, page, 1 ) );
+    for ( int page = 45; page < 55; ++page )
+        index.insert( new Okular::AllocatedPixmap( &thumbnails, page, 1 ) );
+    QCOMPARE( index.count(), 110 );
+
+    // replacing a descriptor does not grow the index
+    index.insert( new Okular::AllocatedPixmap( &thumbnails, 50, 2 ) );
+    QCOMPARE( index.count(), 110 );
+
+    Okular::AllocatedPixmap *p = index.farthestFrom( 10, false );
+    QCOMPARE( p->page, 99 );
+    p = index.farthestFrom( 90, false );
+    QCOMPARE( p->page, 0 );
+    p = index.farthestFrom( 50, false, &thumbnails );
+    QCOMPARE( p->page, 45 );
+
+    // only the pages outside [40, 60] can be unloaded
+    for ( int page = 0; page < 100; ++page )
+    {
+        if ( page < 40 || page > 60 )
+            delete index.take( &pageView, page );
+    }
+    p = index.farthestFrom( 0, true, &pageView );
+    QVERIFY( !p );
+    p = index.farthestFrom( 0, true );
+    QCOMPARE( p->observer, static_cast< Okular::DocumentObserver * >( &thumbnails ) );
+    QCOMPARE( p->page, 54 );
+
+    const QList< Okular::AllocatedPixmap * > taken = index.takeAll( &thumbnails );
+    QCOMPARE( taken.count(), 10 );
+    qDeleteAll( taken );
+    QCOMPARE( index.count(), 21 );
+}
+
+void PixmapCacheTest::testQueueOrder()
+{
+    RangeObserver observer;
+    Okular::PixmapRequestQueue queue;
+
+    Okular::PixmapRequest *preload1 = new Okular::PixmapRequest( &observer, 1, 100, 100, 3, Okular::PixmapRequest::Asynchronous );
+    Okular::PixmapRequest *preload2 = new Okular::PixmapRequest( &observer, 2, 100, 100, 3, Okular::PixmapRequest::Asynchronous );
+    Okular::PixmapRequest *visible1 = new Okular::PixmapRequest( &observer, 3, 100, 100, 0, Okular::PixmapRequest::Asynchronous );
+    Okular::PixmapRequest *visible2 = new Okular::PixmapRequest( &observer, 4, 100, 100, 0, Okular::PixmapRequest::Asynchronous );
+    queue.push( preload1 );
+    queue.push( visible1 );
+    queue.push( preload2 );
+    queue.push( visible2 );
+    QCOMPARE( queue.count(), 4 );
+    QCOMPARE( queue.requests( &observer ).count(), 4 );
+
+    // zero priority requests are LIFO, the others FIFO
+    QCOMPARE( queue.top(), visible2 );
+    QVERIFY( queue.remove( visible2 ) );
+    QCOMPARE( queue.top(), visible1 );
+    QVERIFY( queue.remove( visible1 ) );
+    QCOMPARE( queue.top(), preload1 );
+    QVERIFY( queue.remove( preload1 ) );
+    QVERIFY( !queue.remove( preload1 ) );
+    QCOMPARE( queue.top(), preload2 );
+
+    const QList< Okular::PixmapRequest * > remaining = queue.takeAll();
+    QCOMPARE( remaining.count(), 1 );
+    QVERIFY( queue.isEmpty() );
+    QVERIFY( !queue.top() );
+
+    delete preload1;
+    delete preload2;
+    delete visible1;
+    delete visible2;
+}
+
+void PixmapCacheTest::benchmarkEviction()
+{
+    RangeObserver pageView( 4990, 5010 );
+    RangeObserver thumbnails( 4980, 5020 );
+    Okular::AllocatedPixmapIndex index;
+    for ( int page = 0; page < 5000; ++page )
+    {
+        index.insert( new Okular::AllocatedPixmap( &pageView, page * 2, 1 ) );
+        index.insert( new Okular::AllocatedPixmap( &thumbnails, page * 2 + 1, 1 ) );
+    }
+    QCOMPARE( index.count(), 10000 );
+
+    // evict the farthest pixmap and allocate it again near the viewport, the
+    // typical pattern while scrolling through a big document
+    const int currentPage = 5000;
+    QBENCHMARK {
+        Okular::AllocatedPixmap *p = index.farthestFrom( currentPage, true );
+        QVERIFY( p );
+        index.take( p->observer, p->page );
+        p->page = currentPage + ( p->page < currentPage ? -1 : 1 ) * ( 25 + p->page % 7 );
+        index.insert( p );
+    }
+}
+
+QTEST_KDEMAIN( PixmapCacheTest, GUI )
+
+#include "pixmapcachetest.moc"
@@ -37,6 +37,7 @@ class SearchTest : public QObject
     private slots:
         void initTestCase();
         void test311232();
+        void testMatchesFound();
 };
 
 void SearchTest::initTestCase()
@@ -77,6 +78,40 @@ void SearchTest::test311232()
     QCOMPARE(receiver.m_status, Okular::Document::NoMatchFound);
 }
 
+void SearchTest::testMatchesFound()
+{
+    Okular::SettingsCore::instance( "searchtest" );
+    Okular::Document d(0);
+    QSignalSpy finishedSpy(&d, SIGNAL(searchFinished(int,Okular::Document::SearchStatus)));
+    QSignalSpy matchesSpy(&d, SIGNAL(searchMatchesFound(int,int,int,int)));
+
+    const QString testFile = KDESRCDIR "data/file1.pdf";
+    const KMimeType::Ptr mime = KMimeType::findByPath( testFile );
+    d.openDocument(testFile, KUrl(), mime);
+
+    const int searchId = 0;
+    d.searchText(searchId, "i", true, Qt::CaseSensitive, Okular::Document::AllDocument, false, QColor(Qt::yellow), true);
+    QTime t;
+    t.start();
+    while (finishedSpy.count() != 1 && t.elapsed() < 5000)
+        qApp->processEvents();
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(finishedSpy.at(0).at(1).value<Okular::Document::SearchStatus>(), Okular::Document::MatchFound);
+
+    // the matches are reported page by page before the end of the search,
+    // with the running count of the matches
+    QVERIFY(matchesSpy.count() > 0);
+    int totalMatches = 0;
+    for (int i = 0; i < matchesSpy.count(); ++i)
+    {
+        const QList<QVariant> args = matchesSpy.at(i);
+        QCOMPARE(args.at(0).toInt(), searchId);
+        QVERIFY(args.at(2).toInt() > 0);
+        totalMatches += args.at(2).toInt();
+        QCOMPARE(args.at(3).toInt(), totalMatches);
+    }
+}
+
 QTEST_KDEMAIN( SearchTest, GUI )
 
 #include "searchtest.moc"
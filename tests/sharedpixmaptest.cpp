@@ -0,0 +1,126 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include <QtGui/QPixmap>
+
+#include <kmimetype.h>
+
+#include "../core/document.h"
+#include "../core/generator.h"
+#include "../core/observer.h"
+#include "../core/page.h"
+#include "../settings_core.h"
+
+class PixmapObserver : public Okular::DocumentObserver
+{
+};
+
+class SharedPixmapTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void init();
+        void cleanup();
+        void testSameSize();
+        void testSmallerSize();
+        void testBiggerSize();
+
+    private:
+        void render( PixmapObserver *observer, int width, int height, Okular::PixmapRequest::PixmapRequestFeatures features );
+
+        Okular::Document *m_document;
+        PixmapObserver *m_pageView;
+        PixmapObserver *m_thumbnails;
+        int m_width;
+        int m_height;
+};
+
+void SharedPixmapTest::initTestCase()
+{
+    Okular::SettingsCore::instance( "sharedpixmaptest" );
+    // the pixmaps must come from the generator or from the other observer
+    Okular::SettingsCore::setDiskPixmapCache( false );
+}
+
+void SharedPixmapTest::init()
+{
+    m_document = new Okular::Document( 0 );
+    m_pageView = new PixmapObserver;
+    m_thumbnails = new PixmapObserver;
+    m_document->addObserver( m_pageView );
+    m_document->addObserver( m_thumbnails );
+
+    const QString fileName = KDESRCDIR "data/file1.pdf";
+    const KMimeType::Ptr mime = KMimeType::findByPath( fileName );
+    QVERIFY( m_document->openDocument( fileName, KUrl(), mime ) );
+
+    const Okular::Page *page = m_document->page( 0 );
+    m_width = 600;
+    m_height = qRound( m_width * page->ratio() );
+
+    // the page view renders the page first
+    render( m_pageView, m_width, m_height, Okular::PixmapRequest::NoFeature );
+    QVERIFY( page->hasPixmap( m_pageView, m_width, m_height ) );
+}
+
+void SharedPixmapTest::cleanup()
+{
+    m_document->closeDocument();
+    m_document->removeObserver( m_thumbnails );
+    m_document->removeObserver( m_pageView );
+    delete m_thumbnails;
+    delete m_pageView;
+    delete m_document;
+}
+
+void SharedPixmapTest::render( PixmapObserver *observer, int width, int height, Okular::PixmapRequest::PixmapRequestFeatures features )
+{
+    QLinkedList< Okular::PixmapRequest * > requests;
+    requests << new Okular::PixmapRequest( observer, 0, width, height, 1, features );
+    m_document->requestPixmaps( requests, Okular::Document::NoOption );
+}
+
+void SharedPixmapTest::testSameSize()
+{
+    render( m_thumbnails, m_width, m_height, Okular::PixmapRequest::NoFeature );
+
+    // the pixel data is shared, not copied
+    const Okular::Page *page = m_document->page( 0 );
+    QVERIFY( page->hasPixmap( m_thumbnails, m_width, m_height ) );
+    QCOMPARE( page->_o_nearestPixmap( m_thumbnails, m_width, m_height )->cacheKey(),
+              page->_o_nearestPixmap( m_pageView, m_width, m_height )->cacheKey() );
+}
+
+void SharedPixmapTest::testSmallerSize()
+{
+    const int width = m_width / 4;
+    const int height = qRound( width * m_document->page( 0 )->ratio() );
+
+    // an asynchronous render would only be delivered through the event loop:
+    // the pixmap is there at once because it was scaled from the page view
+    render( m_thumbnails, width, height, Okular::PixmapRequest::Asynchronous );
+    QVERIFY( m_document->page( 0 )->hasPixmap( m_thumbnails, width, height ) );
+}
+
+void SharedPixmapTest::testBiggerSize()
+{
+    // a pixmap can not be scaled up, the generator renders it
+    render( m_thumbnails, m_width * 2, m_height * 2, Okular::PixmapRequest::Asynchronous );
+    QVERIFY( !m_document->page( 0 )->hasPixmap( m_thumbnails, m_width * 2, m_height * 2 ) );
+
+    QTRY_VERIFY( m_document->page( 0 )->hasPixmap( m_thumbnails, m_width * 2, m_height * 2 ) );
+}
+
+QTEST_KDEMAIN( SharedPixmapTest, GUI )
+
+#include "sharedpixmaptest.moc"
@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include <ktempdir.h>
+
+#include "../core/textindex_p.h"
+
+class TextIndexTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void testMayContain();
+        void testSaveLoad();
+
+    private:
+        Okular::TextIndex createIndex() const;
+};
+
+Okular::TextIndex TextIndexTest::createIndex() const
+{
+    Okular::TextIndex index;
+    index.addPage( 0, "The quick brown fox\n" );
+    index.addPage( 1, "jumps over the hyph-\nenated Lazy dog.\n" );
+    index.addPage( 2, QString() );
+    index.addPage( 3, QString::fromUtf8( "An e\xef\xac\x83" "cient \xc3\x89t\xc3\xa9 3.14\n" ) );
+    return index;
+}
+
+void TextIndexTest::testMayContain()
+{
+    Okular::TextIndex index;
+    QVERIFY( !index.isValid() );
+    QVERIFY( index.mayContain( 0, "fox" ) );
+
+    index = createIndex();
+    QVERIFY( index.isValid() );
+    QCOMPARE( index.pageCount(), 4 );
+
+    // parts of words
+    QVERIFY( index.mayContain( 0, "uic" ) );
+    QVERIFY( !index.mayContain( 1, "uic" ) );
+    QVERIFY( !index.mayContain( 2, "uic" ) );
+
+    // several words, the first and the last can be cut
+    QVERIFY( index.mayContain( 0, "ick brown fo" ) );
+    QVERIFY( !index.mayContain( 0, "ick bro fox" ) );
+    QVERIFY( !index.mayContain( 0, "qui brown" ) );
+    QVERIFY( !index.mayContain( 0, "brown ox" ) );
+    QVERIFY( index.mayContain( 1, "over the" ) );
+    QVERIFY( !index.mayContain( 0, "over the" ) );
+
+    // hyphenated words, both joined and not
+    QVERIFY( index.mayContain( 1, "hyphenated" ) );
+    QVERIFY( index.mayContain( 1, "hyph-" ) );
+    QVERIFY( index.mayContain( 1, "enated lazy" ) );
+
+    // case and normalization
+    QVERIFY( index.mayContain( 1, "LAZY" ) );
+    QVERIFY( index.mayContain( 3, "efficient" ) );
+    QVERIFY( index.mayContain( 3, QString::fromUtf8( "\xc3\xa9t\xc3\xa9" ) ) );
+    QVERIFY( index.mayContain( 3, "3.1" ) );
+
+    // texts without words cannot restrict the search
+    QVERIFY( index.mayContain( 2, "..." ) );
+}
+
+void TextIndexTest::testSaveLoad()
+{
+    KTempDir dir;
+    const QString fileName = dir.name() + "test.index";
+    QVERIFY( createIndex().save( fileName, "key" ) );
+
+    Okular::TextIndex index;
+    QVERIFY( !index.load( fileName, "other key", 4 ) );
+    QVERIFY( !index.isValid() );
+    QVERIFY( !index.load( fileName, "key", 5 ) );
+    QVERIFY( index.load( fileName, "key", 4 ) );
+    QVERIFY( index.mayContain( 1, "hyphenated" ) );
+    QVERIFY( !index.mayContain( 0, "hyphenated" ) );
+}
+
+QTEST_KDEMAIN( TextIndexTest, GUI )
+
+#include "textindextest.moc"
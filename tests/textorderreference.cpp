@@ -0,0 +1,719 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+/*
+ * The text ordering of TextPage as it was before being rewritten on index
+ * arrays, kept as the reference of the rewrite. The code is the same, only
+ * the entities are stored by value instead of in TinyTextEntity pointers.
+ */
+
+#include "textorderreference.h"
+
+#include <QtCore/QMap>
+#include <QtCore/QRect>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/QtAlgorithms>
+
+using namespace Okular;
+
+namespace {
+
+struct TinyTextEntity
+{
+    TinyTextEntity( const QString &t, const NormalizedRect &rect )
+        : text( t ), area( rect )
+    {
+    }
+
+    QString text;
+    NormalizedRect area;
+};
+typedef QList< TinyTextEntity > TextList;
+
+struct WordWithCharacters
+{
+    WordWithCharacters( const TinyTextEntity &w, const TextList &c )
+        : word( w ), characters( c )
+    {
+    }
+
+    inline QString text() const
+    {
+        return word.text;
+    }
+
+    inline const NormalizedRect &area() const
+    {
+        return word.area;
+    }
+
+    TinyTextEntity word;
+    TextList characters;
+};
+typedef QList< WordWithCharacters > WordsWithCharacters;
+
+class RegionText
+{
+    public:
+        RegionText()
+        {
+        }
+
+        RegionText( const WordsWithCharacters &wordsWithCharacters, const QRect &area )
+            : m_region_wordWithCharacters( wordsWithCharacters ), m_area( area )
+        {
+        }
+
+        inline WordsWithCharacters text() const
+        {
+            return m_region_wordWithCharacters;
+        }
+
+        inline QRect area() const
+        {
+            return m_area;
+        }
+
+        inline void setArea( const QRect &area )
+        {
+            m_area = area;
+        }
+
+        inline void setText( const WordsWithCharacters &wordsWithCharacters )
+        {
+            m_region_wordWithCharacters = wordsWithCharacters;
+        }
+
+    private:
+        WordsWithCharacters m_region_wordWithCharacters;
+        QRect m_area;
+};
+typedef QList< RegionText > RegionTextList;
+
+bool doesConsumeY( const QRect& first, const QRect& second, int threshold )
+{
+    // if one consumes another fully
+    if(first.top() <= second.top() && first.bottom() >= second.bottom())
+        return true;
+
+    if(first.top() >= second.top() && first.bottom() <= second.bottom())
+        return true;
+
+    // or if there is overlap of space by more than 80%
+    // there is overlap
+    if(second.bottom() >= first.top() && first.bottom() >= second.top())
+    {
+        const int overlap = (second.bottom() >= first.bottom()) ? first.bottom() - second.top()
+                                                                : second.bottom() - first.top();
+        //we will divide by the smaller rectangle to calculate the overlap
+        const int percentage = (first.width() < second.width()) ? overlap * 100 / (first.bottom() - first.top())
+                                                                : overlap * 100 / (second.bottom() - second.top());
+
+        if(percentage >= threshold) return true;
+    }
+
+    return false;
+}
+
+bool compareTinyTextEntityX(const WordWithCharacters &first, const WordWithCharacters &second)
+{
+    QRect firstArea = first.area().roundedGeometry(1000,1000);
+    QRect secondArea = second.area().roundedGeometry(1000,1000);
+
+    return firstArea.left() < secondArea.left();
+}
+
+bool compareTinyTextEntityY(const WordWithCharacters &first, const WordWithCharacters &second)
+{
+    const QRect firstArea = first.area().roundedGeometry(1000,1000);
+    const QRect secondArea = second.area().roundedGeometry(1000,1000);
+
+    return firstArea.top() < secondArea.top();
+}
+
+TextList charactersWithoutSpace(const TextList &words)
+{
+    TextList characters;
+    const QLatin1String str(" ");
+    foreach (const TinyTextEntity &word, words)
+    {
+        if (word.text != str)
+            characters.append(word);
+    }
+    return characters;
+}
+
+WordsWithCharacters makeWordFromCharacters(const TextList &characters, int pageWidth, int pageHeight)
+{
+    WordsWithCharacters wordsWithCharacters;
+
+    TextList::ConstIterator it = characters.begin(), itEnd = characters.end(), tmpIt;
+    int newLeft,newRight,newTop,newBottom;
+
+    for( ; it != itEnd ; it++)
+    {
+        QString textString = (*it).text;
+        QString newString;
+        QRect lineArea = (*it).area.roundedGeometry(pageWidth,pageHeight),elementArea;
+        TextList wordCharacters;
+        tmpIt = it;
+        int space = 0;
+
+        while (!space)
+        {
+            if (textString.length())
+            {
+                newString.append(textString);
+
+                // when textString is the start of the word
+                if (tmpIt == it)
+                {
+                    NormalizedRect newRect(lineArea,pageWidth,pageHeight);
+                    wordCharacters.append(TinyTextEntity(textString.normalized
+                                                   (QString::NormalizationForm_KC), newRect));
+                }
+                else
+                {
+                    NormalizedRect newRect(elementArea,pageWidth,pageHeight);
+                    wordCharacters.append(TinyTextEntity(textString.normalized
+                                                   (QString::NormalizationForm_KC), newRect));
+                }
+            }
+
+            ++it;
+
+            /*
+             we must have to put this line before the if condition of it==itEnd
+             otherwise the last character can be missed
+             */
+            if (it == itEnd) break;
+            elementArea = (*it).area.roundedGeometry(pageWidth,pageHeight);
+            if (!doesConsumeY(elementArea, lineArea, 60))
+            {
+                --it;
+                break;
+            }
+
+            const int text_y1 = elementArea.top() ,
+                      text_x1 = elementArea.left(),
+                      text_y2 = elementArea.y() + elementArea.height(),
+                      text_x2 = elementArea.x() + elementArea.width();
+            const int line_y1 = lineArea.top() ,line_x1 = lineArea.left(),
+                      line_y2 = lineArea.y() + lineArea.height(),
+                      line_x2 = lineArea.x() + lineArea.width();
+
+            space = elementArea.left() - lineArea.right();
+
+            if (space != 0)
+            {
+                it--;
+                break;
+            }
+
+            newLeft = text_x1 < line_x1 ? text_x1 : line_x1;
+            newRight = line_x2 > text_x2 ? line_x2 : text_x2;
+            newTop = text_y1 > line_y1 ? line_y1 : text_y1;
+            newBottom = text_y2 > line_y2 ? text_y2 : line_y2;
+
+            lineArea.setLeft (newLeft);
+            lineArea.setTop (newTop);
+            lineArea.setWidth( newRight - newLeft );
+            lineArea.setHeight( newBottom - newTop );
+
+            textString = (*it).text;
+        }
+
+        // if newString is not empty, save it
+        if (!newString.isEmpty())
+        {
+            const NormalizedRect newRect(lineArea, pageWidth, pageHeight);
+            wordsWithCharacters.append(WordWithCharacters(TinyTextEntity(newString.normalized(QString::NormalizationForm_KC), newRect), wordCharacters));
+        }
+
+        if(it == itEnd) break;
+    }
+
+    return wordsWithCharacters;
+}
+
+QList< QPair<WordsWithCharacters, QRect> > makeAndSortLines(const WordsWithCharacters &wordsTmp, int pageWidth, int pageHeight)
+{
+    QList< QPair<WordsWithCharacters, QRect> > lines;
+
+    QList<WordWithCharacters> words = wordsTmp;
+
+    // Step 1
+    qSort(words.begin(),words.end(),compareTinyTextEntityY);
+
+    // Step 2
+    QList<WordWithCharacters>::Iterator it = words.begin(), itEnd = words.end();
+
+    //for every non-space texts(characters/words) in the textList
+    for( ; it != itEnd ; it++)
+    {
+        const QRect elementArea = (*it).area().roundedGeometry(pageWidth,pageHeight);
+        bool found = false;
+
+        for( int i = 0 ; i < lines.length() ; i++)
+        {
+            QRect &lineArea = lines[i].second;
+            const int text_y1 = elementArea.top() ,
+                      text_y2 = elementArea.top() + elementArea.height() ,
+                      text_x1 = elementArea.left(),
+                      text_x2 = elementArea.left() + elementArea.width();
+            const int line_y1 = lineArea.top() ,
+                      line_y2 = lineArea.top() + lineArea.height(),
+                      line_x1 = lineArea.left(),
+                      line_x2 = lineArea.left() + lineArea.width();
+
+            if(doesConsumeY(elementArea,lineArea,70))
+            {
+                WordsWithCharacters &line = lines[i].first;
+                line.append(*it);
+
+                const int newLeft = line_x1 < text_x1 ? line_x1 : text_x1;
+                const int newRight = line_x2 > text_x2 ? line_x2 : text_x2;
+                const int newTop = line_y1 < text_y1 ? line_y1 : text_y1;
+                const int newBottom = text_y2 > line_y2 ? text_y2 : line_y2;
+
+                lineArea = QRect( newLeft,newTop, newRight - newLeft, newBottom - newTop );
+                found = true;
+            }
+
+            if(found) break;
+        }
+
+        if(!found)
+        {
+            WordsWithCharacters tmp;
+            tmp.append((*it));
+            lines.append(QPair<WordsWithCharacters, QRect>(tmp, elementArea));
+        }
+    }
+
+    // Step 3
+    for(int i = 0 ; i < lines.length() ; i++)
+    {
+        WordsWithCharacters &list = lines[i].first;
+        qSort(list.begin(), list.end(), compareTinyTextEntityX);
+    }
+
+    return lines;
+}
+
+void calculateStatisticalInformation(const QList<WordWithCharacters> &words, int pageWidth, int pageHeight, int *word_spacing, int *line_spacing, int *col_spacing)
+{
+    const QList< QPair<WordsWithCharacters, QRect> > sortedLines = makeAndSortLines(words, pageWidth, pageHeight);
+
+    QMap<int,int> line_space_stat;
+    for(int i = 0 ; i < sortedLines.length(); i++)
+    {
+        const QRect rectUpper = sortedLines.at(i).second;
+
+        if(i+1 == sortedLines.length()) break;
+        const QRect rectLower = sortedLines.at(i+1).second;
+
+        int linespace = rectLower.top() - (rectUpper.top() + rectUpper.height());
+        if(linespace < 0) linespace =-linespace;
+
+        if(line_space_stat.contains(linespace))
+            line_space_stat[linespace]++;
+        else line_space_stat[linespace] = 1;
+    }
+
+    *line_spacing = 0;
+    int weighted_count = 0;
+    QMapIterator<int, int> iterate_linespace(line_space_stat);
+
+    while(iterate_linespace.hasNext())
+    {
+        iterate_linespace.next();
+        *line_spacing += iterate_linespace.value() * iterate_linespace.key();
+        weighted_count += iterate_linespace.value();
+    }
+    if (*line_spacing != 0)
+        *line_spacing = (int) ( (double)*line_spacing / (double) weighted_count + 0.5);
+
+    QMap<int,int> hor_space_stat;
+    QMap<int,int> col_space_stat;
+
+    for(int i = 0 ; i < sortedLines.length() ; i++)
+    {
+        const WordsWithCharacters list = sortedLines.at(i).first;
+        int maxSpace = 0, minSpace = pageWidth;
+
+        WordsWithCharacters::ConstIterator it = list.begin(), itEnd = list.end();
+
+        for( ; it != itEnd ; it++ )
+        {
+            const QRect area1 = (*it).area().roundedGeometry(pageWidth,pageHeight);
+            if( it+1 == itEnd ) break;
+
+            const QRect area2 = (*(it+1)).area().roundedGeometry(pageWidth,pageHeight);
+            int space = area2.left() - area1.right();
+
+            if(space > maxSpace)
+                maxSpace = space;
+
+            if(space < minSpace && space != 0) minSpace = space;
+
+            if(space != 0 && space != pageWidth)
+            {
+                if(hor_space_stat.contains(space)) hor_space_stat[space] = hor_space_stat[space]++;
+                else hor_space_stat[space] = 1;
+            }
+        }
+
+        if(hor_space_stat.contains(maxSpace))
+        {
+            if(hor_space_stat[maxSpace] != 1)
+                hor_space_stat[maxSpace] = hor_space_stat[maxSpace]--;
+            else hor_space_stat.remove(maxSpace);
+        }
+
+        if(maxSpace != 0)
+        {
+            if (col_space_stat.contains(maxSpace))
+                col_space_stat[maxSpace] = col_space_stat[maxSpace]++;
+            else col_space_stat[maxSpace] = 1;
+        }
+    }
+
+    *word_spacing = 0;
+    weighted_count = 0;
+    QMapIterator<int, int> iterate(hor_space_stat);
+
+    while (iterate.hasNext())
+    {
+        iterate.next();
+
+        if(iterate.key() > 0)
+        {
+            *word_spacing += iterate.value() * iterate.key();
+            weighted_count += iterate.value();
+        }
+    }
+    if(weighted_count)
+        *word_spacing = (int) ((double)*word_spacing / (double)weighted_count + 0.5);
+
+    *col_spacing = 0;
+    QMapIterator<int, int> iterate_col(col_space_stat);
+
+    while (iterate_col.hasNext())
+    {
+        iterate_col.next();
+        if(iterate_col.value() > *col_spacing) *col_spacing = iterate_col.value();
+    }
+    *col_spacing = col_space_stat.key(*col_spacing);
+
+    if(sortedLines.length() == 1)
+        *word_spacing = *col_spacing;
+}
+
+RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wordsWithCharacters, const NormalizedRect &boundingBox, int pageWidth, int pageHeight)
+{
+    RegionTextList tree;
+    QRect contentRect(boundingBox.geometry(pageWidth,pageHeight));
+    const RegionText root(wordsWithCharacters, contentRect);
+
+    tree.push_back(root);
+
+    int i = 0;
+
+    while(i < tree.length())
+    {
+        const RegionText node = tree.at(i);
+        QRect regionRect = node.area();
+
+        int size_proj_y = node.area().height();
+        int size_proj_x = node.area().width();
+        QVarLengthArray<int> proj_on_xaxis(size_proj_x);
+        QVarLengthArray<int> proj_on_yaxis(size_proj_y);
+
+        for( int j = 0 ; j < size_proj_y ; ++j ) proj_on_yaxis[j] = 0;
+        for( int j = 0 ; j < size_proj_x ; ++j ) proj_on_xaxis[j] = 0;
+
+        const QList<WordWithCharacters> list = node.text();
+
+        int word_spacing, line_spacing, column_spacing;
+        calculateStatisticalInformation(list, pageWidth, pageHeight, &word_spacing, &line_spacing, &column_spacing);
+
+        const int tcx = word_spacing * 2;
+        const int tcy = line_spacing * 2;
+
+        int maxX = 0 , maxY = 0;
+        int avgX = 0;
+        int count;
+
+        for(int j = 0 ; j < list.length() ; ++j )
+        {
+            const QRect entRect = list.at(j).area().geometry(pageWidth, pageHeight);
+
+            for(int k = entRect.left() ; k <= entRect.left() + entRect.width() ; ++k)
+            {
+                if( ( k-regionRect.left() ) < size_proj_x && ( k-regionRect.left() ) >= 0 )
+                    proj_on_xaxis[k - regionRect.left()] += entRect.height();
+            }
+
+            for(int k = entRect.top() ; k <= entRect.top() + entRect.height() ; ++k)
+            {
+                if( ( k-regionRect.top() ) < size_proj_y && ( k-regionRect.top() ) >= 0 )
+                    proj_on_yaxis[k - regionRect.top()] += entRect.width();
+            }
+        }
+
+        for( int j = 0 ; j < size_proj_y ; ++j )
+        {
+            if (proj_on_yaxis[j] > maxY)
+                maxY = proj_on_yaxis[j];
+        }
+
+        avgX = count = 0;
+        for( int j = 0 ; j < size_proj_x ; ++j )
+        {
+            if(proj_on_xaxis[j] > maxX) maxX = proj_on_xaxis[j];
+            if(proj_on_xaxis[j])
+            {
+                count++;
+                avgX+= proj_on_xaxis[j];
+            }
+        }
+        if(count) avgX /= count;
+
+        int xbegin = 0, xend = size_proj_x - 1;
+        int ybegin = 0, yend = size_proj_y - 1;
+        while(xbegin < size_proj_x && proj_on_xaxis[xbegin] <= 0)
+            xbegin++;
+        while(xend >= 0 && proj_on_xaxis[xend] <= 0)
+            xend--;
+        while(ybegin < size_proj_y && proj_on_yaxis[ybegin] <= 0)
+            ybegin++;
+        while(yend >= 0 && proj_on_yaxis[yend] <= 0)
+            yend--;
+
+        int old_left = regionRect.left(), old_top = regionRect.top();
+        regionRect.setLeft(old_left + xbegin);
+        regionRect.setRight(old_left + xend);
+        regionRect.setTop(old_top + ybegin);
+        regionRect.setBottom(old_top + yend);
+
+        int tnx = (int)((double)avgX * 10.0 / 100.0 + 0.5), tny = 0;
+        for( int j = 0 ; j < size_proj_x ; ++j )
+            proj_on_xaxis[j] -= tnx;
+        for( int j = 0 ; j < size_proj_y ; ++j )
+            proj_on_yaxis[j] -= tny;
+
+        int gap_hor = -1, pos_hor = -1;
+        int begin = -1, end = -1;
+
+        for(int j = 1 ; j < size_proj_y ; ++j)
+        {
+            if(begin >= 0 && proj_on_yaxis[j-1] <= 0
+                    && proj_on_yaxis[j] > 0)
+                end = j;
+
+            if(proj_on_yaxis[j-1] > 0 && proj_on_yaxis[j] <= 0)
+                begin = j;
+
+            if(begin > 0 && end > 0 && end-begin > gap_hor)
+            {
+                gap_hor = end - begin;
+                pos_hor = (end + begin) / 2;
+                begin = -1;
+                end = -1;
+            }
+        }
+
+        begin = -1, end = -1;
+        int gap_ver = -1, pos_ver = -1;
+
+        for(int j = 1 ; j < size_proj_x ; ++j)
+        {
+            if(begin >= 0 && proj_on_xaxis[j-1] <= 0
+                    && proj_on_xaxis[j] > 0){
+                end = j;
+            }
+
+            if(proj_on_xaxis[j-1] > 0 && proj_on_xaxis[j] <= 0)
+                begin = j;
+
+            if(begin > 0 && end > 0 && end-begin > gap_ver)
+            {
+                gap_ver = end - begin;
+                pos_ver = (end + begin) / 2;
+                begin = -1;
+                end = -1;
+            }
+        }
+
+        int cut_pos_x = pos_ver, cut_pos_y = pos_hor;
+        int gap_x = gap_ver, gap_y = gap_hor;
+
+        bool cut_hor = false, cut_ver = false;
+
+        const int topHeight = cut_pos_y - (regionRect.top() - old_top);
+        const QRect topRect(regionRect.left(),
+                            regionRect.top(),
+                            regionRect.width(),
+                            topHeight);
+        const QRect bottomRect(regionRect.left(),
+                               regionRect.top() + topHeight,
+                               regionRect.width(),
+                               regionRect.height() - topHeight );
+
+        const int leftWidth = cut_pos_x - (regionRect.left() - old_left);
+        const QRect leftRect(regionRect.left(),
+                             regionRect.top(),
+                             leftWidth,
+                             regionRect.height());
+        const QRect rightRect(regionRect.left() + leftWidth,
+                              regionRect.top(),
+                              regionRect.width() - leftWidth,
+                              regionRect.height());
+
+        if(gap_y >= gap_x && gap_y >= tcy)
+            cut_hor = true;
+        else if(gap_y >= gap_x && gap_y <= tcy && gap_x >= tcx)
+            cut_ver = true;
+        else if(gap_x >= gap_y && gap_x >= tcx)
+            cut_ver = true;
+        else if(gap_x >= gap_y && gap_x <= tcx && gap_y >= tcy)
+            cut_hor = true;
+        else
+        {
+            RegionText tmpNode = tree.at(i);
+            tmpNode.setArea(regionRect);
+            tree.replace(i,tmpNode);
+            i++;
+            continue;
+        }
+
+        WordsWithCharacters list1,list2;
+
+        if(cut_hor)
+        {
+            for( int j = 0 ; j < list.length() ; ++j )
+            {
+                const WordWithCharacters word = list.at(j);
+                const QRect wordRect = word.area().geometry(pageWidth,pageHeight);
+
+                if(topRect.intersects(wordRect))
+                    list1.append(word);
+                else
+                    list2.append(word);
+            }
+
+            RegionText node1(list1,topRect);
+            RegionText node2(list2,bottomRect);
+
+            tree.replace(i,node1);
+            tree.insert(i+1,node2);
+        }
+        else if(cut_ver)
+        {
+            for( int j = 0 ; j < list.length() ; ++j )
+            {
+                const WordWithCharacters word = list.at(j);
+                const QRect wordRect = word.area().geometry(pageWidth,pageHeight);
+
+                if(leftRect.intersects(wordRect))
+                    list1.append(word);
+                else
+                    list2.append(word);
+            }
+
+            RegionText node1(list1,leftRect);
+            RegionText node2(list2,rightRect);
+
+            tree.replace(i,node1);
+            tree.insert(i+1,node2);
+        }
+    }
+
+    return tree;
+}
+
+WordsWithCharacters addNecessarySpace(RegionTextList tree, int pageWidth, int pageHeight)
+{
+    for(int j = 0 ; j < tree.length() ; j++)
+    {
+        RegionText &tmpRegion = tree[j];
+
+        QList< QPair<WordsWithCharacters, QRect> > sortedLines = makeAndSortLines(tmpRegion.text(), pageWidth, pageHeight);
+
+        for(int i = 0 ; i < sortedLines.length() ; i++)
+        {
+            WordsWithCharacters &list = sortedLines[i].first;
+            for(int k = 0 ; k < list.length() ; k++ )
+            {
+                const QRect area1 = list.at(k).area().roundedGeometry(pageWidth,pageHeight);
+                if( k+1 >= list.length() ) break;
+
+                const QRect area2 = list.at(k+1).area().roundedGeometry(pageWidth,pageHeight);
+                const int space = area2.left() - area1.right();
+
+                if(space != 0)
+                {
+                    const int left = area1.right();
+                    const int right = area2.left();
+                    const int top = area2.top() < area1.top() ? area2.top() : area1.top();
+                    const int bottom = area2.bottom() > area1.bottom() ? area2.bottom() : area1.bottom();
+
+                    const QString spaceStr(" ");
+                    const QRect rect(QPoint(left,top),QPoint(right,bottom));
+                    const NormalizedRect entRect(rect,pageWidth,pageHeight);
+                    WordWithCharacters word(TinyTextEntity(spaceStr, entRect), TextList() << TinyTextEntity(spaceStr, entRect));
+
+                    list.insert(k+1, word);
+
+                    k++;
+                }
+            }
+        }
+
+        WordsWithCharacters tmpList;
+        for(int i = 0 ; i < sortedLines.length() ; i++)
+        {
+            tmpList += sortedLines.at(i).first;
+        }
+        tmpRegion.setText(tmpList);
+    }
+
+    WordsWithCharacters tmp;
+    for(int i = 0 ; i < tree.length() ; i++)
+    {
+        tmp += tree.at(i).text();
+    }
+    return tmp;
+}
+
+}
+
+QList< TextOrderReference::Entity > TextOrderReference::correctTextOrder( const TextEntity::List &entities, int pageWidth, int pageHeight, const NormalizedRect &boundingBox )
+{
+    TextList words;
+    foreach ( const TextEntity *entity, entities )
+    {
+        if ( !entity->text().isEmpty() )
+            words.append( TinyTextEntity( entity->text().normalized( QString::NormalizationForm_KC ), *entity->area() ) );
+    }
+
+    const TextList characters = charactersWithoutSpace(words);
+    const QList<WordWithCharacters> wordsWithCharacters = makeWordFromCharacters(characters, pageWidth, pageHeight);
+    const RegionTextList tree = XYCutForBoundingBoxes(wordsWithCharacters, boundingBox, pageWidth, pageHeight);
+    const WordsWithCharacters listWithWordsAndSpaces = addNecessarySpace(tree, pageWidth, pageHeight);
+
+    QList< Entity > result;
+    foreach ( const WordWithCharacters &word, listWithWordsAndSpaces )
+    {
+        foreach ( const TinyTextEntity &character, word.characters )
+            result.append( Entity( character.text, character.area ) );
+    }
+    return result;
+}
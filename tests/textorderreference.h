@@ -0,0 +1,36 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef OKULAR_TEXTORDERREFERENCE_H
+#define OKULAR_TEXTORDERREFERENCE_H
+
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+
+#include "../core/area.h"
+#include "../core/textpage.h"
+
+namespace TextOrderReference
+{
+    typedef QPair< QString, Okular::NormalizedRect > Entity;
+
+    /**
+     * Orders the text @p entities of a page of @p pageWidth x @p pageHeight
+     * pixels with the given @p boundingBox, the way TextPage did before its
+     * ordering was rewritten on index arrays, and returns the ordered text
+     * entities, spaces included.
+     *
+     * The entities are taken as the TextPage constructor keeps them: the
+     * empty ones are skipped and the others are normalized.
+     */
+    QList< Entity > correctTextOrder( const Okular::TextEntity::List &entities, int pageWidth, int pageHeight, const Okular::NormalizedRect &boundingBox );
+}
+
+#endif
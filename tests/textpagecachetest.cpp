@@ -0,0 +1,80 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "../core/textpagecache_p.h"
+
+class TextPageCacheTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void testEvict();
+        void testStatistics();
+};
+
+void TextPageCacheTest::testEvict()
+{
+    Okular::TextPageCache cache;
+    cache.setMaxMemory( 1000 );
+    cache.insert( 0, 400 );
+    cache.insert( 1, 400 );
+    QVERIFY( cache.evict().isEmpty() );
+    QCOMPARE( cache.totalMemory(), Q_UINT64_C( 800 ) );
+
+    // the least recently used page goes first, not the first inserted
+    QVERIFY( cache.use( 0 ) );
+    cache.insert( 2, 400 );
+    QCOMPARE( cache.evict( 2 ), QList< int >() << 1 );
+    QVERIFY( cache.contains( 0 ) && cache.contains( 2 ) && !cache.contains( 1 ) );
+
+    // a page bigger than the whole cache does not evict itself
+    cache.insert( 3, 2000 );
+    QCOMPARE( cache.evict( 3 ), QList< int >() << 0 << 2 );
+    QCOMPARE( cache.count(), 1 );
+    QCOMPARE( cache.totalMemory(), Q_UINT64_C( 2000 ) );
+
+    // replacing a page accounts the new memory only
+    cache.insert( 3, 100 );
+    QCOMPARE( cache.totalMemory(), Q_UINT64_C( 100 ) );
+
+    // a text growing is accounted in place, the pages not there are ignored
+    cache.setMemory( 3, 300 );
+    cache.setMemory( 4, 300 );
+    QCOMPARE( cache.totalMemory(), Q_UINT64_C( 300 ) );
+    QVERIFY( !cache.contains( 4 ) );
+
+    cache.clear();
+    QCOMPARE( cache.count(), 0 );
+    QCOMPARE( cache.totalMemory(), Q_UINT64_C( 0 ) );
+}
+
+void TextPageCacheTest::testStatistics()
+{
+    Okular::TextPageCache cache;
+    cache.setMaxMemory( 1000 );
+    QVERIFY( !cache.use( 0 ) );
+    cache.insert( 0, 10 );
+    QVERIFY( cache.use( 0 ) );
+    QVERIFY( cache.use( 0 ) );
+    QCOMPARE( cache.hits(), Q_INT64_C( 2 ) );
+    QCOMPARE( cache.misses(), Q_INT64_C( 1 ) );
+
+    // the pages go, the counters stay
+    cache.clear();
+    QCOMPARE( cache.hits(), Q_INT64_C( 2 ) );
+    cache.clearStatistics();
+    QCOMPARE( cache.hits(), Q_INT64_C( 0 ) );
+    QCOMPARE( cache.misses(), Q_INT64_C( 0 ) );
+}
+
+QTEST_KDEMAIN( TextPageCacheTest, GUI )
+
+#include "textpagecachetest.moc"
@@ -0,0 +1,391 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <kmimetype.h>
+
+#include "../core/area.h"
+#include "../core/document.h"
+#include "../core/page.h"
+#include "../core/textpage.h"
+#include "../settings_core.h"
+#include "textorderreference.h"
+
+// characters of a text heavy page, like a page of a novel
+#define LINES_PER_PAGE 50
+#define WORDS_PER_LINE 12
+
+class TextPageTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void testText();
+        void testFindText();
+        void testFindRegExp();
+        void testFindLoose();
+        void testCorrectTextOrder_data();
+        void testCorrectTextOrder();
+        void benchmarkAppend();
+        void benchmarkFindText();
+        void benchmarkFindTextRepetitive();
+        void benchmarkMemory();
+        void benchmarkCorrectTextOrder_data();
+        void benchmarkCorrectTextOrder();
+
+    private:
+        // appends the text one character at a time, the line breaks with the
+        // last character of the line, like the pdf generator
+        static Okular::TextPage *createPage( int seed );
+        static void appendText( Okular::TextPage *page, const QString &text, double top, double bottom );
+};
+
+void TextPageTest::appendText( Okular::TextPage *page, const QString &text, double top, double bottom )
+{
+    const double charWidth = 0.9 / qMax( text.length(), 80 );
+    for ( int i = 0; i < text.length(); ++i )
+    {
+        const double left = 0.05 + i * charWidth;
+        const bool lineEnd = i + 1 < text.length() && text.at( i + 1 ) == '\n';
+        page->append( text.mid( i, lineEnd ? 2 : 1 ), new Okular::NormalizedRect( left, top, left + charWidth, bottom ) );
+        if ( lineEnd )
+            ++i;
+    }
+}
+
+Okular::TextPage *TextPageTest::createPage( int seed )
+{
+    static const char * const words[] = { "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "and", "runs", "away", "again" };
+    const int wordCount = sizeof( words ) / sizeof( words[0] );
+
+    Okular::TextPage *page = new Okular::TextPage;
+    for ( int line = 0; line < LINES_PER_PAGE; ++line )
+    {
+        QString text;
+        for ( int word = 0; word < WORDS_PER_LINE; ++word )
+        {
+            if ( word > 0 )
+                text += ' ';
+            text += QLatin1String( words[ ( seed + line * 7 + word * 3 ) % wordCount ] );
+        }
+        text += '\n';
+        const double top = 0.05 + line * 0.9 / LINES_PER_PAGE;
+        appendText( page, text, top, top + 0.8 * 0.9 / LINES_PER_PAGE );
+    }
+    return page;
+}
+
+void TextPageTest::testText()
+{
+    Okular::TextPage page;
+    appendText( &page, "Hello world\n", 0.1, 0.2 );
+    appendText( &page, QString::fromUtf8( "e\xef\xac\x83" "cient\n" ), 0.3, 0.4 );
+
+    // the text is normalized when appended
+    QCOMPARE( page.text(), QString( "Hello world\nefficient\n" ) );
+
+    const Okular::RegularAreaRect firstLine = Okular::NormalizedRect( 0.0, 0.0, 1.0, 0.25 );
+    QCOMPARE( page.text( &firstLine ), QString( "Hello world\n" ) );
+
+    Okular::TextEntity::List words = page.words( &firstLine, Okular::TextPage::CentralPixelTextAreaInclusionBehaviour );
+    QCOMPARE( words.count(), 11 );
+    QCOMPARE( words.first()->text(), QString( "H" ) );
+    QVERIFY( qAbs( words.first()->area()->top - 0.1 ) < 1e-6 );
+    qDeleteAll( words );
+}
+
+void TextPageTest::testFindText()
+{
+    Okular::TextPage page;
+    appendText( &page, "one two one-\n", 0.1, 0.2 );
+    appendText( &page, "two\n", 0.3, 0.4 );
+
+    Okular::RegularAreaRect *match = page.findText( 0, "one", Okular::FromTop, Qt::CaseSensitive, 0 );
+    QVERIFY( match );
+    QVERIFY( match->first().left < 0.1 );
+    Okular::RegularAreaRect *next = page.findText( 0, "ONE", Okular::NextResult, Qt::CaseInsensitive, match );
+    QVERIFY( next );
+    QVERIFY( next->first().left > match->first().left );
+    delete match;
+    delete next;
+
+    // hyphenated at the end of the line
+    match = page.findText( 1, "onetwo", Okular::FromTop, Qt::CaseSensitive, 0 );
+    QVERIFY( match );
+    delete match;
+
+    match = page.findText( 2, "one", Okular::FromBottom, Qt::CaseSensitive, 0 );
+    QVERIFY( match );
+    QVERIFY( match->first().left > 0.1 );
+    delete match;
+
+    QVERIFY( !page.findText( 3, "three", Okular::FromTop, Qt::CaseSensitive, 0 ) );
+
+    // a match overlapping a partial one
+    Okular::TextPage numbers;
+    appendText( &numbers, "1121212\n", 0.1, 0.2 );
+    match = numbers.findText( 0, "1212", Okular::FromTop, Qt::CaseSensitive, 0 );
+    QVERIFY( match );
+    QVERIFY( qAbs( match->first().left - ( 0.05 + 0.9 / 80 ) ) < 1e-6 );
+    delete match;
+}
+
+void TextPageTest::testFindRegExp()
+{
+    Okular::TextPage page;
+    appendText( &page, "id 1234 id 42 pid 7 inter-\n", 0.1, 0.2 );
+    appendText( &page, "national\n", 0.3, 0.4 );
+
+    const QRegExp ids( "\\bid \\d+", Qt::CaseSensitive, QRegExp::RegExp2 );
+    Okular::RegularAreaRect *match = page.findText( 0, ids, Okular::FromTop, 0 );
+    QVERIFY( match );
+    QVERIFY( qAbs( match->first().left - 0.05 ) < 1e-6 );
+    Okular::RegularAreaRect *next = page.findText( 0, ids, Okular::NextResult, match );
+    QVERIFY( next );
+    QVERIFY( next->first().left > match->first().right );
+    delete match;
+    delete next;
+    // "pid 7" is not at a word boundary
+    QVERIFY( !page.findText( 0, ids, Okular::NextResult, 0 ) );
+
+    match = page.findText( 1, ids, Okular::FromBottom, 0 );
+    QVERIFY( match );
+    QVERIFY( qAbs( match->first().left - ( 0.05 + 8 * 0.9 / 80 ) ) < 1e-6 );
+    delete match;
+
+    // the text is searched without the hyphens at the end of the lines
+    match = page.findText( 2, QRegExp( "inter\\w+", Qt::CaseSensitive, QRegExp::RegExp2 ), Okular::FromTop, 0 );
+    QVERIFY( match );
+    bool firstLine = false, secondLine = false;
+    foreach ( const Okular::NormalizedRect &rect, *match )
+    {
+        firstLine = firstLine || rect.top < 0.25;
+        secondLine = secondLine || rect.top > 0.25;
+    }
+    QVERIFY( firstLine && secondLine );
+    delete match;
+
+    QVERIFY( !page.findText( 3, QRegExp( "ID" ), Okular::FromTop, 0 ) );
+    match = page.findText( 3, QRegExp( "ID", Qt::CaseInsensitive ), Okular::FromTop, 0 );
+    QVERIFY( match );
+    delete match;
+    // empty matches are not results
+    QVERIFY( !page.findText( 4, QRegExp( "x*" ), Okular::FromTop, 0 ) );
+}
+
+void TextPageTest::testFindLoose()
+{
+    Okular::TextPage page;
+    appendText( &page, QString::fromUtf8( "Cr\xc3\xa8me br\xc3\xbbl\xc3\xa9" "e, \xc5\x93uvre stra\xc3\x9f" "e\n" ), 0.1, 0.2 );
+
+    // the accents, the case and the ligatures are ignored
+    QVERIFY( !page.findText( 0, "creme brulee", Okular::FromTop, Qt::CaseInsensitive, 0 ) );
+    Okular::RegularAreaRect *match = page.findText( 0, "creme brulee", Okular::FromTop, Qt::CaseSensitive, Okular::TextPage::LooseComparison, 0 );
+    QVERIFY( match );
+    QVERIFY( qAbs( match->first().left - 0.05 ) < 1e-6 );
+    delete match;
+    match = page.findText( 1, QString::fromUtf8( "OEUVRE STRASSE" ), Okular::FromTop, Qt::CaseSensitive, Okular::TextPage::LooseComparison, 0 );
+    QVERIFY( match );
+    // the match covers the whole ligature
+    QVERIFY( qAbs( match->first().left - ( 0.05 + 14 * 0.9 / 80 ) ) < 1e-6 );
+    delete match;
+
+    // one character different, missing or extra
+    QVERIFY( !page.findText( 2, "creme brolee", Okular::FromTop, Qt::CaseSensitive, Okular::TextPage::LooseComparison, 0 ) );
+    foreach ( const QString &query, QStringList() << "creme brolee" << "creme brlee" << "creme bruulee" )
+    {
+        match = page.findText( 2, query, Okular::FromTop, Qt::CaseSensitive, Okular::TextPage::ApproximateComparison, 0 );
+        QVERIFY( match );
+        QVERIFY( qAbs( match->first().left - 0.05 ) < 1e-6 );
+        delete match;
+    }
+    QVERIFY( !page.findText( 3, "crime brolee", Okular::FromTop, Qt::CaseSensitive, Okular::TextPage::ApproximateComparison, 0 ) );
+    // going backwards, the exact match wins over the truncated one after it
+    match = page.findText( 3, "creme brulee", Okular::FromBottom, Qt::CaseSensitive, Okular::TextPage::ApproximateComparison, 0 );
+    QVERIFY( match );
+    QVERIFY( qAbs( match->first().left - 0.05 ) < 1e-6 );
+    delete match;
+
+    // in both directions, an exact match wins over an approximate one
+    // overlapping it
+    Okular::TextPage doubled;
+    appendText( &doubled, "hhello hello\n", 0.1, 0.2 );
+    const double charWidth = 0.9 / 80;
+    match = doubled.findText( 5, "hello", Okular::FromTop, Qt::CaseSensitive, Okular::TextPage::ApproximateComparison, 0 );
+    QVERIFY( match );
+    QVERIFY( qAbs( match->first().left - ( 0.05 + charWidth ) ) < 1e-6 );
+    delete match;
+    match = doubled.findText( 5, "hello", Okular::FromBottom, Qt::CaseSensitive, Okular::TextPage::ApproximateComparison, 0 );
+    QVERIFY( match );
+    QVERIFY( qAbs( match->first().left - ( 0.05 + 7 * charWidth ) ) < 1e-6 );
+    delete match;
+    Okular::TextPage single;
+    appendText( &single, "hhello\n", 0.1, 0.2 );
+    match = single.findText( 6, "hello", Okular::FromBottom, Qt::CaseSensitive, Okular::TextPage::ApproximateComparison, 0 );
+    QVERIFY( match );
+    QVERIFY( qAbs( match->first().left - ( 0.05 + charWidth ) ) < 1e-6 );
+    delete match;
+
+    // the next match is after the previous one in the loose text as well
+    Okular::TextPage repeated;
+    appendText( &repeated, QString::fromUtf8( "\xc3\xa9t\xc3\xa9 et \xc3\xa9t\xc3\xa9\n" ), 0.1, 0.2 );
+    match = repeated.findText( 4, "ete", Okular::FromTop, Qt::CaseSensitive, Okular::TextPage::LooseComparison, 0 );
+    QVERIFY( match );
+    Okular::RegularAreaRect *next = repeated.findText( 4, "ete", Okular::NextResult, Qt::CaseSensitive, Okular::TextPage::LooseComparison, match );
+    QVERIFY( next );
+    QVERIFY( next->first().left > match->first().right );
+    delete match;
+    QVERIFY( !repeated.findText( 4, "ete", Okular::NextResult, Qt::CaseSensitive, Okular::TextPage::LooseComparison, next ) );
+    delete next;
+}
+
+void TextPageTest::benchmarkAppend()
+{
+    QBENCHMARK {
+        delete createPage( 0 );
+    }
+}
+
+void TextPageTest::benchmarkFindText()
+{
+    Okular::TextPage *page = createPage( 0 );
+    QBENCHMARK {
+        // a text that is not in the page: the whole page is walked
+        QVERIFY( !page->findText( 0, "quick fox", Okular::FromTop, Qt::CaseInsensitive, 0 ) );
+    }
+    delete page;
+}
+
+void TextPageTest::benchmarkFindTextRepetitive()
+{
+    // a table of numbers, where most of the positions are a partial match
+    Okular::TextPage page;
+    const QString line = QString( 79, '1' ) + '\n';
+    for ( int i = 0; i < LINES_PER_PAGE; ++i )
+        appendText( &page, line, i * 0.02, i * 0.02 + 0.01 );
+    const QString query = QString( 40, '1' ) + '2';
+    QBENCHMARK {
+        QVERIFY( !page.findText( 0, query, Okular::FromTop, Qt::CaseSensitive, 0 ) );
+    }
+}
+
+void TextPageTest::benchmarkMemory()
+{
+#ifdef __GLIBC__
+    const int pageCount = 100;
+    QList< Okular::TextPage * > pages;
+    const int before = mallinfo().uordblks;
+    for ( int i = 0; i < pageCount; ++i )
+        pages.append( createPage( i ) );
+    const int after = mallinfo().uordblks;
+    const int entities = pageCount * ( pages.first()->text().length() - LINES_PER_PAGE );
+    qDebug() << "Memory of" << pageCount << "text pages:" << ( after - before ) / 1024 << "KiB,"
+             << ( after - before ) / entities << "bytes per text entity";
+    qDeleteAll( pages );
+#else
+    QSKIP( "Measuring the memory needs glibc", SkipAll );
+#endif
+}
+
+void TextPageTest::testCorrectTextOrder_data()
+{
+    benchmarkCorrectTextOrder_data();
+}
+
+void TextPageTest::testCorrectTextOrder()
+{
+    QFETCH( QString, file );
+
+    Okular::SettingsCore::instance( "textpagetest" );
+    Okular::Document document( 0 );
+    const KMimeType::Ptr mime = KMimeType::findByPath( file );
+    if ( !document.openDocument( file, KUrl(), mime ) )
+        QSKIP( "The document cannot be opened, is the pdf generator installed?", SkipSingle );
+
+    // the same text ordered again, by the current ordering and by the one
+    // it replaced
+    for ( uint i = 0; i < document.pages(); ++i )
+    {
+        document.requestTextPage( i );
+        const Okular::Page *documentPage = document.page( i );
+        const Okular::TextEntity::List text = documentPage->words( 0, Okular::TextPage::AnyPixelTextAreaInclusionBehaviour );
+
+        Okular::Page page( i, documentPage->width(), documentPage->height(), Okular::Rotation0 );
+        const QList< TextOrderReference::Entity > expected = TextOrderReference::correctTextOrder( text, (int)page.width(), (int)page.height(), page.boundingBox() );
+
+        Okular::TextEntity::List words;
+        foreach ( const Okular::TextEntity *word, text )
+            words.append( new Okular::TextEntity( word->text(), new Okular::NormalizedRect( *word->area() ) ) );
+        qDeleteAll( text );
+        page.setTextPage( new Okular::TextPage( words ) );
+
+        const Okular::TextEntity::List ordered = page.words( 0, Okular::TextPage::AnyPixelTextAreaInclusionBehaviour );
+        QCOMPARE( ordered.count(), expected.count() );
+        for ( int j = 0; j < ordered.count(); ++j )
+        {
+            QCOMPARE( ordered.at( j )->text(), expected.at( j ).first );
+            QVERIFY( *ordered.at( j )->area() == expected.at( j ).second );
+        }
+        qDeleteAll( ordered );
+    }
+}
+
+void TextPageTest::benchmarkCorrectTextOrder_data()
+{
+    QTest::addColumn< QString >( "file" );
+    QTest::newRow( "file1.pdf" ) << KDESRCDIR "data/file1.pdf";
+    QTest::newRow( "tocreload.pdf" ) << KDESRCDIR "data/tocreload.pdf";
+}
+
+void TextPageTest::benchmarkCorrectTextOrder()
+{
+    QFETCH( QString, file );
+
+    Okular::SettingsCore::instance( "textpagetest" );
+    Okular::Document document( 0 );
+    const KMimeType::Ptr mime = KMimeType::findByPath( file );
+    if ( !document.openDocument( file, KUrl(), mime ) )
+        QSKIP( "The document cannot be opened, is the pdf generator installed?", SkipSingle );
+
+    // the text of the pages as the generator extracts it, on pages of the same size
+    QList< Okular::Page * > pages;
+    QList< Okular::TextEntity::List > texts;
+    for ( uint i = 0; i < document.pages(); ++i )
+    {
+        document.requestTextPage( i );
+        const Okular::Page *page = document.page( i );
+        pages.append( new Okular::Page( i, page->width(), page->height(), Okular::Rotation0 ) );
+        texts.append( page->words( 0, Okular::TextPage::AnyPixelTextAreaInclusionBehaviour ) );
+    }
+    document.closeDocument();
+
+    QBENCHMARK {
+        // setting the text of a page orders it
+        for ( int i = 0; i < pages.count(); ++i )
+        {
+            Okular::TextEntity::List words;
+            foreach ( const Okular::TextEntity *word, texts.at( i ) )
+                words.append( new Okular::TextEntity( word->text(), new Okular::NormalizedRect( *word->area() ) ) );
+            pages.at( i )->setTextPage( new Okular::TextPage( words ) );
+        }
+    }
+
+    for ( int i = 0; i < texts.count(); ++i )
+        qDeleteAll( texts.at( i ) );
+    qDeleteAll( pages );
+}
+
+QTEST_KDEMAIN( TextPageTest, GUI )
+
+#include "textpagetest.moc"
@@ -0,0 +1,66 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by the Okular developers                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include <QtGui/QPixmap>
+
+#include "../core/tile.h"
+#include "../core/tilesmanager_p.h"
+
+class TilesManagerTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void testCompressTiles();
+};
+
+void TilesManagerTest::testCompressTiles()
+{
+    const Okular::NormalizedRect page( 0, 0, 1, 1 );
+    const Okular::NormalizedRect visibleRect( 0, 0, 0.1, 0.1 );
+    Okular::TilesManager tm( 0, 1000, 1000 );
+    tm.addRequest( page, 1000, 1000 );
+
+    QPixmap pixmap( 1000, 1000 );
+    pixmap.fill( Qt::white );
+    tm.setPixmap( &pixmap, page );
+    QCOMPARE( tm.totalMemory(), (qulonglong)4 * 1000 * 1000 );
+
+    // blank tiles compress very well and are still available
+    tm.cleanupPixmapMemory( 4 * 1000 * 1000, visibleRect, 0, true );
+    QVERIFY( tm.totalMemory() < 1000 * 1000 );
+    QVERIFY( tm.hasPixmap( page ) );
+
+    // only the visible tile, which was not compressed, can be painted
+    QCOMPARE( tm.tilesAt( page, Okular::TilesManager::PixmapTile ).count(), 1 );
+
+    // decompressing them gives the pixmaps back
+    QVERIFY( tm.decompressTiles( page ) );
+    QVERIFY( !tm.decompressTiles( page ) );
+    const QList<Okular::Tile> tiles = tm.tilesAt( page, Okular::TilesManager::PixmapTile );
+    QCOMPARE( tiles.count(), 16 );
+    foreach ( const Okular::Tile &tile, tiles )
+    {
+        QVERIFY( tile.isValid() );
+        QCOMPARE( tile.pixmap()->toImage().pixel( 0, 0 ), QColor( Qt::white ).rgb() );
+    }
+    QCOMPARE( tm.totalMemory(), (qulonglong)4 * 1000 * 1000 );
+
+    // without compression the tiles out of the visible area are discarded
+    tm.cleanupPixmapMemory( 4 * 1000 * 1000, visibleRect, 0, false );
+    QCOMPARE( tm.totalMemory(), (qulonglong)4 * 250 * 250 );
+    QVERIFY( tm.hasPixmap( visibleRect ) );
+    QVERIFY( !tm.hasPixmap( page ) );
+}
+
+QTEST_KDEMAIN( TilesManagerTest, GUI )
+
+#include "tilesmanagertest.moc"
@@ -274,7 +274,10 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
             else
             {
                 QImage destImage;
-                scalePixmapOnImage( destImage, pixmap, scaledWidth, scaledHeight, limitsInPixmap );
+                if ( pixmap->width() * 2 <= scaledWidth )
+                    smoothScalePixmapOnImage( destImage, pixmap, scaledWidth, scaledHeight, limitsInPixmap );
+                else
+                    scalePixmapOnImage( destImage, pixmap, scaledWidth, scaledHeight, limitsInPixmap );
                 destPainter->drawImage( limits.left(), limits.top(), destImage, 0, 0,
                                          limits.width(),limits.height() );
             }
@@ -336,6 +339,8 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
             // 4B.1. draw the page pixmap: normal or scaled
             if ( pixmap->width() == scaledWidth && pixmap->height() == scaledHeight )
                 cropPixmapOnImage( backImage, pixmap, limitsInPixmap );
+            else if ( pixmap->width() * 2 <= scaledWidth )
+                smoothScalePixmapOnImage( backImage, pixmap, scaledWidth, scaledHeight, limitsInPixmap );
             else
                 scalePixmapOnImage( backImage, pixmap, scaledWidth, scaledHeight, limitsInPixmap );
         }
@@ -900,6 +905,22 @@ void PagePainter::scalePixmapOnImage ( QImage & dest, const QPixmap * src,
     }
 }
 
+void PagePainter::smoothScalePixmapOnImage( QImage & dest, const QPixmap * src,
+    int scaledWidth, int scaledHeight, const QRect & cropRect )
+{
+    // the portion of the source pixmap that ends up in the destination
+    const double xScale = (double)src->width() / (double)scaledWidth,
+                 yScale = (double)src->height() / (double)scaledHeight;
+    const QRectF srcRect( cropRect.left() * xScale, cropRect.top() * yScale,
+                          cropRect.width() * xScale, cropRect.height() * yScale );
+
+    dest = QImage( cropRect.width(), cropRect.height(), QImage::Format_ARGB32_Premultiplied );
+    dest.fill( 0 );
+    QPainter p( &dest );
+    p.setRenderHint( QPainter::SmoothPixmapTransform );
+    p.drawPixmap( QRectF( 0, 0, cropRect.width(), cropRect.height() ), *src, srcRect );
+}
+
 /** Private Helpers :: Image Drawing **/
 // from Arthur - qt4
 inline int qt_div_255(int x) { return (x + (x>>8) + 0x80) >> 8; }
@@ -61,6 +61,12 @@ class PagePainter
         static void scalePixmapOnImage( QImage & dest, const QPixmap *src,
             int scaledWidth, int scaledHeight, const QRect & cropRect, QImage::Format format = QImage::Format_ARGB32_Premultiplied );
 
+        // like scalePixmapOnImage, but interpolating the pixels: used when
+        // magnifying a low resolution pixmap, that is shown while the right
+        // one is rendered and would look blocky otherwise
+        static void smoothScalePixmapOnImage( QImage & dest, const QPixmap *src,
+            int scaledWidth, int scaledHeight, const QRect & cropRect );
+
         // set the alpha component of the image to a given value
         static void changeImageAlpha( QImage & image, unsigned int alpha );
 
@@ -153,6 +153,8 @@ public:
     double lastSourceLocationViewportNormalizedX;
     double lastSourceLocationViewportNormalizedY;
     QTimer * viewportMoveTimer;
+    // origin of the viewport at the last pixmap request, for the scroll direction
+    QPoint lastRequestViewportOrigin;
     // auto scroll
     int scrollIncrement;
     QTimer * autoScrollTimer;
@@ -287,6 +289,7 @@ PageView::PageView( QWidget *parent, Okular::Document *document )
     d->viewportMoveTimer = 0;
     d->scrollIncrement = 0;
     d->autoScrollTimer = 0;
+    d->lastRequestViewportOrigin = QPoint( 0, 0 );
     d->annotator = 0;
     d->dirtyLayout = false;
     d->blockViewport = false;
@@ -883,30 +886,7 @@ void PageView::notifySetup( const QVector< Okular::Page * > & pageSet, int setup
                 hasformwidgets = true;
             }
         }
-        const QLinkedList< Okular::Annotation * > annotations = (*setIt)->annotations();
-        QLinkedList< Okular::Annotation * >::const_iterator aIt = annotations.constBegin(), aEnd = annotations.constEnd();
-        for ( ; aIt != aEnd; ++aIt )
-        {
-            Okular::Annotation * a = *aIt;
-            if ( a->subType() == Okular::Annotation::AMovie )
-            {
-                Okular::MovieAnnotation * movieAnn = static_cast< Okular::MovieAnnotation * >( a );
-                VideoWidget * vw = new VideoWidget( movieAnn, movieAnn->movie(), d->document, viewport() );
-                item->videoWidgets().insert( movieAnn->movie(), vw );
-                vw->pageInitialized();
-            }
-            else if ( a->subType() == Okular::Annotation::AScreen )
-            {
-                const Okular::ScreenAnnotation * screenAnn = static_cast< Okular::ScreenAnnotation * >( a );
-                Okular::Movie *movie = GuiUtils::renditionMovieFromScreenAnnotation( screenAnn );
-                if ( movie )
-                {
-                    VideoWidget * vw = new VideoWidget( screenAnn, movie, d->document, viewport() );
-                    item->videoWidgets().insert( movie, vw );
-                    vw->pageInitialized();
-                }
-            }
-        }
+        createVideoWidgets( item );
     }
 
     // invalidate layout so relayout/repaint will happen on next viewport change
@@ -1198,6 +1178,14 @@ void PageView::notifyPageChanged( int pageNumber, int changedFlags )
                 delete w;
             }
         }
+
+        // the annotations of the page may have been loaded after the setup
+        PageViewItem * item = d->items.value( pageNumber );
+        if ( item && createVideoWidgets( item ) )
+        {
+            d->dirtyLayout = true;
+            QMetaObject::invokeMethod(this, "slotRelayoutPages", Qt::QueuedConnection);
+        }
     }
 
     if ( changedFlags & DocumentObserver::BoundingBox )
@@ -1236,6 +1224,40 @@ void PageView::notifyPageChanged( int pageNumber, int changedFlags )
         }
 }
 
+bool PageView::createVideoWidgets( PageViewItem * item )
+{
+    bool created = false;
+    const QLinkedList< Okular::Annotation * > annotations = item->page()->annotations();
+    QLinkedList< Okular::Annotation * >::const_iterator aIt = annotations.constBegin(), aEnd = annotations.constEnd();
+    for ( ; aIt != aEnd; ++aIt )
+    {
+        Okular::Annotation * a = *aIt;
+        if ( a->subType() == Okular::Annotation::AMovie )
+        {
+            Okular::MovieAnnotation * movieAnn = static_cast< Okular::MovieAnnotation * >( a );
+            if ( item->videoWidgets().contains( movieAnn->movie() ) )
+                continue;
+            VideoWidget * vw = new VideoWidget( movieAnn, movieAnn->movie(), d->document, viewport() );
+            item->videoWidgets().insert( movieAnn->movie(), vw );
+            vw->pageInitialized();
+            created = true;
+        }
+        else if ( a->subType() == Okular::Annotation::AScreen )
+        {
+            const Okular::ScreenAnnotation * screenAnn = static_cast< Okular::ScreenAnnotation * >( a );
+            Okular::Movie *movie = GuiUtils::renditionMovieFromScreenAnnotation( screenAnn );
+            if ( movie && !item->videoWidgets().contains( movie ) )
+            {
+                VideoWidget * vw = new VideoWidget( screenAnn, movie, d->document, viewport() );
+                item->videoWidgets().insert( movie, vw );
+                vw->pageInitialized();
+                created = true;
+            }
+        }
+    }
+    return created;
+}
+
 void PageView::notifyContentsCleared( int changedFlags )
 {
     // if pixmaps were cleared, re-ask them
@@ -4081,6 +4103,14 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
                               viewport()->width(), viewport()->height() );
     const QRect viewportRectAtZeroZero( 0, 0, viewport()->width(), viewport()->height() );
 
+    // direction of the scrolling since the last time, along the dominant axis
+    QPoint scrollDirection = viewportRect.topLeft() - d->lastRequestViewportOrigin;
+    if ( qAbs( scrollDirection.x() ) > qAbs( scrollDirection.y() ) )
+        scrollDirection = QPoint( scrollDirection.x() > 0 ? 1 : -1, 0 );
+    else if ( scrollDirection.y() != 0 )
+        scrollDirection = QPoint( 0, scrollDirection.y() > 0 ? 1 : -1 );
+    d->lastRequestViewportOrigin = viewportRect.topLeft();
+
     // some variables used to determine the viewport
     int nearPageNumber = -1;
     const double viewportCenterX = (viewportRect.left() + viewportRect.right()) / 2.0;
@@ -4169,6 +4199,30 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
                 p->setNormalizedRect( vItem->rect );
         }
 
+        // prefetch the tiles the user is scrolling to, one screen ahead
+        if ( i->page()->hasTilesManager() && !scrollDirection.isNull() &&
+             Okular::Settings::memoryLevel() != Okular::Settings::EnumMemoryLevel::Low )
+        {
+            Okular::NormalizedRect prefetchRect = expandedVisibleRect;
+            const double dx = scrollDirection.x() * ( vItem->rect.right - vItem->rect.left );
+            const double dy = scrollDirection.y() * ( vItem->rect.bottom - vItem->rect.top );
+            prefetchRect.left = qBound( 0.0, prefetchRect.left + dx, 1.0 );
+            prefetchRect.right = qBound( 0.0, prefetchRect.right + dx, 1.0 );
+            prefetchRect.top = qBound( 0.0, prefetchRect.top + dy, 1.0 );
+            prefetchRect.bottom = qBound( 0.0, prefetchRect.bottom + dy, 1.0 );
+
+            if ( prefetchRect.right > prefetchRect.left && prefetchRect.bottom > prefetchRect.top &&
+                 !i->page()->hasPixmap( this, i->uncroppedWidth(), i->uncroppedHeight(), prefetchRect ) )
+            {
+                Okular::PixmapRequest::PixmapRequestFeatures requestFeatures = Okular::PixmapRequest::Preload;
+                requestFeatures |= Okular::PixmapRequest::Asynchronous;
+                Okular::PixmapRequest * p = new Okular::PixmapRequest( this, i->pageNumber(), i->uncroppedWidth(), i->uncroppedHeight(), PAGEVIEW_PRELOAD_PRIO, requestFeatures );
+                p->setNormalizedRect( prefetchRect );
+                p->setTile( true );
+                requestedPixmaps.push_back( p );
+            }
+        }
+
         // look for the item closest to viewport center and the relative
         // position between the item and the viewport center
         if ( isEvent )
@@ -4229,7 +4283,7 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
     // send requests to the document
     if ( !requestedPixmaps.isEmpty() )
     {
-        d->document->requestPixmaps( requestedPixmaps );
+        d->document->requestPixmaps( requestedPixmaps, Okular::Document::RemoveAllPrevious | Okular::Document::LowResolutionFirst );
     }
     // if this functions was invoked by viewport events, send update to document
     if ( isEvent && nearPageNumber != -1 )
@@ -189,6 +189,8 @@ Q_OBJECT
         void scrollTo( int x, int y );
 
         void toggleFormWidgets( bool on );
+        // create the widgets of the movies of the item's page not having one yet
+        bool createVideoWidgets( PageViewItem * item );
 
         void resizeContentArea( const QSize & newSize );
         void updatePageStep();
@@ -374,6 +374,11 @@ void PresentationWidget::notifyPageChanged( int pageNumber, int changedFlags )
     // check if it's the last requested pixmap. if so update the widget.
     if ( (changedFlags & ( DocumentObserver::Pixmap | DocumentObserver::Annotations | DocumentObserver::Highlights ) ) && pageNumber == m_frameIndex )
         generatePage( changedFlags & ( DocumentObserver::Annotations | DocumentObserver::Highlights ) );
+
+    // the generator may give the actions and the annotations of the page
+    // after the page is shown
+    if ( ( changedFlags & DocumentObserver::Annotations ) && pageNumber == m_frameIndex )
+        performPageOpeningActions();
 }
 
 void PresentationWidget::notifyCurrentPageChanged( int previousPage, int currentPage )
@@ -435,23 +440,9 @@ void PresentationWidget::notifyCurrentPageChanged( int previousPage, int current
             generatePage();
         }
 
-        // perform the page opening action, if any
-        if ( m_document->page( m_frameIndex )->pageAction( Okular::Page::Opening ) )
-            m_document->processAction( m_document->page( m_frameIndex )->pageAction( Okular::Page::Opening ) );
-
-        // perform the additional actions of the page's annotations, if any
-        Q_FOREACH ( const Okular::Annotation *annotation, m_document->page( m_frameIndex )->annotations() )
-        {
-            Okular::Action *action = 0;
-
-            if ( annotation->subType() == Okular::Annotation::AScreen )
-                action = static_cast<const Okular::ScreenAnnotation*>( annotation )->additionalAction( Okular::Annotation::PageOpening );
-            else if ( annotation->subType() == Okular::Annotation::AWidget )
-                action = static_cast<const Okular::WidgetAnnotation*>( annotation )->additionalAction( Okular::Annotation::PageOpening );
-
-            if ( action )
-                m_document->processAction( action );
-        }
+        // perform the page opening actions, if any
+        m_performedOpeningActions.clear();
+        performPageOpeningActions();
 
         // start autoplay video playback
         Q_FOREACH ( VideoWidget *vw, m_frames[ m_frameIndex ]->videoWidgets )
@@ -459,6 +450,32 @@ void PresentationWidget::notifyCurrentPageChanged( int previousPage, int current
     }
 }
 
+void PresentationWidget::performPageOpeningActions()
+{
+    const Okular::Page *page = m_document->page( m_frameIndex );
+    QList< const Okular::Action * > actions;
+    actions.append( page->pageAction( Okular::Page::Opening ) );
+
+    // the additional actions of the page's annotations
+    Q_FOREACH ( const Okular::Annotation *annotation, page->annotations() )
+    {
+        if ( annotation->subType() == Okular::Annotation::AScreen )
+            actions.append( static_cast<const Okular::ScreenAnnotation*>( annotation )->additionalAction( Okular::Annotation::PageOpening ) );
+        else if ( annotation->subType() == Okular::Annotation::AWidget )
+            actions.append( static_cast<const Okular::WidgetAnnotation*>( annotation )->additionalAction( Okular::Annotation::PageOpening ) );
+    }
+
+    // only once each, even if the page is notified again
+    Q_FOREACH ( const Okular::Action *action, actions )
+    {
+        if ( action && !m_performedOpeningActions.contains( action ) )
+        {
+            m_performedOpeningActions.insert( action );
+            m_document->processAction( action );
+        }
+    }
+}
+
 bool PresentationWidget::canUnloadPixmap( int pageNumber ) const
 {
     if ( Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Low ||
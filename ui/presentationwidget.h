@@ -12,6 +12,7 @@
 
 #include <qlist.h>
 #include <qpixmap.h>
+#include <qset.h>
 #include <qstringlist.h>
 #include <qwidget.h>
 #include "core/area.h"
@@ -89,6 +90,7 @@ class PresentationWidget : public QWidget, public Okular::DocumentObserver
         void recalcGeometry();
         void repositionContent();
         void requestPixmaps();
+        void performPageOpeningActions();
         void setScreen( int );
         void applyNewScreenSize( const QSize & oldSize );
         void inhibitPowerManagement();
@@ -124,6 +126,8 @@ class PresentationWidget : public QWidget, public Okular::DocumentObserver
         Okular::Document * m_document;
         QVector< PresentationFrame * > m_frames;
         int m_frameIndex;
+        // the opening actions of the current page already performed
+        QSet< const Okular::Action * > m_performedOpeningActions;
         QStringList m_metaStrings;
         QToolBar * m_topBar;
         QLineEdit *m_pagesEdit;
@@ -40,6 +40,7 @@ SearchLineEdit::SearchLineEdit( QWidget * parent, Okular::Document * document )
     connect(this, SIGNAL(textChanged(QString)), this, SLOT(slotTextChanged(QString)));
     connect(this, SIGNAL(returnPressed(QString)), this, SLOT(slotReturnPressed(QString)));
     connect(document, SIGNAL(searchFinished(int,Okular::Document::SearchStatus)), this, SLOT(searchFinished(int,Okular::Document::SearchStatus)));
+    connect(document, SIGNAL(searchMatchesFound(int,int,int,int)), this, SLOT(searchMatchesFound(int,int,int,int)));
 }
 
 void SearchLineEdit::clearText()
@@ -246,6 +247,18 @@ void SearchLineEdit::searchFinished( int id, Okular::Document::SearchStatus endS
     emit searchStopped();
 }
 
+void SearchLineEdit::searchMatchesFound( int id, int page, int pageMatches, int totalMatches )
+{
+    Q_UNUSED( page )
+    Q_UNUSED( pageMatches )
+
+    // ignore the searches not started by this search edit
+    if ( id != m_id )
+        return;
+
+    emit matchesFound( totalMatches );
+}
+
 
 SearchLineWidget::SearchLineWidget( QWidget * parent, Okular::Document * document )
     : QWidget( parent )
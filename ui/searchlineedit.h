@@ -43,6 +43,10 @@ class SearchLineEdit : public KLineEdit
     signals:
         void searchStarted();
         void searchStopped();
+        /**
+         * The search in the whole document found @p totalMatches matches so far.
+         */
+        void matchesFound( int totalMatches );
 
     public slots:
         void restartSearch();
@@ -70,6 +74,7 @@ class SearchLineEdit : public KLineEdit
         void slotReturnPressed( const QString &text );
         void startSearch();
         void searchFinished( int id, Okular::Document::SearchStatus endStatus );
+        void searchMatchesFound( int id, int page, int pageMatches, int totalMatches );
 };
 
 class SearchLineWidget : public QWidget
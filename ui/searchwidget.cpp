@@ -13,6 +13,7 @@
 #include <qlayout.h>
 #include <qmenu.h>
 #include <qaction.h>
+#include <qlabel.h>
 #include <qsizepolicy.h>
 #include <qtoolbutton.h>
 #include <kicon.h>
@@ -22,7 +23,7 @@
 #include "searchlineedit.h"
 
 SearchWidget::SearchWidget( QWidget * parent, Okular::Document * document )
-    : QWidget( parent )
+    : QWidget( parent ), m_matchCount( 0 )
 {
     setObjectName( QLatin1String( "iSearchBar" ) );
 
@@ -44,6 +45,14 @@ SearchWidget::SearchWidget( QWidget * parent, Okular::Document * document )
     m_lineEdit->setSearchId( SW_SEARCH_ID );
     m_lineEdit->setSearchColor( qRgb( 0, 183, 255 ) );
     mainlay->addWidget( m_lineEdit );
+    connect( m_lineEdit, SIGNAL(searchStarted()), SLOT(slotSearchStarted()) );
+    connect( m_lineEdit, SIGNAL(matchesFound(int)), SLOT(slotMatchesFound(int)) );
+    connect( m_lineEdit, SIGNAL(searchStopped()), SLOT(slotSearchStopped()) );
+    connect( m_lineEdit, SIGNAL(textChanged(QString)), SLOT(slotTextChanged()) );
+
+    // the number of matches, updated while the document is searched
+    m_matchesLabel = new QLabel( this );
+    mainlay->addWidget( m_matchesLabel );
 
     // 3.1. create the popup menu for changing filtering features
     m_menu = new QMenu( this );
@@ -52,6 +61,10 @@ SearchWidget::SearchWidget( QWidget * parent, Okular::Document * document )
     m_matchPhraseAction = m_menu->addAction( i18n("Match Phrase") );
     m_marchAllWordsAction = m_menu->addAction( i18n("Match All Words") );
     m_marchAnyWordsAction = m_menu->addAction( i18n("Match Any Word") );
+    m_matchWholeWordsAction = m_menu->addAction( i18n("Match Whole Words") );
+    m_regularExpressionAction = m_menu->addAction( i18n("Regular Expression") );
+    m_ignoreAccentsAction = m_menu->addAction( i18n("Ignore Accents") );
+    m_approximateAction = m_menu->addAction( i18n("Approximate Match") );
 
     m_caseSensitiveAction->setCheckable( true );
     QActionGroup *actgrp = new QActionGroup( this );
@@ -61,6 +74,14 @@ SearchWidget::SearchWidget( QWidget * parent, Okular::Document * document )
     m_marchAllWordsAction->setActionGroup( actgrp );
     m_marchAnyWordsAction->setCheckable( true );
     m_marchAnyWordsAction->setActionGroup( actgrp );
+    m_matchWholeWordsAction->setCheckable( true );
+    m_matchWholeWordsAction->setActionGroup( actgrp );
+    m_regularExpressionAction->setCheckable( true );
+    m_regularExpressionAction->setActionGroup( actgrp );
+    m_ignoreAccentsAction->setCheckable( true );
+    m_ignoreAccentsAction->setActionGroup( actgrp );
+    m_approximateAction->setCheckable( true );
+    m_approximateAction->setActionGroup( actgrp );
 
     m_marchAllWordsAction->setChecked( true );
     connect( m_menu, SIGNAL(triggered(QAction*)), SLOT(slotMenuChaged(QAction*)) );
@@ -99,6 +120,22 @@ void SearchWidget::slotMenuChaged( QAction * act )
     {
         m_lineEdit->setSearchType( Okular::Document::GoogleAny );
     }
+    else if ( act == m_matchWholeWordsAction )
+    {
+        m_lineEdit->setSearchType( Okular::Document::WholeWords );
+    }
+    else if ( act == m_regularExpressionAction )
+    {
+        m_lineEdit->setSearchType( Okular::Document::RegularExpression );
+    }
+    else if ( act == m_ignoreAccentsAction )
+    {
+        m_lineEdit->setSearchType( Okular::Document::IgnoreAccents );
+    }
+    else if ( act == m_approximateAction )
+    {
+        m_lineEdit->setSearchType( Okular::Document::Approximate );
+    }
     else
         return;
 
@@ -106,4 +143,31 @@ void SearchWidget::slotMenuChaged( QAction * act )
     m_lineEdit->restartSearch();
 }
 
+void SearchWidget::slotSearchStarted()
+{
+    m_matchCount = 0;
+    m_matchesLabel->clear();
+}
+
+void SearchWidget::slotMatchesFound( int totalMatches )
+{
+    m_matchCount = totalMatches;
+    m_matchesLabel->setText( i18np( "%1 match so far", "%1 matches so far", totalMatches ) );
+}
+
+void SearchWidget::slotSearchStopped()
+{
+    if ( m_matchCount > 0 )
+        m_matchesLabel->setText( i18np( "%1 match", "%1 matches", m_matchCount ) );
+    else
+        m_matchesLabel->clear();
+}
+
+void SearchWidget::slotTextChanged()
+{
+    // the matches are the ones of the previous text
+    m_matchCount = 0;
+    m_matchesLabel->clear();
+}
+
 #include "searchwidget.moc"
@@ -17,6 +17,7 @@ class Document;
 }
 
 class QAction;
+class QLabel;
 class QMenu;
 
 class SearchLineEdit;
@@ -39,10 +40,18 @@ class SearchWidget : public QWidget
     private:
         QMenu * m_menu;
         QAction *m_matchPhraseAction, *m_caseSensitiveAction, * m_marchAllWordsAction, *m_marchAnyWordsAction;
+        QAction *m_matchWholeWordsAction, *m_regularExpressionAction;
+        QAction *m_ignoreAccentsAction, *m_approximateAction;
         SearchLineEdit *m_lineEdit;
+        QLabel *m_matchesLabel;
+        int m_matchCount;
 
     private slots:
         void slotMenuChaged( QAction * );
+        void slotSearchStarted();
+        void slotMatchesFound( int totalMatches );
+        void slotSearchStopped();
+        void slotTextChanged();
 };
 
 #endif